@@ -0,0 +1,148 @@
+#include <cmath>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+
+#include "bench.hpp"
+
+namespace bench
+{
+
+namespace
+{
+
+volatile long sink = 0;
+
+}
+
+void Sink(long value)
+{
+    sink = sink + value;
+}
+
+void Summarize(Result& r)
+{
+    if(r.samples.empty())
+    {
+        return;
+    }
+    std::vector<double> s = r.samples;
+    std::sort(s.begin(), s.end());
+    const size_t n = s.size();
+
+    r.min = s[0];
+    r.median = n % 2 == 1 ? s[n / 2] : 0.5 * (s[n / 2 - 1] + s[n / 2]);
+    const size_t rank = size_t(std::ceil(0.95 * double(n)));
+    r.p95 = s[std::min(n, std::max(rank, size_t(1))) - 1];
+
+    double sum = 0;
+    for(double x : s)
+    {
+        sum += x;
+    }
+    r.mean = sum / double(n);
+    double squares = 0;
+    for(double x : s)
+    {
+        squares += (x - r.mean) * (x - r.mean);
+    }
+    r.stddev = n > 1 ? std::sqrt(squares / double(n - 1)) : 0.0;
+}
+
+Result Run(const std::string& name, int ops, const Options& options,
+           const std::function<void(int)>& body)
+{
+    Result r;
+    r.name = name;
+    r.ops = std::max(1, ops);
+    for(int k = 0; k < options.warmUp; k++)
+    {
+        body(r.ops);
+    }
+    r.samples.reserve(options.samples);
+    for(int k = 0; k < options.samples; k++)
+    {
+        auto t1 = std::chrono::steady_clock::now();
+        body(r.ops);
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - t1;
+        r.samples.push_back(elapsed.count() / r.ops);
+    }
+    Summarize(r);
+    return r;
+}
+
+bool WriteJSON(const std::string& path, const std::vector<Result>& results)
+{
+    std::ofstream out(path);
+    if(!out)
+    {
+        return false;
+    }
+    out << std::fixed << std::setprecision(2) << "[\n";
+    for(size_t i = 0; i < results.size(); i++)
+    {
+        const Result& r = results[i];
+        out << "  {\"name\": \"" << r.name << "\", \"unit\": \"ns/op\", \"ops\": " << r.ops
+            << ", \"samples\": " << r.samples.size() << ", \"median\": " << r.median
+            << ", \"p95\": " << r.p95 << ", \"mean\": " << r.mean << ", \"stddev\": " << r.stddev
+            << ", \"min\": " << r.min << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+    return bool(out);
+}
+
+std::map<std::string, double> ReadBaseline(const std::string& path)
+{
+    std::map<std::string, double> medians;
+    std::ifstream in(path);
+    std::string line;
+    while(std::getline(in, line))
+    {
+        // the names never contain quotes, see WriteJSON
+        const std::string nameKey = "\"name\": \"", medianKey = "\"median\": ";
+        const size_t n = line.find(nameKey), m = line.find(medianKey);
+        if(n == std::string::npos || m == std::string::npos)
+        {
+            continue;
+        }
+        const size_t begin = n + nameKey.size();
+        const size_t end = line.find('"', begin);
+        std::istringstream value(line.substr(m + medianKey.size()));
+        double median;
+        if(end != std::string::npos && value >> median)
+        {
+            medians[line.substr(begin, end - begin)] = median;
+        }
+    }
+    return medians;
+}
+
+int Compare(const std::vector<Result>& results, const std::map<std::string, double>& baseline,
+            double tolerance)
+{
+    int regressions = 0;
+    std::cout << std::endl << "Compared with the baseline (median):" << std::endl;
+    for(const Result& r : results)
+    {
+        auto it = baseline.find(r.name);
+        std::cout << "  " << std::left << std::setw(36) << r.name << std::right;
+        if(it == baseline.end() || it->second <= 0)
+        {
+            std::cout << "(not in the baseline)" << std::endl;
+            continue;
+        }
+        const double change = r.median / it->second - 1.0;
+        const bool regression = change > tolerance;
+        regressions += regression;
+        std::cout << std::setw(10) << std::fixed << std::setprecision(1) << it->second << " -> "
+                  << std::setw(10) << r.median << " ns  " << std::showpos << std::setw(6)
+                  << 100.0 * change << std::noshowpos << "%" << (regression ? "  REGRESSION" : "")
+                  << std::endl;
+    }
+    return regressions;
+}
+
+}
@@ -0,0 +1,93 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace bench
+{
+
+/**
+ * @brief How often a benchmark runs
+ */
+struct Options
+{
+    /**
+     * @brief warmUp Samples that are taken and thrown away (caches,
+     * branch predictors, CPU frequency)
+     */
+    int warmUp = 5;
+    int samples = 30;
+
+    /**
+     * @brief filter Only run benchmarks whose name contains it
+     */
+    std::string filter;
+};
+
+/**
+ * @brief The samples of a benchmark in nanoseconds per operation and
+ * their statistics
+ */
+struct Result
+{
+    std::string name;
+
+    /**
+     * @brief ops The operations timed by a sample
+     */
+    int ops = 0;
+    std::vector<double> samples;
+
+    double median = 0;
+    double p95 = 0;
+    double mean = 0;
+    double stddev = 0;
+    double min = 0;
+};
+
+/**
+ * @brief Summarize Computes the statistics of the samples (p95 is the
+ * nearest rank, stddev the sample standard deviation)
+ */
+void Summarize(Result& r);
+
+/**
+ * @brief Run Times `body(ops)` once per sample after the warm-up
+ * @param body Runs `ops` operations
+ */
+Result Run(const std::string& name, int ops, const Options& options,
+           const std::function<void(int)>& body);
+
+/**
+ * @brief Sink Keeps a value alive, so the compiler can't drop the
+ * computation that produced it
+ */
+void Sink(long value);
+
+/**
+ * @brief WriteJSON Writes the results as a JSON array (one object per
+ * line, see ReadBaseline)
+ */
+bool WriteJSON(const std::string& path, const std::vector<Result>& results);
+
+/**
+ * @brief ReadBaseline Reads the medians of a file written by WriteJSON
+ * @return name -> median (empty if the file can't be read)
+ */
+std::map<std::string, double> ReadBaseline(const std::string& path);
+
+/**
+ * @brief Compare Prints the change of every median relative to the
+ * baseline
+ * @param tolerance The relative slow-down that counts as a regression
+ * @return The amount of regressions
+ */
+int Compare(const std::vector<Result>& results, const std::map<std::string, double>& baseline,
+            double tolerance);
+
+}
+
+#endif // BENCH_H
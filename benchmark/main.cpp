@@ -0,0 +1,344 @@
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+#include "bboard.hpp"
+#include "strategy.hpp"
+#include "fixture.hpp"
+#include "bench.hpp"
+
+using namespace bboard;
+
+namespace
+{
+
+/**
+ * @brief A game setting that is played with random moves to a fixed
+ * amount of steps. The game restarts from the initial state when it
+ * ends or after `maxSteps`, so every sample does the same work.
+ */
+struct Scenario
+{
+    std::string name;
+    State initial;
+
+    /**
+     * @brief bombChance In percent, the other moves are uniform
+     */
+    int bombChance = 17;
+    int maxSteps = 300;
+};
+
+inline uint64_t XorShift(uint64_t& r)
+{
+    r ^= r << 13;
+    r ^= r >> 7;
+    r ^= r << 17;
+    return r;
+}
+
+inline void RandomMoves(uint64_t& r, int bombChance, Move moves[AGENT_COUNT])
+{
+    for(int i = 0; i < AGENT_COUNT; i++)
+    {
+        const uint64_t x = XorShift(r) >> 16;
+        moves[i] = int(x % 100) < bombChance ? Move::BOMB : Move((x >> 8) % 5);
+    }
+}
+
+void ClearBoard(State& s)
+{
+    for(int y = 0; y < BOARD_SIZE; y++)
+    {
+        for(int x = 0; x < BOARD_SIZE; x++)
+        {
+            s.board[y][x] = Item::PASSAGE;
+        }
+    }
+}
+
+/**
+ * @brief Play Plays random moves from the state until the game ends
+ * (or for `steps` steps)
+ */
+void Play(State& s, int steps, int bombChance, uint64_t seed)
+{
+    uint64_t r = seed | 1;
+    Move m[AGENT_COUNT];
+    for(int t = 0; t < steps && s.aliveAgents > 1; t++)
+    {
+        RandomMoves(r, bombChance, m);
+        Step(&s, m);
+    }
+}
+
+std::vector<Scenario> Scenarios()
+{
+    std::vector<Scenario> scenarios(3);
+
+    // no wood, no rigid cells, default stats
+    Scenario& empty = scenarios[0];
+    empty.name = "Empty Board";
+    empty.initial = State();
+    ClearBoard(empty.initial);
+    empty.initial.PutAgentsInCorners(0, 1, 2, 3);
+
+    // strong agents after the opening, bombs in almost every step
+    Scenario& bombs = scenarios[1];
+    bombs.name = "Bomb-Heavy Mid-Game";
+    bombs.bombChance = 45;
+    for(uint64_t seed = 1; ; seed++)
+    {
+        State& s = bombs.initial;
+        s = State();
+        InitBoardItems(s, int(seed));
+        s.PutAgentsInCorners(0, 1, 2, 3);
+        for(AgentInfo& a : s.agents)
+        {
+            a.maxBombCount = MAX_BOMBS_PER_AGENT;
+            a.bombStrength = 4;
+        }
+        Play(s, 30, 8, seed);
+        // random agents blow themselves up, one may be gone
+        if(s.aliveAgents >= AGENT_COUNT - 1 && s.bombs.count >= 2)
+        {
+            break;
+        }
+    }
+
+    // everybody kicks, bombs fly across an open board
+    Scenario& kickers = scenarios[2];
+    kickers.name = "Kicker Chaos";
+    kickers.bombChance = 30;
+    kickers.initial = empty.initial;
+    for(AgentInfo& a : kickers.initial.agents)
+    {
+        a.canKick = true;
+        a.maxBombCount = MAX_BOMBS_PER_AGENT;
+        a.bombStrength = 3;
+    }
+
+    for(Scenario& s : scenarios)
+    {
+        s.initial.timeStep = 0;
+    }
+    return scenarios;
+}
+
+/**
+ * @brief Positions Mid-game states for the microbenchmarks
+ */
+std::vector<State> Positions(const Scenario& scenario, int count)
+{
+    std::vector<State> states;
+    for(uint64_t seed = 1; int(states.size()) < count; seed++)
+    {
+        State s = scenario.initial;
+        Play(s, 1 + int(seed % 12), scenario.bombChance, seed);
+        if(s.aliveAgents > 1 && !s.agents[0].dead)
+        {
+            states.push_back(s);
+        }
+    }
+    return states;
+}
+
+void PrintResult(const bench::Result& r)
+{
+    std::cout << "  " << std::left << std::setw(36) << r.name << std::right << std::fixed
+              << std::setprecision(1) << std::setw(10) << r.median << std::setw(10) << r.p95
+              << std::setw(10) << r.stddev << std::setw(10) << r.min << std::endl;
+}
+
+void Usage()
+{
+    std::cout << "usage: bench [--samples n] [--warmup n] [--filter text] [--json file]" << std::endl
+              << "             [--baseline file] [--tolerance fraction]" << std::endl
+              << std::endl
+              << "Times every benchmark `samples` times after `warmup` samples and prints the" << std::endl
+              << "median, p95, standard deviation and minimum in ns per operation. --json writes" << std::endl
+              << "the results, --baseline compares the medians with an earlier --json file and" << std::endl
+              << "fails if one got slower by more than the tolerance (default 0.1)." << std::endl;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    bench::Options options;
+    std::string json, baselinePath;
+    double tolerance = 0.1;
+    for(int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if(arg == "--samples" && hasValue)
+        {
+            options.samples = std::max(1, std::atoi(argv[++i]));
+        }
+        else if(arg == "--warmup" && hasValue)
+        {
+            options.warmUp = std::max(0, std::atoi(argv[++i]));
+        }
+        else if(arg == "--filter" && hasValue)
+        {
+            options.filter = argv[++i];
+        }
+        else if(arg == "--json" && hasValue)
+        {
+            json = argv[++i];
+        }
+        else if(arg == "--baseline" && hasValue)
+        {
+            baselinePath = argv[++i];
+        }
+        else if(arg == "--tolerance" && hasValue)
+        {
+            tolerance = std::atof(argv[++i]);
+        }
+        else
+        {
+            Usage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    std::vector<bench::Result> results;
+    auto run = [&](const std::string& name, int ops, const std::function<void(int)>& body)
+    {
+        if(name.find(options.filter) == std::string::npos)
+        {
+            return;
+        }
+        results.push_back(bench::Run(name, ops, options, body));
+        PrintResult(results.back());
+    };
+
+    std::cout << "  " << std::left << std::setw(36) << "ns/op" << std::right << std::setw(10)
+              << "median" << std::setw(10) << "p95" << std::setw(10) << "stddev" << std::setw(10)
+              << "min" << std::endl;
+
+    // whole games, a sample is 1000 steps
+    const std::vector<Scenario> scenarios = Scenarios();
+    for(const Scenario& scenario : scenarios)
+    {
+        State s = scenario.initial;
+        uint64_t r = 0x9E3779B97F4A7C15ULL;
+        int steps = 0;
+        run("Scenario: " + scenario.name, 1000, [&](int ops)
+        {
+            Move m[AGENT_COUNT];
+            for(int k = 0; k < ops; k++)
+            {
+                if(s.aliveAgents < 2 || steps == scenario.maxSteps)
+                {
+                    s = scenario.initial;
+                    steps = 0;
+                }
+                RandomMoves(r, scenario.bombChance, m);
+                Step(&s, m);
+                steps++;
+            }
+            bench::Sink(s.aliveAgents);
+        });
+    }
+
+    // single functions on mid-game positions
+    const std::vector<State> positions = Positions(scenarios[1], 64);
+    const int count = int(positions.size());
+    State s;
+    strategy::RMap rmap;
+
+    run("State Copy", 10000, [&](int ops)
+    {
+        for(int k = 0; k < ops; k++)
+        {
+            s = positions[k % count];
+            bench::Sink(s.timeStep);
+        }
+    });
+    run("Step", 10000, [&](int ops)
+    {
+        uint64_t r = 0x1234567;
+        Move m[AGENT_COUNT];
+        for(int k = 0; k < ops; k++)
+        {
+            // includes a state copy (see above)
+            s = positions[k % count];
+            RandomMoves(r, 17, m);
+            Step(&s, m);
+        }
+        bench::Sink(s.aliveAgents);
+    });
+    run("FillRMap", 10000, [&](int ops)
+    {
+        for(int k = 0; k < ops; k++)
+        {
+            strategy::FillRMap(positions[k % count], rmap, 0);
+        }
+        bench::Sink(rmap.source.x);
+    });
+    run("IsInDanger", 10000, [&](int ops)
+    {
+        long danger = 0;
+        for(int k = 0; k < ops; k++)
+        {
+            danger += strategy::IsInDanger(positions[k % count], k % AGENT_COUNT);
+        }
+        bench::Sink(danger);
+    });
+    run("SpawnFlame", 10000, [&](int ops)
+    {
+        // an open board, so the rays reach their full length
+        for(int k = 0; k < ops; k++)
+        {
+            s = scenarios[0].initial;
+            s.SpawnFlame(BOARD_SIZE / 2, BOARD_SIZE / 2, 2 + k % 8);
+        }
+        bench::Sink(s.flames.count);
+    });
+
+    // the worst cases, one step and 50 steps from the fixture (a
+    // sample copies the fixture before every run)
+    for(const Fixture& f : PathologicalFixtures())
+    {
+        for(int steps : {1, 50})
+        {
+            run("Fixture: " + f.name + (steps == 1 ? "" : " x50"), steps == 1 ? 10000 : 200, [&](int ops)
+            {
+                Move m[AGENT_COUNT];
+                for(int k = 0; k < ops; k++)
+                {
+                    s = f.state;
+                    for(int t = 0; t < steps; t++)
+                    {
+                        f.GetMoves(t, m);
+                        Step(&s, m);
+                    }
+                }
+                bench::Sink(s.aliveAgents);
+            });
+        }
+    }
+
+    int failed = 0;
+    if(!json.empty() && !bench::WriteJSON(json, results))
+    {
+        std::cerr << "Could not write " << json << std::endl;
+        failed = 1;
+    }
+    if(!baselinePath.empty())
+    {
+        const std::map<std::string, double> baseline = bench::ReadBaseline(baselinePath);
+        if(baseline.empty())
+        {
+            std::cerr << "Could not read " << baselinePath << std::endl;
+            return 1;
+        }
+        const int regressions = bench::Compare(results, baseline, tolerance);
+        std::cout << regressions << " regression(s) above " << 100.0 * tolerance << "%" << std::endl;
+        failed |= regressions > 0;
+    }
+    return failed;
+}
@@ -2,9 +2,18 @@
 #define RANDOM_AGENT_H
 
 #include <random>
+#include <memory>
+#include <vector>
 
 #include "bboard.hpp"
 #include "strategy.hpp"
+#include "analysis.hpp"
+#include "net.hpp"
+#include "evaluation_queue.hpp"
+#include "ntuple.hpp"
+#include "duct.hpp"
+#include "snapshot.hpp"
+#include "state_pool.hpp"
 
 namespace agents
 {
@@ -64,6 +73,7 @@ struct SimpleAgent : bboard::Agent
     //////////////
     int danger = 0;
     bboard::strategy::RMap r;
+    bboard::strategy::DangerMap dangerMap;
     bboard::FixedQueue<bboard::Move, bboard::MOVE_COUNT> moveQueue;
 
     // capacity of recent positions
@@ -71,9 +81,203 @@ struct SimpleAgent : bboard::Agent
     bboard::FixedQueue<bboard::Position, rpCapacity> recentPositions;
 
     bboard::Move act(const bboard::State* state) override;
+    bboard::Move act(const bboard::State* state,
+                     const bboard::strategy::AnalysisContext& analysis) override;
 
     void PrintDetailedInfo();
 };
+/**
+ * The network is shared (and not owned), several agents can play
+ * with the same weights.
+ *
+ * @brief Plays the most likely legal move of a policy network
+ */
+struct NetAgent : bboard::Agent
+{
+    const net::Network* network;
+    net::Precision precision;
+    net::Workspace workspace;
+
+    // the evaluation of the last act
+    net::Evaluation evaluation;
+
+    NetAgent(const net::Network* network, net::Precision precision = net::Precision::FP32);
+
+    bboard::Move act(const bboard::State* state) override;
+};
+
+/**
+ * A simulation descends the tree (with a virtual loss on its path),
+ * submits its leaf to the evaluation queue and is suspended. The
+ * search keeps starting new simulations until `parallel` of them are
+ * in flight and only then waits for the oldest one, so a single search
+ * fills batches and many searches can share one queue.
+ *
+ * The other agents play random legal moves that are drawn once per
+ * node. The nodes don't hold states: the tree keeps them as deltas
+ * (see search::SnapshotTree) and a descent moves a single state along
+ * its path.
+ *
+ * @brief A PUCT search that evaluates its leaves with a network
+ */
+struct PUCTAgent : bboard::Agent
+{
+    struct Node
+    {
+        int parent = -1;
+        int child[net::POLICY_SIZE];
+        float prior[net::POLICY_SIZE];
+
+        // the visits and values include the virtual losses
+        int visits = 0;
+        float valueSum = 0;
+
+        bool expanded = false;
+        bool terminal = false;
+        float outcome = 0; // the value of a terminal node
+    };
+
+    /**
+     * @brief A suspended simulation that waits for the value of its leaf
+     */
+    struct Simulation
+    {
+        int leaf;
+        bboard::State state; // of the leaf
+        net::EvaluationRequest request;
+    };
+
+    net::EvaluationQueue* queue;
+    int simulations;
+    int parallel;
+    float cPuct = 1.5f;
+
+    std::mt19937_64 rng;
+    std::vector<Node> nodes;
+    bboard::search::SnapshotTree states;
+    std::unique_ptr<Simulation[]> inFlight;
+
+    /**
+     * @param simulations The amount of simulations per move
+     * @param parallel The maximum amount of suspended simulations
+     */
+    PUCTAgent(net::EvaluationQueue* queue, int simulations = 64, int parallel = 8, uint64_t seed = 0);
+
+    bboard::Move act(const bboard::State* state) override;
+
+private:
+
+    bboard::State cursor; // the state of node cursorNode
+    int cursorNode = 0;
+
+    int AddNode(int parent);
+    int Descend(bboard::State& leafState);
+    void Expand(int node, const bboard::State& state, const net::Evaluation& e);
+    void Backup(int node, float value);
+};
+
+/**
+ * @brief Plays the legal move whose successor an n-tuple network
+ * values most (see ntuple::GreedyMove)
+ */
+struct NTupleAgent : bboard::Agent
+{
+    const ntuple::NTupleNetwork* network;
+
+    NTupleAgent(const ntuple::NTupleNetwork* network);
+
+    bboard::Move act(const bboard::State* state) override;
+};
+
+/**
+ * Every individual of the population is a sequence of `horizon` moves.
+ * Its fitness is the score of the state that is reached by playing the
+ * sequence with bboard::Step on a copy of the current state while the
+ * other agents play random moves. Each generation keeps the `elites`
+ * best individuals and refills the population with mutated uniform
+ * crossovers of tournament winners. After a decision, the population
+ * is shifted by one move and reused.
+ *
+ * The score is the value of the `heuristic` network if set, otherwise
+ * a hand-written score (killed opponents, destroyed wood, power-ups,
+ * dying late instead of early).
+ *
+ * All genomes and states are allocated in the constructor. With more
+ * than one thread, the fitness of a generation is evaluated by a pool
+ * of workers; the result doesn't depend on the thread count.
+ *
+ * @brief Plans with a rolling horizon evolutionary algorithm
+ */
+struct RHEAAgent : bboard::Agent
+{
+    const int horizon;
+    const int populationSize;
+    const int threads;
+
+    int elites = 1;
+    float mutationRate = 0.2f;
+
+    /**
+     * @brief budget The time per decision in milliseconds
+     */
+    double budget = 20;
+
+    /**
+     * @brief maxGenerations Stop earlier after this many generations
+     * (0: no limit)
+     */
+    int maxGenerations = 0;
+
+    const ntuple::NTupleNetwork* heuristic = nullptr;
+
+    // statistics
+    long evaluations = 0;
+    int generations = 0; // in the last decision
+
+    RHEAAgent(int horizon = 12, int populationSize = 10, int threads = 1, uint64_t seed = 0);
+    ~RHEAAgent();
+
+    bboard::Move act(const bboard::State* state) override;
+
+private:
+
+    struct Pool;
+    std::unique_ptr<Pool> pool;
+
+    std::mt19937_64 rng;
+    std::vector<bboard::Move> genomes;   // [populationSize][horizon]
+    std::vector<bboard::Move> offspring; // [populationSize][horizon]
+    std::vector<float> fitness;
+    std::vector<float> offspringFitness;
+    std::vector<int> order;
+    bboard::search::StatePool scratch;   // rollout states of all threads
+
+    const bboard::State* root = nullptr;
+    int rootWood = 0;
+    int lastTimeStep = -2;
+    uint64_t batchSeed = 0;
+
+    float Evaluate(const bboard::Move* genome, bboard::State& s, uint64_t seed) const;
+    void EvaluateSlice(bboard::Move* g, float* f, int from, int count, int slice);
+    void EvaluateAll(bboard::Move* g, float* f, int from, int count);
+    void Evolve();
+};
+
+/**
+ * @brief Plays the most visited move of a decoupled UCT (or EXP3)
+ * search (see search::DecoupledUCT)
+ */
+struct DUCTAgent : bboard::Agent
+{
+    bboard::search::DecoupledUCT search;
+    int iterations;
+
+    DUCTAgent(int iterations = 1000, int maxNodes = 1 << 16,
+              bboard::search::Selection selection = bboard::search::Selection::UCT, uint64_t seed = 0);
+
+    bboard::Move act(const bboard::State* state) override;
+};
+
 // more agents to be included?
 
 }
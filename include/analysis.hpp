@@ -0,0 +1,103 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include <mutex>
+#include <atomic>
+
+#include "bboard.hpp"
+#include "strategy.hpp"
+#include "projection.hpp"
+
+namespace bboard::strategy
+{
+
+/**
+ * Holds the analysis of a single state that is shared by all agents
+ * during a step. Every part is computed at most once, the first time
+ * it is requested (agents that never ask for it pay nothing). The
+ * getters can be called concurrently from several agent threads.
+ *
+ * @brief Lazily computed, read-only analysis of a state
+ */
+class AnalysisContext
+{
+
+private:
+
+    enum Part
+    {
+        DANGER = 0,
+        TIMELINE,
+        LEGAL,
+        NONFATAL,
+        RMAP0
+    };
+    static const int PART_COUNT = RMAP0 + AGENT_COUNT;
+
+    const State* state = nullptr;
+
+    mutable std::atomic<bool> ready[PART_COUNT] = {};
+    mutable std::mutex locks[PART_COUNT];
+    mutable std::atomic<int> computeCount = {0};
+
+    mutable DangerMap dangerMap;
+    mutable Timeline timeline;
+    mutable RMap rmaps[AGENT_COUNT];
+    mutable MoveMask legal[AGENT_COUNT];
+    mutable MoveMask nonFatal[AGENT_COUNT];
+
+    template<typename F>
+    void Ensure(Part part, F fill) const;
+
+public:
+
+    /**
+     * @brief Reset Points the context to a (new) state and discards
+     * everything that was computed so far. Not thread-safe.
+     */
+    void Reset(const State* state);
+
+    /**
+     * @brief GetState Returns the analysed state
+     */
+    const State& GetState() const;
+
+    /**
+     * @brief GetDangerMap Returns the danger values of all positions
+     */
+    const DangerMap& GetDangerMap() const;
+
+    /**
+     * @brief GetTimeline Returns the flames of the upcoming ticks
+     * (assuming no agent acts)
+     */
+    const Timeline& GetTimeline() const;
+
+    /**
+     * @brief GetRMap Returns the distances and paths from the
+     * position of the specified agent
+     */
+    const RMap& GetRMap(int agentID) const;
+
+    /**
+     * @brief GetLegalMoves Returns the legal moves of all agents
+     * (see LegalMoves)
+     */
+    const MoveMask* GetLegalMoves() const;
+
+    /**
+     * @brief GetNonFatalMoves Returns the legal moves of all agents
+     * that don't walk into the flames of the next tick (see NonFatalMoves)
+     */
+    const MoveMask* GetNonFatalMoves() const;
+
+    /**
+     * @brief GetComputeCount Returns how many parts have been computed
+     * since the last reset
+     */
+    int GetComputeCount() const;
+};
+
+}
+
+#endif // ANALYSIS_H
@@ -2,6 +2,7 @@
 #define BBOARD_H_
 
 #include <array>
+#include <cstdint>
 #include <string>
 #include <random>
 #include <memory>
@@ -13,11 +14,11 @@ namespace bboard
 {
 
 const int MOVE_COUNT  = 4;
+
+// the shape of the default game (see BasicState for other shapes)
 const int AGENT_COUNT = 4;
 const int BOARD_SIZE  = 11;
 
-static_assert (BOARD_SIZE <= 15, "Board positions must fit into 8-bit");
-
 const int BOMB_LIFETIME = 10;
 const int BOMB_DEFAULT_STRENGTH = 1;
 
@@ -42,6 +43,11 @@ enum class Move
     BOMB
 };
 
+/**
+ * @brief ACTION_COUNT The amount of different moves (IDLE to BOMB)
+ */
+const int ACTION_COUNT = int(Move::BOMB) + 1;
+
 enum class Direction
 {
     IDLE = 0,
@@ -248,7 +254,8 @@ struct AgentInfo
  * Represents all information about a single
  * bomb on the board.
  *
- * Specification (see docs optimization II)
+ * Specification (see docs optimization II), for boards
+ * of up to 16x16 cells
  *
  *   Bit     Semantics
  * [ 0,  4]  x-Position
@@ -257,12 +264,119 @@ struct AgentInfo
  * [12, 16]  Strength
  * [16, 20]  Time
  * [20, 24]  Direction
+ *
+ * Larger boards use wider position fields, which shifts
+ * all other fields (see BombFormat).
  */
 typedef int Bomb;
 
+/**
+ * @brief PositionBits Returns the width of the position fields
+ * of a bomb on a board with the given size (at least 4 bit)
+ */
+constexpr int PositionBits(int boardSize)
+{
+    int bits = 4;
+    while((1 << bits) < boardSize)
+    {
+        bits++;
+    }
+    return bits;
+}
+
+/**
+ * @brief The BombFormat struct encodes and decodes the fields of
+ * a bomb whose positions are POS_BITS wide. The other fields
+ * are 4 bit wide and follow the positions.
+ */
+template<int POS_BITS>
+struct BombFormat
+{
+    static_assert(2 * POS_BITS + 20 <= 31, "Bomb fields must fit into 31 bit");
+
+    static const int POS_MASK = (1 << POS_BITS) - 1;
+
+    static const int ID_SHIFT = 2 * POS_BITS;
+    static const int STRENGTH_SHIFT = ID_SHIFT + 4;
+    static const int TIME_SHIFT = STRENGTH_SHIFT + 4;
+    static const int DIR_SHIFT = TIME_SHIFT + 4;
+    static const int MOVED_SHIFT = DIR_SHIFT + 4;
+
+    /**
+     * @brief PositionKey Returns the position fields of a bomb at
+     * (x, y), comparable with Pos
+     */
+    static int PositionKey(int x, int y)
+    {
+        return x + (y << POS_BITS);
+    }
+
+    static int Pos(const Bomb b)
+    {
+        return b & ((1 << ID_SHIFT) - 1);
+    }
+    static int PosX(const Bomb b)
+    {
+        return b & POS_MASK;
+    }
+    static int PosY(const Bomb b)
+    {
+        return (b >> POS_BITS) & POS_MASK;
+    }
+    static int ID(const Bomb b)
+    {
+        return (b >> ID_SHIFT) & 0xF;
+    }
+    static int Strength(const Bomb b)
+    {
+        return (b >> STRENGTH_SHIFT) & 0xF;
+    }
+    static int Time(const Bomb b)
+    {
+        return (b >> TIME_SHIFT) & 0xF;
+    }
+    static int Dir(const Bomb b)
+    {
+        return (b >> DIR_SHIFT) & 0xF;
+    }
+    static int Moved(const Bomb b)
+    {
+        return (b >> MOVED_SHIFT) & 0xF;
+    }
+
+    static void ReduceTimer(Bomb& b)
+    {
+        b = b - (1 << TIME_SHIFT);
+    }
+    static void SetPosition(Bomb& b, int x, int y)
+    {
+        b = (b & ~((1 << ID_SHIFT) - 1)) + PositionKey(x, y);
+    }
+    static void SetID(Bomb& b, int id)
+    {
+        b = (b & ~(0xF << ID_SHIFT)) + (id << ID_SHIFT);
+    }
+    static void SetStrength(Bomb& b, int strength)
+    {
+        b = (b & ~(0xF << STRENGTH_SHIFT)) + (strength << STRENGTH_SHIFT);
+    }
+    static void SetTime(Bomb& b, int time)
+    {
+        b = (b & ~(0xF << TIME_SHIFT)) + (time << TIME_SHIFT);
+    }
+    static void SetDirection(Bomb& b, Direction dir)
+    {
+        b = (b & ~(0xF << DIR_SHIFT)) + (int(dir) << DIR_SHIFT);
+    }
+    static void SetMovedFlag(Bomb& b, bool moved)
+    {
+        b = (b & ~(0xF << MOVED_SHIFT)) + (int(moved) << MOVED_SHIFT);
+    }
+};
+
 // BOMB INFO
-// ACCESS ALL PARTS OF THE BOMB INTEGER (EVERYTHING ENCODED
-// INTO 4 BIT WIDE FIELDS)
+// ACCESS ALL PARTS OF THE BOMB INTEGER OF THE DEFAULT
+// BOARD (EVERYTHING ENCODED INTO 4 BIT WIDE FIELDS)
 inline int BMB_POS(const Bomb x)
 {
     return (((x) & 0xFF));            // [ 0, 8[
@@ -344,6 +458,47 @@ struct Flame
     Position position;
     int timeLeft = FLAME_LIFETIME;
     int strength;
+    int owner = -1; // the agent whose bomb spawned the flame (if known)
+};
+
+/**
+ * Stores the S x S cells of the board inside a permanent ring
+ * of RIGID cells. Rows and columns keep their 0-based
+ * coordinates, but the direct neighbours of every cell (x, y in
+ * [-1, S]) can be accessed as well, so that walks and rays
+ * stop at the border like at any other wall instead of checking the
+ * coordinates.
+ *
+ * @brief The board of a state, padded with a border of walls
+ */
+template<int S>
+struct BasicBoard
+{
+    static const int PADDED_SIZE = S + 2;
+
+    int cells[PADDED_SIZE][PADDED_SIZE];
+
+    BasicBoard()
+    {
+        for(int i = 0; i < PADDED_SIZE; i++)
+        {
+            cells[0][i] = cells[PADDED_SIZE - 1][i] = Item::RIGID;
+            cells[i][0] = cells[i][PADDED_SIZE - 1] = Item::RIGID;
+        }
+    }
+
+    /**
+     * @brief operator [] Returns row y, which can be indexed with
+     * x in [-1, S]
+     */
+    int* operator[] (const int y)
+    {
+        return &cells[y + 1][1];
+    }
+    const int* operator[] (const int y) const
+    {
+        return &cells[y + 1][1];
+    }
 };
 
 /**
@@ -351,10 +506,29 @@ struct Flame
  * Includes (in)destructible obstacles, bombs, player positions,
  * etc (as defined by the Pommerman source)
  *
+ * The shape of the game is a compile-time parameter: S is the
+ * width and height of the board and N the amount of agents. All
+ * loops over cells and agents have constant bounds, so small
+ * shapes get fully unrolled loops. The engine is instantiated
+ * for the shapes listed in BBOARD_FOR_EACH_SHAPE.
+ *
  * @brief Holds all information about the board
  */
-struct State
+template<int S, int N>
+struct BasicState
 {
+    static_assert(S >= 3 && S <= 32, "Unsupported board size");
+    // the ID field of a bomb is 4 bit wide
+    static_assert(N >= 2 && N <= 16, "Unsupported agent count");
+
+    static const int BOARD_SIZE = S;
+    static const int AGENT_COUNT = N;
+    static const int MAX_BOMBS = N * MAX_BOMBS_PER_AGENT;
+
+    /**
+     * @brief Format The bomb encoding of this shape
+     */
+    typedef BombFormat<PositionBits(S)> Format;
 
     /**
      * @brief operator [] This way you can reference a position
@@ -364,15 +538,15 @@ struct State
      */
     int& operator[] (const Position& pos);
 
-    int board[BOARD_SIZE][BOARD_SIZE];
+    BasicBoard<S> board;
 
     int timeStep = 0;
-    int aliveAgents = AGENT_COUNT;
+    int aliveAgents = N;
 
     /**
      * @brief agents Array of all agents and their properties
      */
-    AgentInfo agents[AGENT_COUNT];
+    AgentInfo agents[N];
 
     /**
      * @brief bombQueue Holds all bombs on this board
@@ -445,8 +619,9 @@ struct State
      * @param y The y position of the origin of flames
      * @param strength The farthest reachable distance
      * from the origin
+     * @param owner The agent that planted the bomb (-1 if unknown)
      */
-    void SpawnFlame(int x, int y, int strength);
+    void SpawnFlame(int x, int y, int strength, int owner = -1);
 
     /**
      * @brief PopFlame extinguishes the top flame
@@ -490,6 +665,11 @@ struct State
         Kill(args...);
     }
     /**
+     * The agents are spread evenly along the border, so four agents
+     * end up in the corners and two agents face each other in the top
+     * left and bottom right corners (a2, a3 are ignored). With more
+     * than four agents, the agents 4, 5, .. follow a0 to a3.
+     *
      * @brief PutAgents Places agents with given IDs
      * clockwise on the board, starting from top left.
      */
@@ -505,11 +685,38 @@ struct State
     void PutAgent(int x, int y, int agentID);
 };
 
-inline int& State::operator[] (const Position& pos)
+template<int S, int N>
+inline int& BasicState<S, N>::operator[] (const Position& pos)
 {
     return board[pos.y][pos.x];
 }
 
+/**
+ * The default game (State), a small 1 vs 1 training board and a
+ * large stress board, with 4 and with 16 agents (free-for-all). Add
+ * a shape here to compile the engine for it.
+ *
+ * @brief BBOARD_FOR_EACH_SHAPE Expands F(S, N) for every game shape
+ * the engine is instantiated for
+ */
+#define BBOARD_FOR_EACH_SHAPE(F) \
+    F(11, 4)                     \
+    F(8, 2)                      \
+    F(21, 4)                     \
+    F(21, 16)
+
+/**
+ * @brief State The state of the default game (11x11 board, 4 agents)
+ */
+typedef BasicState<BOARD_SIZE, AGENT_COUNT> State;
+
+static_assert(State::Format::POS_MASK == 0xF, "BMB_* decode the bombs of the default game");
+
+namespace strategy
+{
+class AnalysisContext;
+}
+
 /**
  * @brief The Agent struct defines a behaviour. For a given
  * state it will return a Move.
@@ -530,6 +737,21 @@ struct Agent
      * @return A Move (integer, 0-..)
      */
     virtual Move act(const State* state) = 0;
+
+    /**
+     * Agents that want to reuse the analysis (danger map, distances,
+     * ..) the environment shares between all agents of a step override
+     * this method. Defaults to act(state).
+     *
+     * @brief For a given state and its analysis, return a Move
+     * @param state The (potentially fogged) board state
+     * @param analysis The lazily computed analysis of the state
+     * @return A Move (integer, 0-..)
+     */
+    virtual Move act(const State* state, const strategy::AnalysisContext& /* analysis */)
+    {
+        return act(state);
+    }
 };
 
 
@@ -544,6 +766,7 @@ class Environment
 private:
 
     std::unique_ptr<State> state;
+    std::unique_ptr<strategy::AnalysisContext> analysis;
     std::array<Agent*, AGENT_COUNT> agents;
     std::function<void(const Environment&)> listener;
 
@@ -563,6 +786,7 @@ private:
 public:
 
     Environment();
+    ~Environment();
     /**
      * @brief MakeGame Initializes the state
      */
@@ -599,6 +823,13 @@ public:
      */
     State& GetState() const;
 
+    /**
+     * @brief GetAnalysis Returns the analysis of the current state that
+     * is shared by all agents (parts that no agent requested are
+     * computed on demand)
+     */
+    const strategy::AnalysisContext& GetAnalysis() const;
+
     /**
      * @brief SetAgents Registers all agents that will participate
      * in this game
@@ -648,7 +879,8 @@ public:
  * the field without adding/creating agents
  * @param seed The random seed for the item generator
  */
-void InitBoardItems(State& state, int seed = 0x1337);
+template<int S, int N>
+void InitBoardItems(BasicState<S, N>& state, int seed = 0x1337);
 
 /**
  * @brief InitState Returns an meaningfully initialized state
@@ -658,14 +890,156 @@ void InitBoardItems(State& state, int seed = 0x1337);
  * @param a2 Agent no. that should be bottom right
  * @param a3 Agent no. that should be bottom left
  */
-void InitState(State* state, int a0, int a1, int a2, int a3);
+template<int S, int N>
+void InitState(BasicState<S, N>* state, int a0, int a1, int a2, int a3);
+
+/**
+ * @brief The kinds of events that a step can report. The comments
+ * list what agent and value of an Event mean.
+ */
+enum class EventType
+{
+    BOMB_PLANTED = 0,  // the planting agent
+    BOMB_KICKED,       // the kicking agent, value: the direction
+    BOMB_EXPLODED,     // the owner, value: the strength of the flames
+    WOOD_DESTROYED,    // the owner of the flame, value: the power-up flag
+    POWERUP_COLLECTED, // the collecting agent, value: the power-up item
+    AGENT_DIED         // the dead agent, value: the owner of the flame (-1 if unknown)
+};
+
+/**
+ * @brief Something that happened on a cell during a step
+ */
+struct Event
+{
+    EventType type;
+    int agent;
+    Position position;
+    int value;
+};
+
+const int MAX_STEP_EVENTS = 256;
+
+/**
+ * Events are stored in the order in which they happened. A kick
+ * is reported even if the kicked bomb bounces back in the same step.
+ * Events that don't fit into the buffer are only counted.
+ *
+ * @brief A fixed-capacity buffer of the events of a step
+ */
+struct StepEvents
+{
+    Event events[MAX_STEP_EVENTS];
+    int count = 0;
+    int dropped = 0;
+
+    void Add(EventType type, int agent, int x, int y, int value = 0)
+    {
+        if(count < MAX_STEP_EVENTS)
+        {
+            events[count++] = {type, agent, {x, y}, value};
+        }
+        else
+        {
+            dropped++;
+        }
+    }
+
+    void Clear()
+    {
+        count = 0;
+        dropped = 0;
+    }
+};
 
 /**
  * @brief Applies given moves to the given board state.
  * @param state The state of the board
- * @param moves Array of 4 moves
+ * @param moves Array of N moves (one per agent)
+ */
+template<int S, int N>
+void Step(BasicState<S, N>* state, Move* moves);
+
+/**
+ * @brief Step Applies the moves like Step and reports what
+ * happened during the step
+ * @param events Cleared and filled with the events of this step
+ */
+template<int S, int N>
+void Step(BasicState<S, N>* state, Move* moves, StepEvents* events);
+
+/**
+ * @brief PrepareStep Applies the part of a step that doesn't depend
+ * on the moves (flames and bomb timers). Step is PrepareStep followed
+ * by ResolveStep.
+ */
+template<int S, int N>
+void PrepareStep(BasicState<S, N>* state);
+
+/**
+ * @brief ResolveStep Applies the moves to a prepared state (movement,
+ * kicks, bomb movement and explosions)
+ * @param state A state that went through PrepareStep
+ * @param moves Array of N moves (one per agent)
+ */
+template<int S, int N>
+void ResolveStep(BasicState<S, N>* state, Move* moves);
+
+/**
+ * Equivalent to copying the parent and calling Step for every joint
+ * action, but the move-independent part is computed only once.
+ *
+ * @brief StepBatch Computes the successors of a state for several
+ * joint actions
+ * @param parent The state to expand
+ * @param moves `count` joint actions
+ * @param successors Caller-owned storage for `count` states,
+ * successors[k] is the result of moves[k]
+ */
+template<int S, int N>
+void StepBatch(const BasicState<S, N>& parent, const Move moves[][N], int count,
+               BasicState<S, N>* successors);
+
+/**
+ * @brief The kernels ResolveStep chooses from for the bomb phase
+ * of a tick (after the agents have moved)
+ */
+enum class StepKernel
+{
+    NO_BOMBS = 0,    // nothing to move or explode
+    BOMBS_AT_REST,   // no kicked bomb and no agent on a bomb it walked onto
+    BOMBS_IN_MOTION, // the full bomb movement
+    COUNT
+};
+
+/**
+ * @brief Counts the ticks that each StepKernel resolved
+ */
+struct StepKernelCounters
+{
+    long ticks[int(StepKernel::COUNT)] = {};
+};
+
+/**
+ * @brief GetStepKernelCounters Returns the kernel counters of the
+ * calling thread. Assign StepKernelCounters() to reset them.
+ */
+StepKernelCounters& GetStepKernelCounters();
+
+/**
+ * @brief HashState Returns a 64-bit hash of the state. Only the
+ * logical content (board, agents, queued bombs and flames) is
+ * hashed, the time step is ignored.
+ */
+template<int S, int N>
+uint64_t HashState(const BasicState<S, N>& state);
+
+/**
+ * @brief EqualStates Returns true if both states have the same
+ * logical content (everything that HashState considers)
  */
-void Step(State* state, Move* moves);
+template<int S, int N>
+bool EqualStates(const BasicState<S, N>& a, const BasicState<S, N>& b);
 
 /**
  * @brief StartGame starts a game and prints in the terminal output
@@ -680,7 +1054,8 @@ void StartGame(State* state, Agent* agents[AGENT_COUNT], int timeSteps);
  * @brief Prints the state into the standard output stream.
  * @param state The state to print
  */
-void PrintState(State* state, bool clearConsole = false);
+template<int S, int N>
+void PrintState(BasicState<S, N>* state, bool clearConsole = false);
 
 /**
  * @brief Returns a string, corresponding to the given item
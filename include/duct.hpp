@@ -0,0 +1,196 @@
+#ifndef DUCT_H
+#define DUCT_H
+
+#include <random>
+#include <vector>
+
+#include "bboard.hpp"
+#include "strategy.hpp"
+#include "expansion.hpp"
+#include "transposition.hpp"
+
+namespace bboard::search
+{
+
+/**
+ * @brief How every agent picks its move at a node
+ */
+enum class Selection
+{
+    /**
+     * @brief UCT UCB1 on the agent's own statistics
+     */
+    UCT,
+
+    /**
+     * @brief EXP3 Samples from exponential weights of the estimated
+     * rewards, which converges to a mixed strategy
+     */
+    EXP3
+};
+
+/**
+ * @brief The statistics of one agent at a node
+ */
+struct ActionStats
+{
+    int visits[ACTION_COUNT];
+
+    /**
+     * @brief reward UCT: the sum of the rewards in [-1, 1]. EXP3: the
+     * sum of the importance weighted rewards in [0, 1].
+     */
+    float reward[ACTION_COUNT];
+};
+
+/**
+ * @brief A node of a DecoupledUCT tree. Nodes don't hold a state, a
+ * simulation steps a copy of the root state along its path.
+ */
+struct DUCTNode
+{
+    /**
+     * @brief hash The hash of the outcome (the state after the joint
+     * action) that leads to this node
+     */
+    uint64_t hash;
+    int parent;
+    int visits;
+    strategy::MoveMask legal[AGENT_COUNT];
+    ActionStats stats[AGENT_COUNT];
+};
+
+/**
+ * Moves are simultaneous: at every node, each agent selects its own
+ * move from its own ActionStats (decoupled), the joint action is
+ * stepped and every agent's statistics are updated with that agent's
+ * reward. Joint actions that lead to the same outcome lead to the same
+ * child, so a node has at most as many children as the state has
+ * distinct successors (see JointActionExpander) instead of one per
+ * joint action.
+ *
+ * All nodes live in a flat arena that is allocated once. A child is
+ * found through an open addressing table keyed by its parent and the
+ * hash of its outcome (two outcomes with the same 64-bit hash share a
+ * node). Leaves are valued by a random rollout of legal moves (or the
+ * transposition table); the reward of an agent is 1 if it is the last
+ * one alive, -1 if it died while others live and 0 otherwise.
+ *
+ * @brief Decoupled UCT (or EXP3) search for all agents at once
+ */
+class DecoupledUCT
+{
+
+public:
+
+    Selection selection = Selection::UCT;
+
+    /**
+     * @brief exploration The UCB1 constant (UCT)
+     */
+    float exploration = 1.4f;
+
+    /**
+     * @brief gamma The share of uniform exploration (EXP3)
+     */
+    float gamma = 0.2f;
+
+    /**
+     * @brief maxDepth The maximum depth of the tree
+     */
+    int maxDepth = 24;
+
+    /**
+     * @brief rolloutDepth The amount of random steps that value a leaf
+     */
+    int rolloutDepth = 8;
+
+    /**
+     * @brief transpositions An optional table (that may be shared with
+     * other searches and threads) that averages the rollouts of every
+     * leaf position per agent
+     */
+    TranspositionTable* transpositions = nullptr;
+
+    /**
+     * @brief ttSamples Leaves whose table entries hold this many
+     * rollouts for every living agent are valued without a rollout
+     */
+    int ttSamples = 16;
+
+    /**
+     * Chain reactions can differ between symmetric positions (see
+     * TransformState), so the shared values are approximate. These
+     * entries get keys of their own and never answer the exact
+     * lookups of searches without this flag.
+     *
+     * @brief mergeSymmetries Key the table with the canonical hash (see
+     * CanonicalHash), so symmetric positions share their entries
+     */
+    bool mergeSymmetries = false;
+
+    /**
+     * @param maxNodes The size of the arena. A full arena stops the
+     * tree from growing, the search continues.
+     */
+    DecoupledUCT(int maxNodes = 1 << 16, uint64_t seed = 0);
+
+    /**
+     * @brief Search Builds a new tree for the given state
+     * @param iterations The amount of simulations
+     */
+    void Search(const State& root, int iterations);
+
+    /**
+     * @brief BestMove The most visited move of the agent at the root
+     */
+    Move BestMove(int agentID) const;
+
+    const DUCTNode& GetRoot() const
+    {
+        return nodes[0];
+    }
+    const DUCTNode& GetNode(int index) const
+    {
+        return nodes[index];
+    }
+    int GetNodeCount() const
+    {
+        return int(nodes.size());
+    }
+
+    /**
+     * @brief GetChild The child of the node that is reached by the
+     * outcome with the given hash (-1 if there is none)
+     */
+    int GetChild(int node, uint64_t hash) const;
+
+    /**
+     * @brief GetMemoryUsage The size of the arena and its table in bytes
+     */
+    size_t GetMemoryUsage() const;
+
+private:
+
+    struct Edge
+    {
+        int node;
+        Move moves[AGENT_COUNT];
+        float probability[AGENT_COUNT]; // EXP3
+    };
+
+    std::mt19937_64 rng;
+    std::vector<DUCTNode> nodes;
+    std::vector<int> table;
+    std::vector<Edge> path;
+    const int maxNodes;
+
+    int AddNode(int parent, uint64_t hash, const State& state);
+    Move Select(const DUCTNode& node, int agentID, float& probability);
+    void Rollout(State& state, float rewards[AGENT_COUNT]);
+    void Evaluate(State& state, uint64_t hash, float rewards[AGENT_COUNT]);
+};
+
+}
+
+#endif // DUCT_H
@@ -0,0 +1,138 @@
+#ifndef EVALUATION_QUEUE_H
+#define EVALUATION_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "bboard.hpp"
+#include "net.hpp"
+
+namespace agents::net
+{
+
+/**
+ * A request is owned by the caller. The state is not copied, so both
+ * the request and the state have to stay alive (and unchanged) until
+ * the request is ready. A ready request can be submitted again.
+ *
+ * @brief A single evaluation that is queued in an EvaluationQueue
+ */
+struct EvaluationRequest
+{
+    const bboard::State* state = nullptr;
+    int agentID = 0;
+
+    Evaluation result;
+
+    /**
+     * @brief IsReady Returns true once the result is written
+     */
+    bool IsReady() const
+    {
+        return ready.load(std::memory_order_acquire);
+    }
+
+private:
+
+    friend class EvaluationQueue;
+    std::atomic<bool> ready{false};
+};
+
+/**
+ * Collects requests from any amount of threads (several searches or
+ * several games) and evaluates them in batches on a worker thread. A
+ * batch is evaluated as soon as it is full or when its oldest request
+ * waited for maxWait.
+ *
+ * Callers don't have to block: they can submit a leaf, continue with
+ * other work and collect the result later (see PUCTAgent).
+ *
+ * @brief Batches the network evaluations of many callers
+ */
+class EvaluationQueue
+{
+
+public:
+
+    /**
+     * @param network The network, it has to outlive the queue
+     * @param maxBatch The maximum amount of states per evaluation
+     * @param maxWait The maximum time a request waits for a batch to fill
+     */
+    EvaluationQueue(const Network& network, int maxBatch = 32,
+                    std::chrono::microseconds maxWait = std::chrono::microseconds(500),
+                    Precision precision = Precision::FP32);
+
+    /**
+     * @brief Evaluates the remaining requests and stops the worker
+     */
+    ~EvaluationQueue();
+
+    EvaluationQueue(const EvaluationQueue&) = delete;
+    EvaluationQueue& operator=(const EvaluationQueue&) = delete;
+
+    /**
+     * @brief Submit Queues the request and returns immediately
+     */
+    void Submit(EvaluationRequest& request);
+
+    /**
+     * @brief Wait Blocks until the (submitted) request is ready
+     */
+    void Wait(const EvaluationRequest& request);
+
+    /**
+     * @brief Evaluate Submits a single state and waits for its result
+     */
+    Evaluation Evaluate(const bboard::State& state, int agentID);
+
+    int GetMaxBatch() const
+    {
+        return maxBatch;
+    }
+
+    /**
+     * @brief GetBatchCount The amount of evaluated batches
+     */
+    long GetBatchCount() const
+    {
+        return batchCount.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief GetEvaluationCount The amount of evaluated requests
+     */
+    long GetEvaluationCount() const
+    {
+        return evaluationCount.load(std::memory_order_relaxed);
+    }
+
+private:
+
+    const Network& network;
+    const int maxBatch;
+    const std::chrono::microseconds maxWait;
+    const Precision precision;
+
+    std::mutex mutex;
+    std::condition_variable submitted;
+    std::condition_variable evaluated;
+    std::vector<EvaluationRequest*> queue;
+    std::chrono::steady_clock::time_point oldest;
+    bool stop = false;
+
+    std::atomic<long> batchCount{0};
+    std::atomic<long> evaluationCount{0};
+
+    std::thread worker;
+
+    void Run();
+};
+
+}
+
+#endif // EVALUATION_QUEUE_H
@@ -0,0 +1,130 @@
+#ifndef EXPANSION_H
+#define EXPANSION_H
+
+#include "bboard.hpp"
+#include "strategy.hpp"
+
+namespace bboard::search
+{
+
+constexpr int _JointActionCount(int agents)
+{
+    return agents == 0 ? 1 : ACTION_COUNT * _JointActionCount(agents - 1);
+}
+
+/**
+ * @brief JOINT_ACTION_COUNT The amount of different move
+ * combinations of all agents
+ */
+const int JOINT_ACTION_COUNT = _JointActionCount(AGENT_COUNT);
+
+/**
+ * @brief JointAction Encodes the moves of all agents into a single
+ * integer m0 + 6 * m1 + 36 * m2 + ..
+ */
+typedef int JointAction;
+
+inline JointAction EncodeJointAction(const Move moves[AGENT_COUNT])
+{
+    JointAction a = 0;
+    for(int i = AGENT_COUNT - 1; i >= 0; i--)
+    {
+        a = a * ACTION_COUNT + int(moves[i]);
+    }
+    return a;
+}
+
+inline void DecodeJointAction(JointAction a, Move moves[AGENT_COUNT])
+{
+    for(int i = 0; i < AGENT_COUNT; i++)
+    {
+        moves[i] = Move(a % ACTION_COUNT);
+        a /= ACTION_COUNT;
+    }
+}
+
+/**
+ * @brief CanonicalMove Maps moves that can't change the state (see
+ * strategy::LegalMoves) to IDLE
+ */
+inline Move CanonicalMove(strategy::MoveMask legal, Move m)
+{
+    return strategy::HasMove(legal, m) ? m : Move::IDLE;
+}
+
+/**
+ * @brief The Outcome struct is a distinct successor state that
+ * (possibly) many joint actions lead to
+ */
+struct Outcome
+{
+    State state;
+    uint64_t hash;
+
+    /**
+     * @brief action A canonical joint action that leads to this outcome
+     */
+    JointAction action;
+
+    /**
+     * @brief count The amount of (raw) joint actions that lead to
+     * this outcome
+     */
+    int count;
+};
+
+/**
+ * Steps every distinct canonical joint action of a state once and
+ * groups all JOINT_ACTION_COUNT joint actions by the successor state
+ * they produce. Successors are identified by their hash and
+ * confirmed by comparing the states. The move-independent part of the
+ * step (see PrepareStep) is computed only once per expansion.
+ *
+ * Holds all successors in fixed-size storage (~1.3 MB), so allocate it
+ * once (e.g. with std::make_unique) and reuse it for every expansion.
+ *
+ * @brief Expands a state into its distinct successors
+ */
+struct JointActionExpander
+{
+    Outcome outcomes[JOINT_ACTION_COUNT];
+    int outcomeCount = 0;
+
+    /**
+     * @brief outcomeOf The index of the outcome of every joint action
+     */
+    int16_t outcomeOf[JOINT_ACTION_COUNT];
+
+    /**
+     * @brief stepCount The amount of simulated joint actions in the
+     * last expansion (at most JOINT_ACTION_COUNT)
+     */
+    int stepCount = 0;
+
+    /**
+     * @brief Expand Computes all distinct successors of the given state
+     */
+    void Expand(const State& state);
+
+    /**
+     * @brief GetJointActions Writes all joint actions that lead to the
+     * specified outcome into `actions`
+     * @return The amount of written joint actions
+     */
+    int GetJointActions(int outcome, JointAction actions[JOINT_ACTION_COUNT]) const;
+
+private:
+
+    static const int TABLE_SIZE = 4096;
+    static_assert(TABLE_SIZE >= 2 * JOINT_ACTION_COUNT, "hash table too small");
+
+    State prepared;
+    int16_t table[TABLE_SIZE];
+    int16_t outcomeOfCanonical[JOINT_ACTION_COUNT];
+
+    int Insert(int slot);
+};
+
+}
+
+#endif // EXPANSION_H
@@ -0,0 +1,75 @@
+#ifndef FIXTURE_H
+#define FIXTURE_H
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "bboard.hpp"
+
+namespace bboard
+{
+
+/**
+ * A fixture is written as BOARD_SIZE rows of BOARD_SIZE cells,
+ * followed by property lines. `#` starts a comment, spaces inside a
+ * row are ignored.
+ *
+ *     .  passage        X  rigid          W  wood
+ *     e  extra bomb     r  range          k  kick
+ *     E  R  K           wood that hides e, r or k
+ *     0-3               an agent (agents that are not on the board
+ *                       are dead)
+ *     o                 a bomb (see the bomb line)
+ *
+ *     agent <id> [bombs=<max>] [strength=<s>] [kick]
+ *     bomb <x> <y> [owner=<id>] [timer=<t>] [strength=<s>]
+ *                  [dir=idle|up|down|left|right]
+ *     flame <x> <y> [strength=<s>] [timer=<t>] [owner=<id>]
+ *     moves <m0> <m1> <m2> <m3>   (idle, up, down, left, right, bomb)
+ *
+ * A bomb line may describe an `o` cell or a bomb below an agent. An
+ * `o` without a line is a bomb of the agent 0 with the full timer.
+ * The owner defaults to the agent on the cell and the strength to the
+ * owner's strength. Owners raise their bomb limit if they hold more
+ * bombs than it allows. Bombs and flames are queued by their timers,
+ * the way Step expects them.
+ *
+ * Every moves line is a joint action, the fixture plays them in a
+ * cycle (see Fixture::GetMoves).
+ *
+ * @brief A hand-written position, e.g. a test case or a worst case
+ * for benchmarks
+ */
+struct Fixture
+{
+    std::string name;
+    State state;
+    std::vector<std::array<Move, AGENT_COUNT>> moves;
+
+    /**
+     * @brief GetMoves The joint action of the given step (all idle if
+     * the fixture has no moves)
+     */
+    void GetMoves(int step, Move moves[AGENT_COUNT]) const;
+};
+
+/**
+ * @brief LoadFixture Builds a fixture from its text
+ * @param error If not null, receives the line and reason of a syntax
+ * error
+ * @return false if the text is not a valid fixture
+ */
+bool LoadFixture(const std::string& text, Fixture& fixture, std::string* error = nullptr);
+
+/**
+ * @brief PathologicalFixtures Worst-case positions of the engine:
+ * chain reactions of all bombs, ouroboros moves, colliding kicked
+ * bombs and crossing flames of the maximum strength. Aborts if an
+ * entry doesn't load.
+ */
+std::vector<Fixture> PathologicalFixtures();
+
+}
+
+#endif // FIXTURE_H
@@ -0,0 +1,222 @@
+#ifndef NET_H
+#define NET_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "bboard.hpp"
+
+namespace agents::net
+{
+
+/**
+ * @brief INPUT_PLANES The amount of feature planes that describe a
+ * state from the view of a single agent (see FillPlanes)
+ */
+const int INPUT_PLANES = 16;
+
+/**
+ * @brief PLANE_SIZE The planes are stored with a ring of zeros around
+ * the board (like BasicBoard), so 3x3 convolutions need no bounds checks
+ */
+const int PLANE_SIZE = bboard::BOARD_SIZE + 2;
+
+/**
+ * @brief PLANE_CELLS The amount of cells of a padded plane
+ */
+const int PLANE_CELLS = PLANE_SIZE * PLANE_SIZE;
+
+/**
+ * @brief POLICY_SIZE One output for every move (IDLE to BOMB)
+ */
+const int POLICY_SIZE = 6;
+
+/**
+ * @brief CHANNEL_ALIGN The channel count of every layer is rounded up
+ * to a multiple of this (the unused channels are zero)
+ */
+const int CHANNEL_ALIGN = 16;
+
+/**
+ * @brief The output of the network for one agent in one state
+ */
+struct Evaluation
+{
+    float policy[POLICY_SIZE]; // probabilities of the moves
+    float value;               // expected outcome in [-1, 1]
+};
+
+/**
+ * @brief The arithmetic of the convolutions. INT8 quantizes the weights
+ * per output channel and the activations per layer. The heads always
+ * use FP32.
+ */
+enum class Precision
+{
+    FP32 = 0,
+    INT8
+};
+
+/**
+ * @brief FillPlanes Encodes the state from the view of the given agent.
+ * The planes are stored channel-last: planes[cell * CHANNEL_ALIGN + c]
+ * with cell = (y + 1) * PLANE_SIZE + x + 1.
+ *
+ * Channels: rigid, wood, bomb, bomb time, bomb strength, moving bomb,
+ * flame, the three power-ups, the agent, the other agents, the agent's
+ * ammo, strength and kick (constant planes) and fog.
+ *
+ * @param planes PLANE_CELLS * CHANNEL_ALIGN floats
+ */
+void FillPlanes(const bboard::State& state, int agentID, float* planes);
+
+class Network;
+
+/**
+ * Evaluating a batch needs activation buffers that depend on the
+ * network and the batch size. A workspace grows on demand and can be
+ * reused for any amount of evaluations (one per thread).
+ *
+ * @brief Scratch memory of Network::Evaluate
+ */
+struct Workspace
+{
+    std::vector<float> input;
+    std::vector<float> a;
+    std::vector<float> b;
+    std::vector<uint8_t> q;
+    int stride = 0;
+
+    /**
+     * @brief Reserve Makes sure that a batch of `batch` states fits
+     */
+    void Reserve(const Network& network, int batch);
+};
+
+/**
+ * A small convolutional network with a policy and a value head:
+ *
+ *     input (16 planes) -> convLayers x [3x3 conv, ReLU]
+ *     policy: 1x1 conv (policyChannels), ReLU -> dense -> softmax
+ *     value:  1x1 conv (1 channel), ReLU -> dense (VALUE_HIDDEN), ReLU
+ *             -> dense -> tanh
+ *
+ * Weights file (little endian):
+ *
+ *     char[4] "PNET", int32 version (1),
+ *     int32 channels, int32 convLayers, int32 policyChannels,
+ *     float32 arrays in the following order (weights, then bias):
+ *       conv layer l:  [channels][3][3][in_l], [channels]
+ *                      (in_0 = INPUT_PLANES, otherwise channels)
+ *       policy conv:   [policyChannels][channels], [policyChannels]
+ *       policy dense:  [POLICY_SIZE][BOARD_SIZE^2][policyChannels], [POLICY_SIZE]
+ *       value conv:    [channels], [1]
+ *       value dense:   [VALUE_HIDDEN][BOARD_SIZE^2], [VALUE_HIDDEN]
+ *       value output:  [VALUE_HIDDEN], [1]
+ *
+ * @brief A policy/value network with a CPU inference engine
+ */
+class Network
+{
+
+public:
+
+    static const int VALUE_HIDDEN = 32;
+
+    /**
+     * @brief Init Sets up the given architecture with small random
+     * weights (returns false if the architecture is invalid)
+     */
+    bool Init(int channels, int convLayers, int policyChannels, uint64_t seed);
+
+    /**
+     * @brief Load Reads a weights file (see the class description).
+     * Returns false and keeps the current weights if the file can't be
+     * read or doesn't describe a valid network.
+     */
+    bool Load(const std::string& path);
+
+    /**
+     * @brief Save Writes the weights in the format that Load reads
+     */
+    bool Save(const std::string& path) const;
+
+    /**
+     * @brief Evaluate Evaluates `count` states, each from the view of
+     * one agent. The layers are applied to the whole batch one after
+     * another, so that the weights of a layer are reused while they
+     * are in the cache.
+     * @param states The states to evaluate
+     * @param agentIDs The agent whose view is evaluated in each state
+     * @param out `count` evaluations
+     */
+    void Evaluate(const bboard::State* const states[], const int agentIDs[], int count,
+                  Evaluation out[], Workspace& ws, Precision precision = Precision::FP32) const;
+
+    /**
+     * @brief Evaluate Evaluates a single state for a single agent
+     */
+    Evaluation Evaluate(const bboard::State& state, int agentID, Workspace& ws,
+                        Precision precision = Precision::FP32) const;
+
+    int GetChannels() const
+    {
+        return channels;
+    }
+    int GetConvLayers() const
+    {
+        return convLayers;
+    }
+    int GetPolicyChannels() const
+    {
+        return policyChannels;
+    }
+
+    /**
+     * @brief GetStride The (aligned) channel count of the activations
+     */
+    int GetStride() const
+    {
+        return stride;
+    }
+
+private:
+
+    int channels = 0;
+    int convLayers = 0;
+    int policyChannels = 0;
+    int stride = 0;
+
+    // conv weights in the evaluation layout: [out][3][3][stride] per
+    // layer (zero padded input channels)
+    std::vector<float> convWeights;
+    std::vector<float> convBias;
+
+    // int8 copy of the conv weights with one scale per output channel
+    std::vector<int8_t> convWeightsQ;
+    std::vector<float> convScaleQ;
+
+    std::vector<float> policyConv;     // [policyChannels][stride]
+    std::vector<float> policyConvBias; // [policyChannels]
+    std::vector<float> policyDense;    // [POLICY_SIZE][cells][policyChannels]
+    std::vector<float> policyBias;     // [POLICY_SIZE]
+
+    std::vector<float> valueConv;      // [stride]
+    float valueConvBias = 0;
+    std::vector<float> valueDense;     // [VALUE_HIDDEN][cells]
+    std::vector<float> valueDenseBias; // [VALUE_HIDDEN]
+    std::vector<float> valueOut;       // [VALUE_HIDDEN]
+    float valueOutBias = 0;
+
+    void Allocate(int channels, int convLayers, int policyChannels);
+    void Quantize();
+
+    void Convolve(int layer, const float* in, float* out, int count, Workspace& ws,
+                  Precision precision) const;
+    void Heads(const float* in, Evaluation& out) const;
+};
+
+}
+
+#endif
@@ -0,0 +1,181 @@
+#ifndef NTUPLE_H
+#define NTUPLE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "bboard.hpp"
+
+namespace agents::ntuple
+{
+
+/**
+ * @brief CELL_VALUES The amount of different cell codes (see EncodeCells)
+ */
+const int CELL_VALUES = 8;
+
+/**
+ * @brief TUPLE_CELLS Every tuple is a 2x2 square of cells
+ */
+const int TUPLE_CELLS = 4;
+
+/**
+ * @brief TUPLE_COUNT One tuple at every position where a square fits
+ */
+const int TUPLE_COUNT = (bboard::BOARD_SIZE - 1) * (bboard::BOARD_SIZE - 1);
+
+/**
+ * @brief TUPLE_ENTRIES The size of the weight table of a tuple
+ */
+const int TUPLE_ENTRIES = CELL_VALUES * CELL_VALUES * CELL_VALUES * CELL_VALUES;
+
+/**
+ * @brief STAT_ENTRIES The size of the table that is indexed by the
+ * agent's power-ups and the amount of living opponents
+ */
+const int STAT_ENTRIES = 4 * 6 * 2 * 4;
+
+/**
+ * @brief FEATURE_COUNT The amount of weights that make up a value
+ */
+const int FEATURE_COUNT = TUPLE_COUNT + 1;
+
+/**
+ * @brief EncodeCells Encodes every cell (x + BOARD_SIZE * y) of the
+ * state from the view of the given agent: passage (or fog), rigid,
+ * wood, bomb, flame, power-up, the agent itself and other agents.
+ */
+void EncodeCells(const bboard::State& state, int agentID, uint8_t cells[bboard::BOARD_SIZE * bboard::BOARD_SIZE]);
+
+/**
+ * Every 2x2 square of the board indexes its own table with the codes
+ * of its four cells. A small table adds the agent's ammo, bomb
+ * strength, kick and the amount of opponents alive. The value is the
+ * tanh of the sum of all FEATURE_COUNT weights, so an evaluation is a
+ * handful of table lookups.
+ *
+ * Weights file (little endian):
+ *
+ *     char[4] "NTUP", int32 version (1), int32 weight count,
+ *     float32 weights[TUPLE_COUNT][TUPLE_ENTRIES], float32 stats[STAT_ENTRIES]
+ *
+ * @brief An n-tuple network that estimates the outcome for an agent
+ */
+class NTupleNetwork
+{
+
+public:
+
+    NTupleNetwork();
+
+    /**
+     * @brief Evaluate The expected outcome in [-1, 1] for the agent
+     */
+    float Evaluate(const bboard::State& state, int agentID) const;
+
+    /**
+     * @brief Features Writes the FEATURE_COUNT weight indices that
+     * make up the value of the state
+     */
+    void Features(const bboard::State& state, int agentID, uint32_t features[FEATURE_COUNT]) const;
+
+    /**
+     * @brief Value The value of precomputed features
+     */
+    float Value(const uint32_t features[FEATURE_COUNT]) const;
+
+    /**
+     * @brief Load Reads a weights file. Returns false and keeps the
+     * current weights if the file is invalid.
+     */
+    bool Load(const std::string& path);
+
+    /**
+     * @brief Save Writes the weights in the format that Load reads
+     */
+    bool Save(const std::string& path) const;
+
+    std::vector<float>& GetWeights()
+    {
+        return weights;
+    }
+    const std::vector<float>& GetWeights() const
+    {
+        return weights;
+    }
+
+private:
+
+    std::vector<float> weights;
+};
+
+/**
+ * @brief GreedyMove The legal move whose successor (all other agents
+ * idle) has the highest value for the agent
+ */
+bboard::Move GreedyMove(const NTupleNetwork& network, const bboard::State& state, int agentID);
+
+/**
+ * @brief Parameters of the TD-learning self-play
+ */
+struct TrainingConfig
+{
+    int threads = 1;
+    int rounds = 10;
+
+    /**
+     * @brief games The amount of games per round. All games of a round
+     * are played with the same weights and their updates are applied
+     * together, so the thread count only changes the rounding.
+     */
+    int games = 8;
+    int maxSteps = 400;
+
+    float learningRate = 0.1f;
+
+    /**
+     * @brief epsilon The probability of a random (legal) move
+     */
+    float epsilon = 0.1f;
+    uint64_t seed = 0;
+
+    /**
+     * @brief symmetries Learn from all 8 dihedral transforms of every
+     * state (see TransformState) instead of the state alone
+     */
+    bool symmetries = false;
+};
+
+/**
+ * @brief Statistics of a training run
+ */
+struct TrainingStats
+{
+    long games = 0;
+    long steps = 0;
+    long updates = 0;
+
+    /**
+     * @brief error The mean absolute TD error of the last round
+     */
+    float error = 0;
+};
+
+/**
+ * Every agent picks the legal move whose successor (the other agents
+ * idle) it values most, or a random legal move with probability
+ * epsilon. After every step, the value of each living agent is moved
+ * towards its value in the next state (or the final outcome: won 1,
+ * died -1, draw or out of steps 0), TD(0). With symmetries, every
+ * transform of the states is updated the same way. The games of a
+ * round are split among the threads, each accumulates its updates
+ * separately.
+ *
+ * @brief Trains the network by self-play with bboard::Step
+ */
+TrainingStats TrainSelfPlay(NTupleNetwork& network, const TrainingConfig& config);
+
+}
+
+#endif // NTUPLE_H
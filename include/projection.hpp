@@ -0,0 +1,71 @@
+#ifndef PROJECTION_H
+#define PROJECTION_H
+
+#include <bitset>
+
+#include "bboard.hpp"
+
+namespace bboard::strategy
+{
+
+/**
+ * @brief PROJECTION_HORIZON The amount of ticks after which every bomb
+ * that is currently on the board has exploded and burned out
+ */
+const int PROJECTION_HORIZON = BOMB_LIFETIME + FLAME_LIFETIME;
+
+/**
+ * @brief FlameMask A single bit for every cell of the board. The
+ * cell (x, y) is at bit x + BOARD_SIZE * y
+ */
+typedef std::bitset<BOARD_SIZE * BOARD_SIZE> FlameMask;
+
+/**
+ * @brief The Timeline struct describes how the flames on a board evolve
+ * if no agent acts. flames[t] holds all burning cells t ticks from now
+ * (flames[0] are the flames of the projected state itself).
+ */
+struct Timeline
+{
+    FlameMask flames[PROJECTION_HORIZON + 1];
+
+    /**
+     * @brief ticks The amount of projected ticks. All masks after
+     * this tick are empty
+     */
+    int ticks = 0;
+
+    /**
+     * @brief IsFlame Returns true if (x, y) burns in the given tick
+     */
+    inline bool IsFlame(int tick, int x, int y) const
+    {
+        return flames[tick][x + BOARD_SIZE * y];
+    }
+
+    /**
+     * @brief NextFlame Returns the first tick (starting from `from`) in
+     * which the position (x, y) burns. -1 if it never burns.
+     */
+    int NextFlame(int x, int y, int from = 0) const;
+};
+
+/**
+ * @brief ProjectState Advances a copy of the given state without any
+ * agent acting (bomb timers, kicked bombs, chain explosions and the
+ * burning out of flames) and records the flames of every tick.
+ * Stops early when neither bombs nor flames are left.
+ * @param state The state to project
+ * @param timeline The timeline that will be filled
+ * @param ticks The maximum amount of ticks (at most PROJECTION_HORIZON)
+ */
+void ProjectState(const State& state, Timeline& timeline, int ticks = PROJECTION_HORIZON);
+
+/**
+ * @brief FillFlameMask Sets the bits of all burning cells of the given state
+ */
+void FillFlameMask(const State& state, FlameMask& mask);
+
+}
+
+#endif // PROJECTION_H
@@ -0,0 +1,116 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+
+#include "bboard.hpp"
+
+namespace bboard::search
+{
+
+static_assert(std::is_trivially_copyable<State>::value, "snapshots diff the words of a state");
+
+/**
+ * A snapshot is a parent link and a delta: the 32-bit words of the
+ * state (cells, agent records, bomb and flame slots, counters) that
+ * differ from the parent. Every changed word is stored as the gap to
+ * the previous changed word and the xor with the parent's word, both
+ * as varints, so a step usually costs a few dozen bytes instead of a
+ * full State. Every `checkpointInterval` levels, a node also keeps its
+ * full state, which bounds the cost of a rebuild.
+ *
+ * Applying a delta and undoing it are the same xor, so a state can
+ * walk from any node to any other node along the tree (see Move),
+ * e.g. from a leaf to its sibling with two deltas.
+ *
+ * @brief Stores the states of a search tree as copy-on-write deltas
+ */
+class SnapshotTree
+{
+
+public:
+
+    /**
+     * @param checkpointInterval The distance between full states (the
+     * root is always one)
+     */
+    SnapshotTree(int checkpointInterval = 32);
+
+    /**
+     * @brief AddRoot Clears the tree and adds the root state
+     * @return The index of the root (0)
+     */
+    int AddRoot(const State& state);
+
+    /**
+     * @brief Add Adds a child state
+     * @param parentState The state of the parent (see Restore)
+     * @return The index of the child
+     */
+    int Add(int parent, const State& parentState, const State& state);
+
+    /**
+     * @brief Restore Rebuilds the state of a node from the nearest
+     * checkpoint on its path (at most checkpointInterval deltas)
+     */
+    void Restore(int node, State& state) const;
+
+    /**
+     * @brief Move Turns the state of node `from` into the state of
+     * node `to` by undoing and applying the deltas on the path between
+     * them
+     */
+    void Move(int from, int to, State& state) const;
+
+    int GetParent(int node) const
+    {
+        return snapshots[node].parent;
+    }
+    int GetDepth(int node) const
+    {
+        return snapshots[node].depth;
+    }
+    int GetCount() const
+    {
+        return int(snapshots.size());
+    }
+
+    /**
+     * @brief Reserve Allocates room for the given amount of nodes
+     * @param deltaBytes The expected size of a delta
+     */
+    void Reserve(int nodes, int deltaBytes = 64);
+
+    /**
+     * @brief GetMemoryUsage The bytes held by the snapshots, deltas and
+     * checkpoints (only the used part)
+     */
+    size_t GetMemoryUsage() const;
+
+private:
+
+    static const int WORDS = sizeof(State) / sizeof(uint32_t);
+    static_assert(sizeof(State) % sizeof(uint32_t) == 0, "a state is made of words");
+
+    struct Snapshot
+    {
+        int parent;
+        int checkpoint; // -1 if the node has no full state
+        uint32_t offset; // of the delta
+        uint16_t depth;
+        uint16_t length; // of the delta in bytes
+    };
+
+    const int checkpointInterval;
+    std::vector<Snapshot> snapshots;
+    std::vector<uint8_t> deltas;
+    std::vector<State> checkpoints;
+
+    void Xor(int node, State& state) const;
+};
+
+}
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,159 @@
+#ifndef STATE_POOL_H
+#define STATE_POOL_H
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+
+#include "bboard.hpp"
+
+namespace bboard::search
+{
+
+static_assert(std::is_trivially_copyable<State>::value, "the pool clones states with memcpy");
+
+/**
+ * @brief Statistics of a state pool (see StatePool::GetCounters). The
+ * counters add up over the lifetime of the pool, Reset doesn't clear
+ * them.
+ */
+struct PoolCounters
+{
+    /**
+     * @brief acquires States handed out, including clones
+     */
+    uint64_t acquires = 0;
+    uint64_t releases = 0;
+    uint64_t clones = 0;
+
+    /**
+     * @brief allocations Slabs the pool took from the heap
+     */
+    uint64_t allocations = 0;
+
+    /**
+     * @brief transfers Batches moved between a thread's free list and
+     * the shared one (each takes the lock)
+     */
+    uint64_t transfers = 0;
+};
+
+/**
+ * States are allocated in slabs of cache-line-aligned slots, so two
+ * threads never write to the same line. The pool never frees a slab
+ * before it is destroyed and only allocates a new one when all states
+ * are in use, so a search that releases its states runs without heap
+ * allocations after the first decision.
+ *
+ * Every thread has its own free list in the pool. Acquire and Release
+ * only take a lock when that list is empty or full, then a batch of
+ * states moves from or to the shared list. A thread may release a
+ * state that another thread acquired.
+ *
+ * An acquired state holds whatever its last user left in it, use Clone
+ * or assign it before stepping.
+ *
+ * @brief A thread-safe pool of scratch states for searches and rollouts
+ */
+class StatePool
+{
+
+public:
+
+    /**
+     * @brief MAX_THREADS The threads with a free list of their own,
+     * further threads go through the shared list
+     */
+    static const int MAX_THREADS = 64;
+
+    /**
+     * @brief BATCH The states that move between the lists at once
+     */
+    static const int BATCH = 16;
+
+    /**
+     * @param slabSize The states per slab
+     * @param slabs The slabs that are allocated upfront
+     */
+    StatePool(int slabSize = 256, int slabs = 1);
+    ~StatePool();
+
+    StatePool(const StatePool&) = delete;
+    StatePool& operator=(const StatePool&) = delete;
+
+    /**
+     * @brief Acquire Takes a state from the pool (its content is
+     * unspecified)
+     */
+    State* Acquire();
+
+    /**
+     * @brief Clone Takes a state from the pool and copies the given
+     * state into it
+     */
+    State* Clone(const State& state);
+
+    /**
+     * @brief Release Returns a state to the pool
+     */
+    void Release(State* state);
+
+    /**
+     * @brief Reset Returns all states to the pool at once, e.g. between
+     * two searches. States that are still held become invalid. Not
+     * thread-safe.
+     */
+    void Reset();
+
+    PoolCounters GetCounters() const;
+
+    /**
+     * @brief GetCapacity The states in all slabs
+     */
+    int GetCapacity() const;
+
+private:
+
+    struct alignas(64) Slot
+    {
+        State state;
+    };
+
+    /**
+     * @brief The free list of one thread. Only the owner writes to it,
+     * the counters are atomic so GetCounters may read them.
+     */
+    struct alignas(64) Cache
+    {
+        State* free[2 * BATCH];
+        int count = 0;
+        std::atomic<uint64_t> acquires{0};
+        std::atomic<uint64_t> releases{0};
+        std::atomic<uint64_t> clones{0};
+    };
+
+    const int slabSize;
+
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<Slot[]>> slabs;
+    std::vector<State*> shared;
+    Cache caches[MAX_THREADS];
+
+    // guarded by the mutex
+    uint64_t allocations = 0;
+    uint64_t transfers = 0;
+    uint64_t sharedAcquires = 0;
+    uint64_t sharedReleases = 0;
+    std::atomic<uint64_t> sharedClones{0};
+
+    void Grow();
+    State* AcquireShared();
+    void ReleaseShared(State* state);
+};
+
+}
+
+#endif // STATE_POOL_H
@@ -0,0 +1,118 @@
+#ifndef STEP_LANES_H
+#define STEP_LANES_H
+
+#include "bboard.hpp"
+
+namespace bboard
+{
+
+/**
+ * @brief LANE_WIDTH The amount of lanes that fit into a single vector
+ * register of the target (16 with AVX-512, 8 otherwise)
+ */
+#if defined(__AVX512F__)
+const int LANE_WIDTH = 16;
+#else
+const int LANE_WIDTH = 8;
+#endif
+
+/**
+ * @brief LanesVectorized True if the target has vector instructions
+ * for W lanes (AVX2 for 8, AVX-512 for 16)
+ */
+constexpr bool LanesVectorized(int W)
+{
+#if defined(__AVX512F__)
+    const bool avx512 = true;
+#else
+    const bool avx512 = false;
+#endif
+#if defined(__AVX2__)
+    const bool avx2 = true;
+#else
+    const bool avx2 = false;
+#endif
+    return (W == 16 && avx512) || (W == 8 && avx2);
+}
+
+/**
+ * Holds W independent states in a transposed (struct-of-arrays)
+ * layout: every field is stored once per lane and the values of all
+ * lanes are adjacent in memory, so that a single vector holds the
+ * same field of all W games.
+ *
+ * The bomb and flame queues keep their ring-buffer layout (including
+ * the unused slots), which makes Load and Store lossless.
+ *
+ * @brief W states that are stepped together by StepLanes
+ */
+template<int W>
+struct StateLanes
+{
+    alignas(64) int board[BOARD_SIZE][BOARD_SIZE][W];
+
+    alignas(64) int agentX[AGENT_COUNT][W];
+    alignas(64) int agentY[AGENT_COUNT][W];
+    alignas(64) int bombCount[AGENT_COUNT][W];
+    alignas(64) int maxBombCount[AGENT_COUNT][W];
+    alignas(64) int bombStrength[AGENT_COUNT][W];
+    alignas(64) int canKick[AGENT_COUNT][W];
+    alignas(64) int dead[AGENT_COUNT][W];
+
+    alignas(64) int bombs[MAX_BOMBS][W];
+    alignas(64) int bombIndex[W];
+    alignas(64) int bombQueueCount[W];
+
+    alignas(64) int flameX[MAX_BOMBS][W];
+    alignas(64) int flameY[MAX_BOMBS][W];
+    alignas(64) int flameTime[MAX_BOMBS][W];
+    alignas(64) int flameStrength[MAX_BOMBS][W];
+    alignas(64) int flameOwner[MAX_BOMBS][W];
+    alignas(64) int flameIndex[W];
+    alignas(64) int flameQueueCount[W];
+
+    alignas(64) int timeStep[W];
+    alignas(64) int aliveAgents[W];
+
+    /**
+     * @brief Load Copies a state into the specified lane
+     */
+    void Load(int lane, const State& state);
+
+    /**
+     * @brief Store Copies the state of the specified lane into `state`
+     */
+    void Store(int lane, State& state) const;
+};
+
+/**
+ * Lanes in which the step only counts down timers, moves agents onto
+ * free passages and plants bombs are advanced with vector
+ * instructions. All other lanes (explosions, expiring flames, moving
+ * bombs, kicks, power-ups, agents that depend on each other, ...) are
+ * stepped by bboard::Step. Either way, every lane ends up exactly as
+ * if it was stepped by bboard::Step.
+ *
+ * Without vector instructions for W lanes (see LanesVectorized) the
+ * plain loops of the kernel are slower than bboard::Step, StepLanes
+ * then steps every lane with bboard::Step.
+ *
+ * @brief StepLanes Applies one step to every lane
+ * @param lanes The states
+ * @param moves The moves of all agents, per lane
+ * @return The amount of lanes that were stepped by bboard::Step
+ */
+template<int W>
+int StepLanes(StateLanes<W>& lanes, const Move moves[W][AGENT_COUNT]);
+
+/**
+ * @brief StepLanesKernel The lane kernel of StepLanes, also on targets
+ * without vector instructions (then it runs plain loops)
+ * @return The amount of lanes that were stepped by bboard::Step
+ */
+template<int W>
+int StepLanesKernel(StateLanes<W>& lanes, const Move moves[W][AGENT_COUNT]);
+
+}
+
+#endif // STEP_LANES_H
@@ -24,24 +24,135 @@ Position OriginPosition(int x, int y, Move m);
 /**
  * @brief DesiredPosition Returns the target position of the bomb. If it's
  * idle, the desired position will be its current position
+ * @tparam Format The bomb encoding of the board (see BombFormat)
  */
-Position DesiredPosition(const Bomb b);
+template<typename Format = State::Format>
+inline Position DesiredPosition(const Bomb b)
+{
+    return DesiredPosition(Format::PosX(b), Format::PosY(b), Move(Format::Dir(b)));
+}
+
+/**
+ * @brief The event buffer of the step that runs on this thread
+ * (nullptr if the step doesn't report events)
+ */
+extern thread_local StepEvents* activeEvents;
+
+/**
+ * @brief RecordEvent Adds an event to the active event buffer (if any)
+ */
+inline void RecordEvent(EventType type, int agent, int x, int y, int value = 0)
+{
+    if(activeEvents)
+    {
+        activeEvents->Add(type, agent, x, y, value);
+    }
+}
+
+/**
+ * @brief FlameOwner Returns the owner of the flame item on the
+ * given cell, -1 if it is unknown
+ */
+template<int S, int N>
+int FlameOwner(const BasicState<S, N>& state, int x, int y);
+
+/**
+ * During the bomb movement agents only move in AgentBombChainReversion,
+ * which keeps the index up to date, and the bomb destinations don't
+ * change. So the index is filled once per tick, the first time a chain
+ * has to be reverted.
+ *
+ * @brief CellIndex The agents on every cell and the bomb that wants
+ * to move onto it
+ */
+template<int S, int N>
+struct CellIndex
+{
+    static_assert(N <= 32, "the agents of a cell are a 32 bit mask");
+
+    bool filled = false;
+
+    /**
+     * @brief agents Bit i is set if agent i stands on the cell
+     */
+    uint32_t agents[S * S];
+
+    /**
+     * @brief bombs The first bomb in the queue whose destination is
+     * the cell, -1 if there is none
+     */
+    int16_t bombs[S * S];
+
+    /**
+     * @brief Fill Indexes the living agents and the given bomb
+     * destinations (see FillBombDestPos)
+     */
+    void Fill(const BasicState<S, N>& state, const Position bombDest[])
+    {
+        std::fill_n(agents, S * S, 0);
+        std::fill_n(bombs, S * S, -1);
+        for(int i = 0; i < N; i++)
+        {
+            if(!state.agents[i].dead)
+            {
+                agents[state.agents[i].x + S * state.agents[i].y] |= uint32_t(1) << i;
+            }
+        }
+        for(int i = state.bombs.count - 1; i >= 0; i--)
+        {
+            const Position p = bombDest[i];
+            if(p.x >= 0 && p.x < S && p.y >= 0 && p.y < S)
+            {
+                bombs[p.x + S * p.y] = int16_t(i);
+            }
+        }
+        filled = true;
+    }
+
+    /**
+     * @brief Agent The living agent with the lowest ID on the given
+     * cell (like BasicState::GetAgent), -1 if there is none
+     */
+    int Agent(const BasicState<S, N>& state, Position p) const
+    {
+        // agents that died this tick are still in the mask
+        for(uint32_t mask = agents[p.x + S * p.y]; mask != 0; mask &= mask - 1)
+        {
+            const int i = __builtin_ctz(mask);
+            if(!state.agents[i].dead)
+            {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    void MoveAgent(int agentID, Position from, Position to)
+    {
+        agents[from.x + S * from.y] &= ~(uint32_t(1) << agentID);
+        agents[to.x + S * to.y] |= uint32_t(1) << agentID;
+    }
+};
 
 /**
  * @brief RevertAgentMove Moves back a specified agent and bounces back every
- * agent or bomb that stands in its way recursively.
+ * agent or bomb that stands in its way, one hop of the chain at a time.
  * The bomb dest is an array of desired destination positions of bombs. That way
  * we don't need to read the direction and find out if they've been alraedy moved
+ * @param cells The index of the tick (filled on first use), so every
+ * hop is a constant number of lookups
  * @return The position of the last agent/bomb that was bounced back in the chain.
  */
-Position AgentBombChainReversion(State& state, Move moves[AGENT_COUNT],
-                                 Position bombDest[MAX_BOMBS], int agentID);
+template<int S, int N>
+Position AgentBombChainReversion(BasicState<S, N>& state, Move moves[N],
+                                 Position bombDest[], CellIndex<S, N>& cells, int agentID);
 
 /**
  * @brief FillPositions Fills an array of Positions with positions of
  * all agents of the given state.
  */
-void FillPositions(State* s, Position p[AGENT_COUNT]);
+template<int S, int N>
+void FillPositions(BasicState<S, N>* s, Position p[N]);
 
 /**
  * @brief FillDestPos Fills an array of destination positions.
@@ -49,46 +160,116 @@ void FillPositions(State* s, Position p[AGENT_COUNT]);
  * @param m An array of all agent moves
  * @param p The array to be filled wih dest positions
  */
-void FillDestPos(State* s, Move m[AGENT_COUNT], Position p[AGENT_COUNT]);
+template<int S, int N>
+void FillDestPos(BasicState<S, N>* s, Move m[N], Position p[N]);
 
 /**
  * @brief FillBombDestPos Fills the given array p with all desired bomb
  * positions that moving bombs are anticipating
  */
-void FillBombDestPos(State* s, Position p[MAX_BOMBS]);
+template<int S, int N>
+void FillBombDestPos(BasicState<S, N>* s, Position p[]);
 
 /**
  * @brief FixSwitchMove Fixes the desired positions if the agents want
- * switch places in one step.
+ * switch places in one step. Dead agents are ignored.
  * @param s The state
  * @param desiredPositions an array of desired positions
  */
-void FixSwitchMove(State* s, Position desiredPositions[AGENT_COUNT]);
+template<int S, int N>
+void FixSwitchMove(BasicState<S, N>* s, Position desiredPositions[N]);
 
 /**
  * TODO: Fill doc for dependency resolving
  *
  */
-int ResolveDependencies(State* s, Position des[AGENT_COUNT],
-                        int dependency[AGENT_COUNT], int chain[AGENT_COUNT]);
+template<int S, int N>
+int ResolveDependencies(BasicState<S, N>* s, Position des[N],
+                        int dependency[N], int chain[N]);
+
+/**
+ * Does the work of FixSwitchMove, ResolveDependencies and
+ * HasDPCollision (for every agent) with the exact same results. With
+ * cellTable, agents and destinations are looked up in a hash table
+ * over cells instead of comparing all pairs of agents, which takes
+ * linear time in the amount of agents. The pairwise comparisons are
+ * cheaper for up to four agents.
+ *
+ * @brief ResolveMovement Resolves swaps, movement dependencies and
+ * destination conflicts of all agents
+ * @param des The desired positions, swaps are fixed in place
+ * @param dependency Filled like in ResolveDependencies (must be
+ * initialized with -1)
+ * @param chain Receives the chain roots
+ * @param collision collision[i] is true if agent i has a destination
+ * position collision (see HasDPCollision)
+ * @param cellTable Use the hash table (default for more than four agents)
+ * @return The amount of chain roots
+ */
+template<int S, int N>
+int ResolveMovement(BasicState<S, N>* s, Position des[N], int dependency[N],
+                    int chain[N], bool collision[N], bool cellTable = (N > 4));
 
 /**
  * @brief TickFlames Counts down all flames in the flame queue
  * (and possible extinguishes the flame)
  */
-void TickFlames(State& state);
+template<int S, int N>
+void TickFlames(BasicState<S, N>& state);
 
 /**
  * @brief TickBombs Counts down all bomb timers and explodes them
  * if they arrive at 10
  */
-void TickBombs(State& state);
+template<int S, int N>
+void TickBombs(BasicState<S, N>& state);
+
+/**
+ * @brief ReduceBombTimers Counts down all bomb timers (first half
+ * of TickBombs)
+ */
+template<int S, int N>
+void ReduceBombTimers(BasicState<S, N>& state);
+
+/**
+ * @brief ExplodeBombs Explodes all bombs whose timer arrived at 0
+ * (second half of TickBombs)
+ */
+template<int S, int N>
+void ExplodeBombs(BasicState<S, N>& state);
+
+/**
+ * @brief MoveBombs Moves all kicked bombs by 1 position and resolves
+ * their collisions with obstacles, agents and other bombs. Agents that
+ * kicked a bomb which can't move are bounced back.
+ * @param moves The moves the agents made in this step
+ * @param oldPos The agent positions before the agents moved
+ */
+template<int S, int N>
+void MoveBombs(BasicState<S, N>& state, Move moves[N], Position oldPos[N]);
+
+/**
+ * @brief ClassifyBombPhase Picks the kernel for the bomb phase of a tick
+ * whose agent movement has been resolved. BOMBS_AT_REST is only returned
+ * if MoveBombs would not move or bounce anything.
+ */
+template<int S, int N>
+StepKernel ClassifyBombPhase(const BasicState<S, N>& state, Move moves[N], Position oldPos[N]);
+
+/**
+ * @brief MoveBombsAtRest Does what MoveBombs does for a tick that
+ * ClassifyBombPhase considers BOMBS_AT_REST: it only restores bomb items
+ * and explodes bombs that lie in flames.
+ */
+template<int S, int N>
+void MoveBombsAtRest(BasicState<S, N>& state);
 
 /**
  * @brief MoveBombsForward moves all bombs forward that have been
- * kicked before by 1 position.
+ * kicked before by 1 position (assumes that no agent moved)
  */
-void MoveBombsForward(State& state);
+template<int S, int N>
+void MoveBombsForward(BasicState<S, N>& state);
 
 /**
  * @brief ConsumePowerup Lets an agent consume a powerup
@@ -96,7 +277,8 @@ void MoveBombsForward(State& state);
  * @param powerUp A powerup item. If it's something else,
  * this function will do nothing.
  */
-void ConsumePowerup(State& state, int agentID, int powerUp);
+template<int S, int N>
+void ConsumePowerup(BasicState<S, N>& state, int agentID, int powerUp);
 
 /**
  * @brief PrintDependency Prints a dependency array in a nice
@@ -120,7 +302,8 @@ void PrintDependencyChain(int dependency[AGENT_COUNT], int chain[AGENT_COUNT]);
  * @param The agent that's checked for collisions
  * @return True if there is at least one collision
  */
-bool HasDPCollision(const State& state, Position dp[AGENT_COUNT], int agentID);
+template<int S, int N>
+bool HasDPCollision(const BasicState<S, N>& state, Position dp[N], int agentID);
 
 /**
  * @brief HasBombCollision Checks wether a bomb collides with another bomb
@@ -129,7 +312,8 @@ bool HasDPCollision(const State& state, Position dp[AGENT_COUNT], int agentID);
  * considered
  * @return True if the given bomb collides with another bomb
  */
-bool HasBombCollision(const State& state, const Bomb& b, int index = 0);
+template<int S, int N>
+bool HasBombCollision(const BasicState<S, N>& state, const Bomb& b, int index = 0);
 
 /**
  * @brief ResolveBombMovementollision Checks if a specified bomb collides
@@ -140,29 +324,33 @@ bool HasBombCollision(const State& state, const Bomb& b, int index = 0);
  * @param index Only bombs with a queue index larger or equal to `index` will be
  * considered
  */
-void ResolveBombCollision(State& state, Move moves[AGENT_COUNT],
-                          Position bombDest[MAX_BOMBS], int index = 0);
+template<int S, int N>
+void ResolveBombCollision(BasicState<S, N>& state, Move moves[N],
+                          Position bombDest[], CellIndex<S, N>& cells, int index = 0);
 
 /**
  * @brief ResetBombFlags Resets the "moved" flag of each bomb in the state
  * back to false.
  */
-void ResetBombFlags(State& state);
+template<int S, int N>
+void ResetBombFlags(BasicState<S, N>& state);
 
 /**
  * @brief IsOutOfBounds Checks wether a given position is out of bounds
+ * of a board with the given size
  */
-inline bool IsOutOfBounds(const Position& pos)
+inline bool IsOutOfBounds(const Position& pos, const int size = BOARD_SIZE)
 {
-    return pos.x < 0 || pos.y < 0 || pos.x >= BOARD_SIZE || pos.y >= BOARD_SIZE;
+    return pos.x < 0 || pos.y < 0 || pos.x >= size || pos.y >= size;
 }
 
 /**
  * @brief IsOutOfBounds Checks wether a given position is out of bounds
+ * of a board with the given size
  */
-inline bool IsOutOfBounds(const int& x, const int& y)
+inline bool IsOutOfBounds(const int& x, const int& y, const int size = BOARD_SIZE)
 {
-    return x < 0 || y < 0 || x >= BOARD_SIZE || y >= BOARD_SIZE;
+    return x < 0 || y < 0 || x >= size || y >= size;
 }
 
 }
@@ -1,7 +1,10 @@
 #ifndef STRATEGY_H
 #define STRATEGY_H
 
+#include <random>
+
 #include "bboard.hpp"
+#include "projection.hpp"
 #include "step_utility.hpp"
 
 // integer with less than 4 bytes will have bugs
@@ -62,6 +65,88 @@ inline bool IsReachable(RMap& r, int x, int y)
     return r.GetDistance(x, y) != 0;
 }
 
+////////////////
+// Danger Map //
+////////////////
+
+/**
+ * @brief The DangerMap struct holds the danger value (see IsInDanger)
+ * of every position on the board
+ */
+struct DangerMap
+{
+    int map[BOARD_SIZE][BOARD_SIZE];
+
+    /**
+     * @brief Get Returns the time until a bomb that can reach (x, y)
+     * explodes. 0 if (x, y) is safe.
+     */
+    inline int Get(int x, int y) const
+    {
+        return map[y][x];
+    }
+};
+
+/**
+ * @brief FillDangerMap Computes the danger value of every position
+ * of the board (same result as IsInDanger for all positions)
+ */
+void FillDangerMap(const State& s, DangerMap& d);
+
+////////////////
+// Move Masks //
+////////////////
+
+/**
+ * @brief MoveMask A set of moves. Bit i is set if Move(i) is
+ * part of the set (6 bits)
+ */
+typedef uint8_t MoveMask;
+
+const MoveMask ALL_MOVES = 0b111111;
+
+inline MoveMask MoveBit(Move m)
+{
+    return MoveMask(1 << int(m));
+}
+
+inline bool HasMove(MoveMask mask, Move m)
+{
+    return (mask & MoveBit(m)) != 0;
+}
+
+/**
+ * @brief LegalMoves Fills the legal moves of all agents. A move is
+ * legal if it can change the state: walking out of bounds, into rigid
+ * walls or wood (same as IDLE) and planting with maxed out bombs
+ * are excluded. Dead agents can only IDLE.
+ */
+void LegalMoves(const State& state, MoveMask legal[AGENT_COUNT]);
+
+/**
+ * @brief RandomLegalMove A uniformly drawn move of the mask (IDLE if
+ * the mask is empty)
+ */
+Move RandomLegalMove(MoveMask legal, std::mt19937_64& rng);
+
+/**
+ * @brief TerminalValue The outcome of the state for the given agent if
+ * the game is over for it (lost: -1, won: 1, all dead: 0)
+ * @return false if the agent and one of its opponents are alive
+ */
+bool TerminalValue(const State& state, int id, float& value);
+
+/**
+ * @brief NonFatalMoves Filters the legal moves of all agents, leaving
+ * only those whose destination doesn't burn in the next tick (see
+ * Timeline). A mask can be 0 if every move is fatal.
+ * @param timeline The projection of the state
+ * @param legal The legal moves of all agents
+ * @param nonFatal The array that will be filled
+ */
+void NonFatalMoves(const State& state, const Timeline& timeline,
+                   const MoveMask legal[AGENT_COUNT], MoveMask nonFatal[AGENT_COUNT]);
+
 //////////////
 // Movement //
 //////////////
@@ -97,6 +182,12 @@ Move MoveTowardsPosition(const RMap& r, const Position& position);
  */
 Move MoveTowardsSafePlace(const State& state, const RMap& r, int radius);
 
+/**
+ * @brief MoveTowardsSafePlace Same as above, reads the danger values
+ * from a filled DangerMap
+ */
+Move MoveTowardsSafePlace(const DangerMap& d, const RMap& r, int radius);
+
 /**
  * @brief MoveTowardsPowerup Returns the move that brings the agent
  * closer to a powerup in a specified radius. If no nearby powerup is
@@ -123,6 +214,13 @@ Move MoveTowardsEnemy(const State& state, const RMap& r, int radius);
  */
 void SafeDirections(const State& state, FixedQueue<Move, MOVE_COUNT>& q, int x, int y);
 
+/**
+ * @brief SafeDirections Same as above, reads the danger values
+ * from a filled DangerMap
+ */
+void SafeDirections(const State& state, const DangerMap& d,
+                    FixedQueue<Move, MOVE_COUNT>& q, int x, int y);
+
 /**
  * @brief SortDirections Sort a move-queue, where unvisited states are
  * last in the queue
@@ -0,0 +1,119 @@
+#ifndef SYMMETRY_H
+#define SYMMETRY_H
+
+#include <utility>
+
+#include "bboard.hpp"
+
+namespace bboard
+{
+
+/**
+ * @brief SYMMETRY_COUNT The amount of dihedral transforms of the
+ * square board (rotations and reflections, 0 is the identity)
+ */
+const int SYMMETRY_COUNT = 8;
+
+/**
+ * Transform t first swaps x and y (bit 2), then mirrors x (bit 0)
+ * and y (bit 1).
+ *
+ * @brief TransformPosition Maps a position of an S x S board
+ */
+template<int S>
+inline Position TransformPosition(int t, Position p)
+{
+    if(t & 4)
+    {
+        std::swap(p.x, p.y);
+    }
+    if(t & 1)
+    {
+        p.x = S - 1 - p.x;
+    }
+    if(t & 2)
+    {
+        p.y = S - 1 - p.y;
+    }
+    return p;
+}
+
+/**
+ * @brief InverseTransform The transform that undoes t
+ */
+inline int InverseTransform(int t)
+{
+    // after a swap, the mirrors apply to the other axis
+    return (t & 4) ? (4 | (t & 1) << 1 | (t & 2) >> 1) : t;
+}
+
+/**
+ * @brief TransformMove Maps a move (or a bomb direction) so that it
+ * points the same way on the transformed board. IDLE and BOMB stay.
+ */
+inline Move TransformMove(int t, Move m)
+{
+    if(m == Move::IDLE || m == Move::BOMB)
+    {
+        return m;
+    }
+    const bool vertical = m == Move::UP || m == Move::DOWN;
+    bool positive = m == Move::DOWN || m == Move::RIGHT;
+    const bool nowVertical = (t & 4) ? !vertical : vertical;
+    if(nowVertical ? (t & 2) : (t & 1))
+    {
+        positive = !positive;
+    }
+    if(nowVertical)
+    {
+        return positive ? Move::DOWN : Move::UP;
+    }
+    return positive ? Move::RIGHT : Move::LEFT;
+}
+
+/**
+ * Maps the board (including the origins that flame cells refer to),
+ * the agent positions, the bomb positions and directions and the
+ * flame positions. The agent IDs and the queue orders stay, so
+ * Step(T(s), T(m)) == T(Step(s, m)) as long as no flame reaches a
+ * bomb. SpawnFlame walks its rays in a fixed order (x+1, x-1, y+1,
+ * y-1) and sets reached bombs off at once, so the flame origins, the
+ * destroyed wood and even the deaths of chain reactions depend on
+ * the orientation.
+ *
+ * The board is permuted with a precomputed table in a single
+ * branchless pass.
+ *
+ * @brief TransformState Writes the transform t of a state into out
+ * (out must not be the state itself)
+ */
+template<int S, int N>
+void TransformState(const BasicState<S, N>& state, BasicState<S, N>& out, int t);
+
+/**
+ * The transforms are ordered by their boards (cell by cell in row
+ * major order), ties by the hash of the transformed state. Usually the
+ * first few cells decide, so only the chosen transform is computed.
+ *
+ * @brief CanonicalTransform The transform that maps the state to its
+ * canonical form, the same form for all symmetric states
+ */
+template<int S, int N>
+int CanonicalTransform(const BasicState<S, N>& state);
+
+/**
+ * Symmetric states don't always have symmetric futures (see
+ * TransformState), so the canonical hash only suits approximate
+ * sharing and never exact transposition lookups.
+ *
+ * @brief CanonicalHash The hash (see HashState) of the canonical form,
+ * equal for all symmetric states
+ * @param transform If set, receives the canonical transform (map
+ * moves with TransformMove to store them in the canonical frame)
+ */
+template<int S, int N>
+uint64_t CanonicalHash(const BasicState<S, N>& state, int* transform = nullptr);
+
+}
+
+#endif // SYMMETRY_H
@@ -0,0 +1,163 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace bboard::trace
+{
+
+/**
+ * @brief The groups of spans a trace can record (see Start)
+ */
+enum Category
+{
+    ENGINE = 1,      // Step and its phases (only with BBOARD_TRACE, see EngineSpan)
+    AGENTS = 2,      // Agent::act
+    ENVIRONMENT = 4, // Environment::Step, the move collection, the listener and printing
+    ALL = ENGINE | AGENTS | ENVIRONMENT
+};
+
+/**
+ * @brief Statistics of the current (or last) trace
+ */
+struct TraceCounters
+{
+    uint64_t events = 0;
+    /**
+     * @brief dropped Spans that ended while the trace was full
+     */
+    uint64_t dropped = 0;
+    uint64_t threads = 0;
+};
+
+/**
+ * @brief activeCategories The categories that are recorded, 0 if
+ * nothing is traced
+ */
+inline std::atomic<int> activeCategories{0};
+
+inline bool IsTracing(Category category)
+{
+    return (activeCategories.load(std::memory_order_relaxed) & category) != 0;
+}
+
+inline int64_t Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Every thread appends to a buffer of its own without locks, it only
+ * locks to get a new buffer when the current one is full. The buffers
+ * of finished threads are reused by new ones, so the short-lived
+ * threads of the competitive time limit don't waste memory.
+ *
+ * Spans must not be open while Start is called (the buffers of the
+ * last trace are freed).
+ *
+ * @brief Start Starts recording the given categories. The trace is
+ * written to the file by Stop, or at shutdown if Stop isn't called.
+ * @param maxEvents The events the trace holds, further spans are
+ * dropped
+ * @return false if a trace is running or the file can't be created
+ */
+bool Start(const std::string& path, int categories = ALL, size_t maxEvents = size_t(1) << 20);
+
+/**
+ * @brief Stop Stops recording and writes the trace as Chrome JSON
+ * (load it in chrome://tracing or ui.perfetto.dev)
+ * @return false if no trace was running or it couldn't be written
+ */
+bool Stop();
+
+TraceCounters GetTraceCounters();
+
+/**
+ * @brief Record Adds a finished span to the calling thread's buffer
+ */
+void Record(Category category, const char* name, int agent, int64_t begin, int64_t end);
+
+/**
+ * A span costs a relaxed load if its category isn't traced.
+ *
+ * @brief Records the time from its construction to End or its
+ * destruction
+ */
+class Span
+{
+
+public:
+
+    /**
+     * @param name A string literal (only the pointer is stored)
+     * @param agent Shown as an argument of the span, -1 for none
+     */
+    Span(Category category, const char* name, int agent = -1)
+    {
+        if(IsTracing(category))
+        {
+            this->category = category;
+            this->name = name;
+            this->agent = agent;
+            begin = Now();
+        }
+    }
+
+    ~Span()
+    {
+        End();
+    }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+    /**
+     * @brief End Ends the span before its destruction
+     */
+    void End()
+    {
+        if(begin >= 0)
+        {
+            Record(category, name, agent, begin, Now());
+            begin = -1;
+        }
+    }
+
+private:
+
+    Category category = ENGINE;
+    const char* name = nullptr;
+    int agent = -1;
+    int64_t begin = -1;
+};
+
+/**
+ * Step runs millions of times per second in searches, even a relaxed
+ * load per phase shows up there. Its spans are only compiled if
+ * BBOARD_TRACE is defined (e.g. `make CFLAGS="-pthread -DBBOARD_TRACE"`).
+ *
+ * @brief EngineSpan A Span with BBOARD_TRACE, nothing otherwise
+ */
+#if defined(BBOARD_TRACE)
+const bool ENGINE_SPANS = true;
+typedef Span EngineSpan;
+#else
+const bool ENGINE_SPANS = false;
+class EngineSpan
+{
+
+public:
+
+    EngineSpan(Category, const char*) {}
+    void End() {}
+};
+#endif
+
+}
+
+#endif // TRACE_H
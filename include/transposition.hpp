@@ -0,0 +1,219 @@
+#ifndef TRANSPOSITION_H
+#define TRANSPOSITION_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+#include "bboard.hpp"
+
+namespace bboard::search
+{
+
+/**
+ * @brief What a transposition table stores for a position
+ */
+struct TTData
+{
+    /**
+     * @brief value In [-1, 1], stored with 16 bits
+     */
+    float value = 0;
+
+    /**
+     * @brief count The amount of samples in the value (or any other
+     * measure of the work behind it, e.g. a search depth). The
+     * replacement policies keep entries with a high count.
+     */
+    int count = 0;
+    Move move = Move::IDLE;
+};
+
+/**
+ * @brief Which entry of a full bucket a new position replaces
+ */
+enum class Replacement
+{
+    /**
+     * @brief ALWAYS A fixed entry per position, new positions always win
+     */
+    ALWAYS,
+
+    /**
+     * @brief COUNT The entry with the lowest count
+     */
+    COUNT,
+
+    /**
+     * @brief AGING Entries from older generations (see NewGeneration)
+     * first, then the lowest count
+     */
+    AGING
+};
+
+/**
+ * @brief Statistics of a transposition table (see
+ * TranspositionTable::GetCounters)
+ */
+struct TTCounters
+{
+    uint64_t probes = 0;
+    uint64_t hits = 0;
+    uint64_t stores = 0;
+
+    /**
+     * @brief collisions Stores that overwrote the entry of another
+     * position
+     */
+    uint64_t collisions = 0;
+
+    double HitRate() const
+    {
+        return probes == 0 ? 0.0 : double(hits) / probes;
+    }
+};
+
+/**
+ * Entries are two 64-bit words: the data (value, count, move and
+ * generation) and the key xor the data. Both words are written and
+ * read with relaxed atomics and without locks. A reader only accepts
+ * an entry if the words xor to its key, so an entry that is torn by a
+ * concurrent write reads as a miss. Concurrent updates of the same
+ * entry may lose a sample, which is fine for a cache.
+ *
+ * Four entries form a 64-byte bucket. The table is a power of two
+ * buckets that is mapped with mmap and advised to use transparent huge
+ * pages (MADV_HUGEPAGE), so probes rarely miss the TLB.
+ *
+ * Keys are 64-bit hashes, usually HashState(state) (see Key to store
+ * one value per agent). Two positions with the same key share an
+ * entry.
+ *
+ * @brief A fixed-size lock-free transposition table that many
+ * threads can share
+ */
+class TranspositionTable
+{
+
+public:
+
+    static const int BUCKET_SIZE = 4;
+
+    /**
+     * @param megabytes The size of the table, rounded down to a power
+     * of two buckets
+     */
+    TranspositionTable(size_t megabytes = 64, Replacement replacement = Replacement::AGING);
+    ~TranspositionTable();
+
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    /**
+     * @brief Key Combines a state hash with an agent, for tables that
+     * store one value per agent
+     */
+    static uint64_t Key(uint64_t hash, int agentID)
+    {
+        return hash ^ (uint64_t(agentID + 1) * 0x9E3779B97F4A7C15ULL);
+    }
+
+    /**
+     * @brief Probe Reads the entry of the key
+     * @return true if the key is stored
+     */
+    bool Probe(uint64_t key, TTData& data);
+
+    /**
+     * @brief Store Writes the data of the key
+     */
+    void Store(uint64_t key, const TTData& data);
+
+    /**
+     * @brief AddSample Adds a value to the running mean of the key
+     * (count: samples, capped at 65535)
+     * @return The merged entry
+     */
+    TTData AddSample(uint64_t key, float value);
+
+    /**
+     * @brief NewGeneration Marks the current entries as old (e.g. when
+     * a new move is searched)
+     */
+    void NewGeneration()
+    {
+        generation.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Clear Empties the table and resets the counters. Not
+     * thread-safe.
+     */
+    void Clear();
+
+    TTCounters GetCounters() const;
+
+    size_t GetEntryCount() const
+    {
+        return bucketCount * BUCKET_SIZE;
+    }
+    size_t GetSize() const
+    {
+        return bucketCount * sizeof(Bucket);
+    }
+
+    /**
+     * @brief IsHugePageBacked true if the kernel accepted MADV_HUGEPAGE
+     */
+    bool IsHugePageBacked() const
+    {
+        return hugePages;
+    }
+
+private:
+
+    struct Entry
+    {
+        std::atomic<uint64_t> check; // key ^ data
+        std::atomic<uint64_t> data;
+    };
+
+    struct alignas(64) Bucket
+    {
+        Entry entries[BUCKET_SIZE];
+    };
+
+    /**
+     * @brief Counters are striped over cache lines, so threads don't
+     * contend on them
+     */
+    struct alignas(64) CounterStripe
+    {
+        std::atomic<uint64_t> probes{0};
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> stores{0};
+        std::atomic<uint64_t> collisions{0};
+    };
+    static const int STRIPES = 16;
+
+    Bucket* buckets = nullptr;
+    size_t bucketCount = 0;
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+    bool hugePages = false;
+
+    const Replacement replacement;
+    std::atomic<uint8_t> generation{0};
+    CounterStripe counters[STRIPES];
+
+    Bucket& BucketOf(uint64_t key) const
+    {
+        return buckets[(key >> 16) & (bucketCount - 1)];
+    }
+    static CounterStripe& Stripe(CounterStripe* counters);
+    int Victim(const Bucket& b, uint64_t key) const;
+};
+
+}
+
+#endif // TRANSPOSITION_H
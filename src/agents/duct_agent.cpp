@@ -0,0 +1,22 @@
+#include "bboard.hpp"
+#include "agents.hpp"
+#include "duct.hpp"
+
+using namespace bboard;
+
+namespace agents
+{
+
+DUCTAgent::DUCTAgent(int iterations, int maxNodes, search::Selection selection, uint64_t seed)
+    : search(maxNodes, seed), iterations(iterations)
+{
+    search.selection = selection;
+}
+
+Move DUCTAgent::act(const State* state)
+{
+    search.Search(*state, iterations);
+    return search.BestMove(id);
+}
+
+}
@@ -0,0 +1,124 @@
+#include <algorithm>
+
+#include "bboard.hpp"
+#include "evaluation_queue.hpp"
+
+using namespace bboard;
+
+namespace agents::net
+{
+
+EvaluationQueue::EvaluationQueue(const Network& network, int maxBatch,
+                                 std::chrono::microseconds maxWait, Precision precision)
+    : network(network), maxBatch(std::max(1, maxBatch)), maxWait(maxWait), precision(precision)
+{
+    queue.reserve(4 * this->maxBatch);
+    worker = std::thread(&EvaluationQueue::Run, this);
+}
+
+EvaluationQueue::~EvaluationQueue()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    submitted.notify_one();
+    worker.join();
+}
+
+void EvaluationQueue::Submit(EvaluationRequest& request)
+{
+    request.ready.store(false, std::memory_order_relaxed);
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(queue.empty())
+        {
+            oldest = std::chrono::steady_clock::now();
+        }
+        queue.push_back(&request);
+        // the worker only needs to wake up for the first request of a
+        // batch and for a full batch
+        wake = queue.size() == 1 || int(queue.size()) >= maxBatch;
+    }
+    if(wake)
+    {
+        submitted.notify_one();
+    }
+}
+
+void EvaluationQueue::Wait(const EvaluationRequest& request)
+{
+    if(request.IsReady())
+    {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    evaluated.wait(lock, [&request] { return request.IsReady(); });
+}
+
+Evaluation EvaluationQueue::Evaluate(const State& state, int agentID)
+{
+    EvaluationRequest r;
+    r.state = &state;
+    r.agentID = agentID;
+    Submit(r);
+    Wait(r);
+    return r.result;
+}
+
+void EvaluationQueue::Run()
+{
+    Workspace ws;
+    ws.Reserve(network, maxBatch);
+    std::vector<EvaluationRequest*> batch(maxBatch);
+    std::vector<const State*> states(maxBatch);
+    std::vector<int> ids(maxBatch);
+    std::vector<Evaluation> out(maxBatch);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while(true)
+    {
+        submitted.wait(lock, [this] { return stop || !queue.empty(); });
+        if(queue.empty())
+        {
+            return; // stopped
+        }
+
+        // give the other callers until the deadline to fill the batch
+        submitted.wait_until(lock, oldest + maxWait, [this]
+        {
+            return stop || int(queue.size()) >= maxBatch;
+        });
+
+        const int count = std::min(int(queue.size()), maxBatch);
+        std::copy(queue.begin(), queue.begin() + count, batch.begin());
+        queue.erase(queue.begin(), queue.begin() + count);
+        if(!queue.empty())
+        {
+            oldest = std::chrono::steady_clock::now();
+        }
+        lock.unlock();
+
+        for(int k = 0; k < count; k++)
+        {
+            states[k] = batch[k]->state;
+            ids[k] = batch[k]->agentID;
+        }
+        network.Evaluate(states.data(), ids.data(), count, out.data(), ws, precision);
+        for(int k = 0; k < count; k++)
+        {
+            batch[k]->result = out[k];
+            batch[k]->ready.store(true, std::memory_order_release);
+        }
+        batchCount.fetch_add(1, std::memory_order_relaxed);
+        evaluationCount.fetch_add(count, std::memory_order_relaxed);
+
+        // waiters check their request while holding the lock, so no
+        // wake-up gets lost
+        lock.lock();
+        evaluated.notify_all();
+    }
+}
+
+}
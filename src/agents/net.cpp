@@ -0,0 +1,612 @@
+#include <cmath>
+#include <random>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+#include "bboard.hpp"
+#include "net.hpp"
+
+using namespace bboard;
+
+namespace agents::net
+{
+
+namespace
+{
+
+const int CELLS = BOARD_SIZE * BOARD_SIZE;
+const int MAX_POLICY_CHANNELS = 64;
+const char MAGIC[4] = {'P', 'N', 'E', 'T'};
+const int32_t VERSION = 1;
+
+int AlignChannels(int c)
+{
+    return (c + CHANNEL_ALIGN - 1) / CHANNEL_ALIGN * CHANNEL_ALIGN;
+}
+
+/**
+ * @brief InStride The aligned amount of input channels of a conv layer
+ */
+int InStride(int layer, int stride)
+{
+    return layer == 0 ? CHANNEL_ALIGN : stride;
+}
+
+/**
+ * @brief LayerOffset The index of the first weight of a conv layer
+ */
+size_t LayerOffset(int layer, int channels, int stride)
+{
+    return layer == 0 ? 0 : size_t(channels) * 9 * (CHANNEL_ALIGN + (layer - 1) * stride);
+}
+
+/**
+ * The dot products of the convolutions: the sum of `rows` dot
+ * products a[r] * b[r * n .. (r + 1) * n], where n is a multiple of
+ * CHANNEL_ALIGN. The int8 version multiplies unsigned 7-bit activations
+ * with signed weights.
+ *
+ * The generic versions keep CHANNEL_ALIGN partial sums so that the
+ * compiler can vectorize them without reordering a single sum, the
+ * AVX2 versions use intrinsics.
+ */
+#if defined(__AVX2__) && defined(__FMA__)
+
+inline float DotF32(const float* const a[], int rows, const float* b, int n)
+{
+    __m256 s0 = _mm256_setzero_ps();
+    __m256 s1 = _mm256_setzero_ps();
+    for(int r = 0; r < rows; r++, b += n)
+    {
+        for(int i = 0; i < n; i += 16)
+        {
+            s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a[r] + i), _mm256_loadu_ps(b + i), s0);
+            s1 = _mm256_fmadd_ps(_mm256_loadu_ps(a[r] + i + 8), _mm256_loadu_ps(b + i + 8), s1);
+        }
+    }
+    __m256 s = _mm256_add_ps(s0, s1);
+    __m128 h = _mm_add_ps(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1));
+    h = _mm_add_ps(h, _mm_movehl_ps(h, h));
+    h = _mm_add_ss(h, _mm_movehdup_ps(h));
+    return _mm_cvtss_f32(h);
+}
+
+inline int32_t DotI8(const uint8_t* const a[], int rows, const int8_t* b, int n)
+{
+    // the activations have 7 bits, so the pairwise sums of maddubs
+    // can't saturate
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i s = _mm256_setzero_si256();
+    __m128i t = _mm_setzero_si128();
+    for(int r = 0; r < rows; r++, b += n)
+    {
+        int i = 0;
+        for(; i + 32 <= n; i += 32)
+        {
+            __m256i p = _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i*)(a[r] + i)),
+                                             _mm256_loadu_si256((const __m256i*)(b + i)));
+            s = _mm256_add_epi32(s, _mm256_madd_epi16(p, ones));
+        }
+        if(i < n)
+        {
+            __m128i p = _mm_maddubs_epi16(_mm_loadu_si128((const __m128i*)(a[r] + i)),
+                                          _mm_loadu_si128((const __m128i*)(b + i)));
+            t = _mm_add_epi32(t, _mm_madd_epi16(p, _mm256_castsi256_si128(ones)));
+        }
+    }
+    __m128i h = _mm_add_epi32(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1));
+    h = _mm_add_epi32(h, t);
+    h = _mm_add_epi32(h, _mm_shuffle_epi32(h, 0b01001110));
+    h = _mm_add_epi32(h, _mm_shuffle_epi32(h, 0b10110001));
+    return _mm_cvtsi128_si32(h);
+}
+
+#else
+
+inline float DotF32(const float* const a[], int rows, const float* b, int n)
+{
+    float s[CHANNEL_ALIGN] = {};
+    for(int r = 0; r < rows; r++, b += n)
+    {
+        for(int i = 0; i < n; i += CHANNEL_ALIGN)
+        {
+            for(int l = 0; l < CHANNEL_ALIGN; l++) s[l] += a[r][i + l] * b[i + l];
+        }
+    }
+    float sum = 0;
+    for(int l = 0; l < CHANNEL_ALIGN; l++) sum += s[l];
+    return sum;
+}
+
+inline int32_t DotI8(const uint8_t* const a[], int rows, const int8_t* b, int n)
+{
+    int32_t s[CHANNEL_ALIGN] = {};
+    for(int r = 0; r < rows; r++, b += n)
+    {
+        for(int i = 0; i < n; i += CHANNEL_ALIGN)
+        {
+            for(int l = 0; l < CHANNEL_ALIGN; l++) s[l] += int16_t(a[r][i + l]) * int16_t(b[i + l]);
+        }
+    }
+    int32_t sum = 0;
+    for(int l = 0; l < CHANNEL_ALIGN; l++) sum += s[l];
+    return sum;
+}
+
+#endif
+
+float Relu(float x)
+{
+    return x > 0 ? x : 0;
+}
+
+/**
+ * @brief QuantizeWeights Maps values in [-max, max] to [-127, 127] and
+ * returns the scale that converts them back
+ */
+float QuantizeWeights(const float* in, int8_t* out, int n)
+{
+    float max = 0;
+    for(int i = 0; i < n; i++)
+    {
+        max = std::max(max, std::abs(in[i]));
+    }
+    const float scale = max > 0 ? max / 127.0f : 1.0f;
+    for(int i = 0; i < n; i++)
+    {
+        out[i] = int8_t(std::lrint(in[i] / scale));
+    }
+    return scale;
+}
+
+/**
+ * @brief QuantizeActivations Maps (non-negative) values in [0, max] to
+ * [0, 127] and returns the scale that converts them back
+ */
+float QuantizeActivations(const float* in, uint8_t* out, int n)
+{
+    float max = 0;
+    for(int i = 0; i < n; i++)
+    {
+        max = std::max(max, in[i]);
+    }
+    const float scale = max > 0 ? max / 127.0f : 1.0f;
+    const float inv = 1.0f / scale;
+    for(int i = 0; i < n; i++)
+    {
+        out[i] = uint8_t(in[i] * inv + 0.5f);
+    }
+    return scale;
+}
+
+template<typename T>
+bool ReadValues(std::ifstream& f, T* v, size_t count)
+{
+    f.read(reinterpret_cast<char*>(v), std::streamsize(count * sizeof(T)));
+    return bool(f);
+}
+
+template<typename T>
+void WriteValues(std::ofstream& f, const T* v, size_t count)
+{
+    f.write(reinterpret_cast<const char*>(v), std::streamsize(count * sizeof(T)));
+}
+
+}
+
+void FillPlanes(const State& state, int agentID, float* planes)
+{
+    std::fill_n(planes, PLANE_CELLS * CHANNEL_ALIGN, 0.0f);
+
+    const AgentInfo& me = state.agents[agentID];
+    const float ammo = float(me.maxBombCount - me.bombCount) / MAX_BOMBS_PER_AGENT;
+    const float strength = float(me.bombStrength) / BOARD_SIZE;
+    const float kick = me.canKick ? 1.0f : 0.0f;
+
+    for(int y = 0; y < BOARD_SIZE; y++)
+    {
+        for(int x = 0; x < BOARD_SIZE; x++)
+        {
+            float* p = planes + ((y + 1) * PLANE_SIZE + x + 1) * CHANNEL_ALIGN;
+            const int item = state.board[y][x];
+
+            if(item == Item::RIGID)
+            {
+                p[0] = 1;
+            }
+            else if(IS_WOOD(item))
+            {
+                p[1] = 1;
+            }
+            else if(IS_FLAME(item))
+            {
+                p[6] = 1;
+            }
+            else if(IS_POWERUP(item))
+            {
+                p[7 + item - Item::EXTRABOMB] = 1;
+            }
+            else if(item == Item::FOG)
+            {
+                p[15] = 1;
+            }
+            else if(IS_AGENT(item))
+            {
+                p[item - Item::AGENT0 == agentID ? 10 : 11] = 1;
+            }
+
+            p[12] = ammo;
+            p[13] = strength;
+            p[14] = kick;
+        }
+    }
+
+    for(int i = 0; i < state.bombs.count; i++)
+    {
+        const Bomb b = state.bombs[i];
+        float* p = planes + ((State::Format::PosY(b) + 1) * PLANE_SIZE
+                             + State::Format::PosX(b) + 1) * CHANNEL_ALIGN;
+        p[2] = 1;
+        p[3] = float(State::Format::Time(b)) / BOMB_LIFETIME;
+        p[4] = float(State::Format::Strength(b)) / BOARD_SIZE;
+        p[5] = State::Format::Dir(b) != 0 ? 1.0f : 0.0f;
+    }
+}
+
+void Workspace::Reserve(const Network& network, int batch)
+{
+    const size_t hiddenSize = size_t(batch) * PLANE_CELLS * network.GetStride();
+    const size_t inputSize = size_t(batch) * PLANE_CELLS * CHANNEL_ALIGN;
+
+    // the rings and the padded channels are never written, so they have
+    // to be zero (which moves with the stride of the network)
+    if(hiddenSize > a.size() || network.GetStride() != stride)
+    {
+        a.assign(hiddenSize, 0.0f);
+        b.assign(hiddenSize, 0.0f);
+        stride = network.GetStride();
+    }
+    if(inputSize > input.size())
+    {
+        input.assign(inputSize, 0.0f);
+    }
+    q.resize(PLANE_CELLS * std::max(network.GetStride(), CHANNEL_ALIGN));
+}
+
+///////////////
+//  Network  //
+///////////////
+
+void Network::Allocate(int channels, int convLayers, int policyChannels)
+{
+    this->channels = channels;
+    this->convLayers = convLayers;
+    this->policyChannels = policyChannels;
+    stride = AlignChannels(channels);
+
+    const size_t first = size_t(channels) * 9 * CHANNEL_ALIGN;
+    const size_t other = size_t(channels) * 9 * stride;
+    convWeights.assign(first + (convLayers - 1) * other, 0.0f);
+    convBias.assign(size_t(convLayers) * channels, 0.0f);
+
+    policyConv.assign(size_t(policyChannels) * stride, 0.0f);
+    policyConvBias.assign(policyChannels, 0.0f);
+    policyDense.assign(size_t(POLICY_SIZE) * CELLS * policyChannels, 0.0f);
+    policyBias.assign(POLICY_SIZE, 0.0f);
+
+    valueConv.assign(stride, 0.0f);
+    valueConvBias = 0;
+    valueDense.assign(size_t(VALUE_HIDDEN) * CELLS, 0.0f);
+    valueDenseBias.assign(VALUE_HIDDEN, 0.0f);
+    valueOut.assign(VALUE_HIDDEN, 0.0f);
+    valueOutBias = 0;
+}
+
+bool Network::Init(int channels, int convLayers, int policyChannels, uint64_t seed)
+{
+    if(channels <= 0 || convLayers <= 0 || policyChannels <= 0
+            || policyChannels > MAX_POLICY_CHANNELS)
+    {
+        return false;
+    }
+    Allocate(channels, convLayers, policyChannels);
+
+    std::mt19937_64 rng(seed);
+    auto fill = [&rng](float* v, size_t count, int fanIn)
+    {
+        std::uniform_real_distribution<float> d(-1.0f, 1.0f);
+        const float a = std::sqrt(3.0f / fanIn);
+        for(size_t i = 0; i < count; i++) v[i] = a * d(rng);
+    };
+
+    for(int l = 0; l < convLayers; l++)
+    {
+        const int in = l == 0 ? INPUT_PLANES : channels;
+        const int is = InStride(l, stride);
+        float* w = convWeights.data() + LayerOffset(l, channels, stride);
+        for(int k = 0; k < channels * 9; k++)
+        {
+            fill(w + k * is, in, in * 9);
+        }
+    }
+    for(int k = 0; k < policyChannels; k++)
+    {
+        fill(policyConv.data() + k * stride, channels, channels);
+    }
+    fill(policyDense.data(), policyDense.size(), CELLS * policyChannels);
+    fill(valueConv.data(), channels, channels);
+    fill(valueDense.data(), valueDense.size(), CELLS);
+    fill(valueOut.data(), valueOut.size(), VALUE_HIDDEN);
+
+    Quantize();
+    return true;
+}
+
+bool Network::Load(const std::string& path)
+{
+    std::ifstream f(path, std::ios::binary);
+    char magic[4];
+    int32_t header[4];
+    if(!f || !ReadValues(f, magic, 4) || std::memcmp(magic, MAGIC, 4) != 0
+            || !ReadValues(f, header, 4) || header[0] != VERSION)
+    {
+        return false;
+    }
+    // sane limits, a corrupt header shouldn't allocate gigabytes
+    if(header[1] <= 0 || header[1] > 1024 || header[2] <= 0 || header[2] > 64
+            || header[3] <= 0 || header[3] > MAX_POLICY_CHANNELS)
+    {
+        return false;
+    }
+
+    Network n;
+    n.Allocate(header[1], header[2], header[3]);
+    const int c = n.channels;
+    bool ok = true;
+
+    for(int l = 0; l < n.convLayers && ok; l++)
+    {
+        const int in = l == 0 ? INPUT_PLANES : c;
+        const int is = InStride(l, n.stride);
+        float* w = n.convWeights.data() + LayerOffset(l, c, n.stride);
+        for(int k = 0; k < c * 9 && ok; k++)
+        {
+            ok = ReadValues(f, w + k * is, in);
+        }
+        ok = ok && ReadValues(f, n.convBias.data() + l * c, c);
+    }
+    for(int k = 0; k < n.policyChannels && ok; k++)
+    {
+        ok = ReadValues(f, n.policyConv.data() + k * n.stride, c);
+    }
+    ok = ok && ReadValues(f, n.policyConvBias.data(), n.policyConvBias.size())
+            && ReadValues(f, n.policyDense.data(), n.policyDense.size())
+            && ReadValues(f, n.policyBias.data(), n.policyBias.size())
+            && ReadValues(f, n.valueConv.data(), c)
+            && ReadValues(f, &n.valueConvBias, 1)
+            && ReadValues(f, n.valueDense.data(), n.valueDense.size())
+            && ReadValues(f, n.valueDenseBias.data(), n.valueDenseBias.size())
+            && ReadValues(f, n.valueOut.data(), n.valueOut.size())
+            && ReadValues(f, &n.valueOutBias, 1);
+
+    if(!ok)
+    {
+        return false;
+    }
+    n.Quantize();
+    *this = std::move(n);
+    return true;
+}
+
+bool Network::Save(const std::string& path) const
+{
+    std::ofstream f(path, std::ios::binary);
+    const int32_t header[4] = {VERSION, channels, convLayers, policyChannels};
+    WriteValues(f, MAGIC, 4);
+    WriteValues(f, header, 4);
+
+    for(int l = 0; l < convLayers; l++)
+    {
+        const int in = l == 0 ? INPUT_PLANES : channels;
+        const int is = InStride(l, stride);
+        const float* w = convWeights.data() + LayerOffset(l, channels, stride);
+        for(int k = 0; k < channels * 9; k++)
+        {
+            WriteValues(f, w + k * is, in);
+        }
+        WriteValues(f, convBias.data() + l * channels, channels);
+    }
+    for(int k = 0; k < policyChannels; k++)
+    {
+        WriteValues(f, policyConv.data() + k * stride, channels);
+    }
+    WriteValues(f, policyConvBias.data(), policyConvBias.size());
+    WriteValues(f, policyDense.data(), policyDense.size());
+    WriteValues(f, policyBias.data(), policyBias.size());
+    WriteValues(f, valueConv.data(), channels);
+    WriteValues(f, &valueConvBias, 1);
+    WriteValues(f, valueDense.data(), valueDense.size());
+    WriteValues(f, valueDenseBias.data(), valueDenseBias.size());
+    WriteValues(f, valueOut.data(), valueOut.size());
+    WriteValues(f, &valueOutBias, 1);
+
+    return bool(f);
+}
+
+void Network::Quantize()
+{
+    convWeightsQ.resize(convWeights.size());
+    convScaleQ.resize(size_t(convLayers) * channels);
+
+    for(int l = 0; l < convLayers; l++)
+    {
+        const int n = 9 * InStride(l, stride);
+        const size_t offset = LayerOffset(l, channels, stride);
+        for(int k = 0; k < channels; k++)
+        {
+            convScaleQ[l * channels + k] = QuantizeWeights(convWeights.data() + offset + k * n,
+                                                         convWeightsQ.data() + offset + k * n, n);
+        }
+    }
+}
+
+void Network::Convolve(int layer, const float* in, float* out, int count, Workspace& ws,
+                       Precision precision) const
+{
+    const int is = InStride(layer, stride);
+    const int row = 3 * is;
+    const size_t offset = LayerOffset(layer, channels, stride);
+    const float* bias = convBias.data() + layer * channels;
+
+    for(int s = 0; s < count; s++)
+    {
+        const float* src = in + size_t(s) * PLANE_CELLS * is;
+        float* dst = out + size_t(s) * PLANE_CELLS * stride;
+
+        if(precision == Precision::FP32)
+        {
+            const float* w = convWeights.data() + offset;
+            for(int y = 1; y <= BOARD_SIZE; y++)
+            {
+                for(int x = 1; x <= BOARD_SIZE; x++)
+                {
+                    // each of the three rows of the 3x3 window is contiguous
+                    const float* r0 = src + ((y - 1) * PLANE_SIZE + x - 1) * is;
+                    const float* rows[3] = {r0, r0 + PLANE_SIZE * is, r0 + 2 * PLANE_SIZE * is};
+                    float* o = dst + (y * PLANE_SIZE + x) * stride;
+                    for(int k = 0; k < channels; k++)
+                    {
+                        o[k] = Relu(bias[k] + DotF32(rows, 3, w + k * 3 * row, row));
+                    }
+                }
+            }
+        }
+        else
+        {
+            const int8_t* w = convWeightsQ.data() + offset;
+            const float* wScale = convScaleQ.data() + layer * channels;
+            uint8_t* q = ws.q.data();
+            const float scale = QuantizeActivations(src, q, PLANE_CELLS * is);
+
+            for(int y = 1; y <= BOARD_SIZE; y++)
+            {
+                for(int x = 1; x <= BOARD_SIZE; x++)
+                {
+                    const uint8_t* r0 = q + ((y - 1) * PLANE_SIZE + x - 1) * is;
+                    const uint8_t* rows[3] = {r0, r0 + PLANE_SIZE * is, r0 + 2 * PLANE_SIZE * is};
+                    float* o = dst + (y * PLANE_SIZE + x) * stride;
+                    for(int k = 0; k < channels; k++)
+                    {
+                        const int32_t acc = DotI8(rows, 3, w + k * 3 * row, row);
+                        o[k] = Relu(bias[k] + float(acc) * scale * wScale[k]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void Network::Heads(const float* in, Evaluation& out) const
+{
+    float policyPlanes[CELLS * MAX_POLICY_CHANNELS];
+    float valuePlane[CELLS];
+
+    for(int y = 0; y < BOARD_SIZE; y++)
+    {
+        for(int x = 0; x < BOARD_SIZE; x++)
+        {
+            const int cell = y * BOARD_SIZE + x;
+            const float* a = in + ((y + 1) * PLANE_SIZE + x + 1) * stride;
+            for(int k = 0; k < policyChannels; k++)
+            {
+                policyPlanes[cell * policyChannels + k] =
+                        Relu(policyConvBias[k] + DotF32(&a, 1, policyConv.data() + k * stride, stride));
+            }
+            valuePlane[cell] = Relu(valueConvBias + DotF32(&a, 1, valueConv.data(), stride));
+        }
+    }
+
+    // policy
+    const int n = CELLS * policyChannels;
+    float max = -INFINITY;
+    for(int m = 0; m < POLICY_SIZE; m++)
+    {
+        const float* w = policyDense.data() + size_t(m) * n;
+        float logit = policyBias[m];
+        for(int i = 0; i < n; i++)
+        {
+            logit += w[i] * policyPlanes[i];
+        }
+        out.policy[m] = logit;
+        max = std::max(max, logit);
+    }
+    float sum = 0;
+    for(int m = 0; m < POLICY_SIZE; m++)
+    {
+        out.policy[m] = std::exp(out.policy[m] - max);
+        sum += out.policy[m];
+    }
+    for(int m = 0; m < POLICY_SIZE; m++)
+    {
+        out.policy[m] /= sum;
+    }
+
+    // value
+    float v = valueOutBias;
+    for(int h = 0; h < VALUE_HIDDEN; h++)
+    {
+        const float* w = valueDense.data() + size_t(h) * CELLS;
+        float hidden = valueDenseBias[h];
+        for(int i = 0; i < CELLS; i++)
+        {
+            hidden += w[i] * valuePlane[i];
+        }
+        v += valueOut[h] * Relu(hidden);
+    }
+    out.value = std::tanh(v);
+}
+
+void Network::Evaluate(const State* const states[], const int agentIDs[], int count,
+                       Evaluation out[], Workspace& ws, Precision precision) const
+{
+    if(count <= 0 || convLayers == 0)
+    {
+        return;
+    }
+    ws.Reserve(*this, count);
+
+    for(int s = 0; s < count; s++)
+    {
+        FillPlanes(*states[s], agentIDs[s], ws.input.data() + size_t(s) * PLANE_CELLS * CHANNEL_ALIGN);
+    }
+
+    // layer by layer over the whole batch
+    const float* in = ws.input.data();
+    float* buffers[2] = {ws.a.data(), ws.b.data()};
+    for(int l = 0; l < convLayers; l++)
+    {
+        Convolve(l, in, buffers[l % 2], count, ws, precision);
+        in = buffers[l % 2];
+    }
+
+    for(int s = 0; s < count; s++)
+    {
+        Heads(in + size_t(s) * PLANE_CELLS * stride, out[s]);
+    }
+}
+
+Evaluation Network::Evaluate(const State& state, int agentID, Workspace& ws,
+                             Precision precision) const
+{
+    const State* states[1] = {&state};
+    Evaluation e;
+    Evaluate(states, &agentID, 1, &e, ws, precision);
+    return e;
+}
+
+}
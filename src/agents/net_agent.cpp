@@ -0,0 +1,35 @@
+#include "bboard.hpp"
+#include "agents.hpp"
+#include "strategy.hpp"
+
+using namespace bboard;
+
+namespace agents
+{
+
+NetAgent::NetAgent(const net::Network* network, net::Precision precision)
+    : network(network), precision(precision)
+{
+}
+
+Move NetAgent::act(const State* state)
+{
+    evaluation = network->Evaluate(*state, id, workspace, precision);
+
+    strategy::MoveMask legal[AGENT_COUNT];
+    strategy::LegalMoves(*state, legal);
+
+    Move best = Move::IDLE;
+    float bestP = -1;
+    for(int m = 0; m < net::POLICY_SIZE; m++)
+    {
+        if(strategy::HasMove(legal[id], Move(m)) && evaluation.policy[m] > bestP)
+        {
+            best = Move(m);
+            bestP = evaluation.policy[m];
+        }
+    }
+    return best;
+}
+
+}
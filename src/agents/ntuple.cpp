@@ -0,0 +1,387 @@
+#include <cmath>
+#include <random>
+#include <thread>
+#include <memory>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+
+#include "bboard.hpp"
+#include "strategy.hpp"
+#include "ntuple.hpp"
+#include "symmetry.hpp"
+
+using namespace bboard;
+
+namespace agents::ntuple
+{
+
+namespace
+{
+
+const int CELLS = BOARD_SIZE * BOARD_SIZE;
+const size_t WEIGHT_COUNT = size_t(TUPLE_COUNT) * TUPLE_ENTRIES + STAT_ENTRIES;
+const char MAGIC[4] = {'N', 'T', 'U', 'P'};
+const int32_t VERSION = 1;
+
+enum Code : uint8_t
+{
+    C_PASSAGE = 0,
+    C_RIGID,
+    C_WOOD,
+    C_BOMB,
+    C_FLAME,
+    C_POWERUP,
+    C_SELF,
+    C_OTHER
+};
+
+/**
+ * @brief Accumulates the TD updates of the games of one thread
+ */
+struct Learner
+{
+    std::vector<float> delta;
+    TrainingStats stats;
+    double error = 0;
+
+    void Update(const uint32_t features[FEATURE_COUNT], float value, float target, float learningRate)
+    {
+        const float e = target - value;
+        // the gradient of tanh, spread over all features of the state
+        const float g = learningRate * e * (1 - value * value) / FEATURE_COUNT;
+        for(int f = 0; f < FEATURE_COUNT; f++)
+        {
+            delta[features[f]] += g;
+        }
+        error += std::abs(e);
+        stats.updates++;
+    }
+};
+
+/**
+ * @brief Computes the features of every agent in the transforms of a
+ * state that a game learns from
+ */
+struct Views
+{
+    int count;
+    uint32_t features[AGENT_COUNT][SYMMETRY_COUNT][FEATURE_COUNT];
+    float values[AGENT_COUNT][SYMMETRY_COUNT];
+    State transformed;
+
+    void Observe(const NTupleNetwork& network, const State& s, int agentID,
+                 uint32_t features[SYMMETRY_COUNT][FEATURE_COUNT], float values[SYMMETRY_COUNT])
+    {
+        for(int v = 0; v < count; v++)
+        {
+            if(v == 0)
+            {
+                network.Features(s, agentID, features[v]);
+            }
+            else
+            {
+                TransformState(s, transformed, v);
+                network.Features(transformed, agentID, features[v]);
+            }
+            values[v] = network.Value(features[v]);
+        }
+    }
+};
+
+void PlayGame(const NTupleNetwork& network, const TrainingConfig& config, uint64_t seed, Learner& l)
+{
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+
+    State s;
+    InitBoardItems(s, int(seed & 0x7FFFFFFF));
+    s.PutAgentsInCorners(0, 1, 2, 3);
+
+    auto views = std::make_unique<Views>();
+    views->count = config.symmetries ? SYMMETRY_COUNT : 1;
+    for(int i = 0; i < AGENT_COUNT; i++)
+    {
+        views->Observe(network, s, i, views->features[i], views->values[i]);
+    }
+
+    uint32_t next[SYMMETRY_COUNT][FEATURE_COUNT];
+    float nextValues[SYMMETRY_COUNT];
+    for(int t = 0; t < config.maxSteps; t++)
+    {
+        strategy::MoveMask legal[AGENT_COUNT];
+        strategy::LegalMoves(s, legal);
+        Move moves[AGENT_COUNT];
+        bool wasAlive[AGENT_COUNT];
+        for(int i = 0; i < AGENT_COUNT; i++)
+        {
+            wasAlive[i] = !s.agents[i].dead;
+            if(!wasAlive[i])
+            {
+                moves[i] = Move::IDLE;
+            }
+            else if(chance(rng) < config.epsilon)
+            {
+                moves[i] = strategy::RandomLegalMove(legal[i], rng);
+            }
+            else
+            {
+                moves[i] = GreedyMove(network, s, i);
+            }
+        }
+
+        Step(&s, moves);
+        l.stats.steps++;
+
+        bool over = true;
+        for(int i = 0; i < AGENT_COUNT; i++)
+        {
+            if(!wasAlive[i])
+            {
+                continue;
+            }
+            float outcome;
+            const bool done = strategy::TerminalValue(s, i, outcome);
+            if(!done)
+            {
+                over = false;
+                views->Observe(network, s, i, next, nextValues);
+            }
+            for(int v = 0; v < views->count; v++)
+            {
+                const float target = done ? outcome : (t + 1 == config.maxSteps ? 0.0f : nextValues[v]);
+                l.Update(views->features[i][v], views->values[i][v], target, config.learningRate);
+            }
+            if(!done)
+            {
+                std::copy_n(&next[0][0], views->count * FEATURE_COUNT, &views->features[i][0][0]);
+                std::copy_n(nextValues, views->count, views->values[i]);
+            }
+        }
+        if(over)
+        {
+            break;
+        }
+    }
+    l.stats.games++;
+}
+
+template<typename T>
+bool ReadValues(std::ifstream& f, T* v, size_t count)
+{
+    f.read(reinterpret_cast<char*>(v), std::streamsize(count * sizeof(T)));
+    return bool(f);
+}
+
+template<typename T>
+void WriteValues(std::ofstream& f, const T* v, size_t count)
+{
+    f.write(reinterpret_cast<const char*>(v), std::streamsize(count * sizeof(T)));
+}
+
+}
+
+void EncodeCells(const State& state, int agentID, uint8_t cells[BOARD_SIZE * BOARD_SIZE])
+{
+    for(int y = 0; y < BOARD_SIZE; y++)
+    {
+        for(int x = 0; x < BOARD_SIZE; x++)
+        {
+            const int item = state.board[y][x];
+            uint8_t c = C_PASSAGE;
+            if(item == Item::RIGID) c = C_RIGID;
+            else if(IS_WOOD(item)) c = C_WOOD;
+            else if(IS_FLAME(item)) c = C_FLAME;
+            else if(IS_POWERUP(item)) c = C_POWERUP;
+            else if(item == Item::BOMB) c = C_BOMB;
+            else if(IS_AGENT(item)) c = item - Item::AGENT0 == agentID ? C_SELF : C_OTHER;
+            cells[x + BOARD_SIZE * y] = c;
+        }
+    }
+    // agents standing on their bombs stay visible
+    for(int i = 0; i < state.bombs.count; i++)
+    {
+        const Bomb b = state.bombs[i];
+        uint8_t& c = cells[State::Format::PosX(b) + BOARD_SIZE * State::Format::PosY(b)];
+        if(c == C_PASSAGE)
+        {
+            c = C_BOMB;
+        }
+    }
+}
+
+NTupleNetwork::NTupleNetwork()
+    : weights(WEIGHT_COUNT, 0.0f)
+{
+}
+
+void NTupleNetwork::Features(const State& state, int agentID, uint32_t features[FEATURE_COUNT]) const
+{
+    uint8_t c[CELLS];
+    EncodeCells(state, agentID, c);
+
+    int t = 0;
+    for(int y = 0; y < BOARD_SIZE - 1; y++)
+    {
+        for(int x = 0; x < BOARD_SIZE - 1; x++, t++)
+        {
+            const int p = x + BOARD_SIZE * y;
+            const uint32_t index = ((c[p] * CELL_VALUES + c[p + 1]) * CELL_VALUES
+                                    + c[p + BOARD_SIZE]) * CELL_VALUES + c[p + BOARD_SIZE + 1];
+            features[t] = uint32_t(t) * TUPLE_ENTRIES + index;
+        }
+    }
+
+    const AgentInfo& me = state.agents[agentID];
+    int opponents = 0;
+    for(int i = 0; i < AGENT_COUNT; i++)
+    {
+        opponents += i != agentID && !state.agents[i].dead;
+    }
+    const int ammo = std::min(std::max(me.maxBombCount - me.bombCount, 0), 3);
+    const int strength = std::min(std::max(me.bombStrength - 1, 0), 5);
+    const int stat = ((ammo * 6 + strength) * 2 + (me.canKick ? 1 : 0)) * 4 + std::min(opponents, 3);
+    features[TUPLE_COUNT] = uint32_t(TUPLE_COUNT) * TUPLE_ENTRIES + stat;
+}
+
+float NTupleNetwork::Value(const uint32_t features[FEATURE_COUNT]) const
+{
+    float sum = 0;
+    for(int f = 0; f < FEATURE_COUNT; f++)
+    {
+        sum += weights[features[f]];
+    }
+    return std::tanh(sum);
+}
+
+float NTupleNetwork::Evaluate(const State& state, int agentID) const
+{
+    uint32_t features[FEATURE_COUNT];
+    Features(state, agentID, features);
+    return Value(features);
+}
+
+bool NTupleNetwork::Load(const std::string& path)
+{
+    std::ifstream f(path, std::ios::binary);
+    char magic[4];
+    int32_t header[2];
+    if(!f || !ReadValues(f, magic, 4) || std::memcmp(magic, MAGIC, 4) != 0
+            || !ReadValues(f, header, 2) || header[0] != VERSION || size_t(header[1]) != WEIGHT_COUNT)
+    {
+        return false;
+    }
+    std::vector<float> w(WEIGHT_COUNT);
+    if(!ReadValues(f, w.data(), w.size()))
+    {
+        return false;
+    }
+    weights = std::move(w);
+    return true;
+}
+
+bool NTupleNetwork::Save(const std::string& path) const
+{
+    std::ofstream f(path, std::ios::binary);
+    const int32_t header[2] = {VERSION, int32_t(weights.size())};
+    WriteValues(f, MAGIC, 4);
+    WriteValues(f, header, 2);
+    WriteValues(f, weights.data(), weights.size());
+    return bool(f);
+}
+
+Move GreedyMove(const NTupleNetwork& network, const State& state, int agentID)
+{
+    strategy::MoveMask legal[AGENT_COUNT];
+    strategy::LegalMoves(state, legal);
+
+    Move best = Move::IDLE;
+    float bestValue = -2;
+    Move moves[AGENT_COUNT] = {};
+    State next;
+    for(int m = 0; m < ACTION_COUNT; m++)
+    {
+        if(!strategy::HasMove(legal[agentID], Move(m)))
+        {
+            continue;
+        }
+        next = state;
+        moves[agentID] = Move(m);
+        Step(&next, moves);
+
+        float v;
+        if(!strategy::TerminalValue(next, agentID, v))
+        {
+            v = network.Evaluate(next, agentID);
+        }
+        if(v > bestValue)
+        {
+            best = Move(m);
+            bestValue = v;
+        }
+    }
+    return best;
+}
+
+TrainingStats TrainSelfPlay(NTupleNetwork& network, const TrainingConfig& config)
+{
+    const int threads = std::max(1, std::min(config.threads, config.games));
+    std::vector<Learner> learners(threads);
+    for(Learner& l : learners)
+    {
+        l.delta.assign(network.GetWeights().size(), 0.0f);
+    }
+
+    TrainingStats total;
+    for(int r = 0; r < config.rounds; r++)
+    {
+        auto play = [&](int t)
+        {
+            for(int g = t; g < config.games; g += threads)
+            {
+                PlayGame(network, config, config.seed + uint64_t(r) * config.games + g, learners[t]);
+            }
+        };
+        if(threads == 1)
+        {
+            play(0);
+        }
+        else
+        {
+            std::vector<std::thread> workers;
+            for(int t = 0; t < threads; t++)
+            {
+                workers.emplace_back(play, t);
+            }
+            for(std::thread& w : workers)
+            {
+                w.join();
+            }
+        }
+
+        // the weights stay fixed during a round
+        std::vector<float>& w = network.GetWeights();
+        double error = 0;
+        long updates = 0;
+        for(Learner& l : learners)
+        {
+            for(size_t k = 0; k < w.size(); k++)
+            {
+                w[k] += l.delta[k];
+            }
+            std::fill(l.delta.begin(), l.delta.end(), 0.0f);
+
+            total.games += l.stats.games;
+            total.steps += l.stats.steps;
+            total.updates += l.stats.updates;
+            error += l.error;
+            updates += l.stats.updates;
+            l.stats = TrainingStats();
+            l.error = 0;
+        }
+        total.error = updates == 0 ? 0.0f : float(error / updates);
+    }
+    return total;
+}
+
+}
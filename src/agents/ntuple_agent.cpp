@@ -0,0 +1,20 @@
+#include "bboard.hpp"
+#include "agents.hpp"
+#include "ntuple.hpp"
+
+using namespace bboard;
+
+namespace agents
+{
+
+NTupleAgent::NTupleAgent(const ntuple::NTupleNetwork* network)
+    : network(network)
+{
+}
+
+Move NTupleAgent::act(const State* state)
+{
+    return ntuple::GreedyMove(*network, *state, id);
+}
+
+}
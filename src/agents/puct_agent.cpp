@@ -0,0 +1,228 @@
+#include <cmath>
+#include <algorithm>
+
+#include "bboard.hpp"
+#include "agents.hpp"
+#include "strategy.hpp"
+
+using namespace bboard;
+
+namespace agents
+{
+
+namespace
+{
+
+const float VIRTUAL_LOSS = 1.0f;
+
+}
+
+PUCTAgent::PUCTAgent(net::EvaluationQueue* queue, int simulations, int parallel, uint64_t seed)
+    : queue(queue), simulations(std::max(1, simulations)), parallel(std::max(1, parallel)), rng(seed)
+{
+    // every simulation adds at most one node, so act never reallocates
+    nodes.reserve(this->simulations + 1);
+    states.Reserve(this->simulations + 1, 128);
+    inFlight = std::make_unique<Simulation[]>(this->parallel);
+}
+
+int PUCTAgent::AddNode(int parent)
+{
+    nodes.emplace_back();
+    const int index = int(nodes.size()) - 1;
+    Node& n = nodes[index];
+    n.parent = parent;
+    std::fill_n(n.child, net::POLICY_SIZE, -1);
+    std::fill_n(n.prior, net::POLICY_SIZE, 0.0f);
+    return index;
+}
+
+void PUCTAgent::Expand(int node, const State& state, const net::Evaluation& e)
+{
+    Node& n = nodes[node];
+    strategy::MoveMask legal[AGENT_COUNT];
+    strategy::LegalMoves(state, legal);
+
+    float sum = 0;
+    for(int m = 0; m < net::POLICY_SIZE; m++)
+    {
+        n.prior[m] = strategy::HasMove(legal[id], Move(m)) ? e.policy[m] : 0.0f;
+        sum += n.prior[m];
+    }
+    for(int m = 0; m < net::POLICY_SIZE; m++)
+    {
+        n.prior[m] = sum > 0 ? n.prior[m] / sum : (m == int(Move::IDLE) ? 1.0f : 0.0f);
+    }
+    n.expanded = true;
+}
+
+void PUCTAgent::Backup(int node, float value)
+{
+    for(int n = node; n >= 0; n = nodes[n].parent)
+    {
+        nodes[n].valueSum += value + VIRTUAL_LOSS;
+    }
+}
+
+int PUCTAgent::Descend(State& leafState)
+{
+    states.Move(cursorNode, 0, cursor);
+    cursorNode = 0;
+    int n = 0;
+    while(true)
+    {
+        Node& node = nodes[n];
+        node.visits++;
+        node.valueSum -= VIRTUAL_LOSS;
+        if(node.terminal)
+        {
+            return n;
+        }
+
+        const float sqrtVisits = std::sqrt(float(node.visits));
+        int best = -1;
+        float bestScore = -1e9f;
+        for(int m = 0; m < net::POLICY_SIZE; m++)
+        {
+            if(node.prior[m] <= 0)
+            {
+                continue;
+            }
+            const int c = node.child[m];
+            const int visits = c < 0 ? 0 : nodes[c].visits;
+            const float q = visits == 0 ? 0.0f : nodes[c].valueSum / visits;
+            const float score = q + cPuct * node.prior[m] * sqrtVisits / (1 + visits);
+            if(score > bestScore)
+            {
+                best = m;
+                bestScore = score;
+            }
+        }
+
+        const int c = node.child[best];
+        if(c < 0)
+        {
+            // the other agents play a random legal move
+            strategy::MoveMask legal[AGENT_COUNT];
+            strategy::LegalMoves(cursor, legal);
+            Move moves[AGENT_COUNT];
+            for(int i = 0; i < AGENT_COUNT; i++)
+            {
+                moves[i] = Move::IDLE;
+                if(i == id || cursor.agents[i].dead || legal[i] == 0)
+                {
+                    continue;
+                }
+                moves[i] = strategy::RandomLegalMove(legal[i], rng);
+            }
+            moves[id] = Move(best);
+
+            leafState = cursor;
+            Step(&leafState, moves);
+            const int leaf = AddNode(n);
+            states.Add(n, cursor, leafState);
+            nodes[n].child[best] = leaf;
+            Node& l = nodes[leaf];
+            l.terminal = strategy::TerminalValue(leafState, id, l.outcome);
+            l.visits = 1;
+            l.valueSum -= VIRTUAL_LOSS;
+            return leaf;
+        }
+        if(!nodes[c].expanded && !nodes[c].terminal)
+        {
+            // the child waits for its evaluation, undo the virtual losses
+            for(int p = n; p >= 0; p = nodes[p].parent)
+            {
+                nodes[p].visits--;
+                nodes[p].valueSum += VIRTUAL_LOSS;
+            }
+            return -1;
+        }
+        states.Move(n, c, cursor);
+        cursorNode = c;
+        n = c;
+    }
+}
+
+Move PUCTAgent::act(const State* state)
+{
+    nodes.clear();
+    AddNode(-1);
+    states.AddRoot(*state);
+    cursor = *state;
+    cursorNode = 0;
+
+    float value;
+    if(strategy::TerminalValue(*state, id, value))
+    {
+        return Move::IDLE;
+    }
+    Simulation& root = inFlight[0];
+    root.request.state = state;
+    root.request.agentID = id;
+    queue->Submit(root.request);
+    queue->Wait(root.request);
+    Expand(0, *state, root.request.result);
+
+    // the in-flight simulations form a FIFO ring
+    int head = 0, active = 0, started = 0, finished = 0;
+    while(finished < simulations)
+    {
+        // resume the simulations whose leaves are evaluated
+        while(active > 0 && inFlight[head].request.IsReady())
+        {
+            Simulation& s = inFlight[head];
+            Expand(s.leaf, s.state, s.request.result);
+            Backup(s.leaf, s.request.result.value);
+            head = (head + 1) % parallel;
+            active--;
+            finished++;
+        }
+
+        if(started < simulations && active < parallel)
+        {
+            Simulation& next = inFlight[(head + active) % parallel];
+            const int leaf = Descend(next.state);
+            if(leaf >= 0)
+            {
+                started++;
+                if(nodes[leaf].terminal)
+                {
+                    Backup(leaf, nodes[leaf].outcome);
+                    finished++;
+                }
+                else
+                {
+                    next.leaf = leaf;
+                    next.request.state = &next.state;
+                    next.request.agentID = id;
+                    queue->Submit(next.request);
+                    active++;
+                }
+                continue;
+            }
+        }
+
+        if(active == 0)
+        {
+            break;
+        }
+        // suspend until the oldest leaf is evaluated
+        queue->Wait(inFlight[head].request);
+    }
+
+    Move best = Move::IDLE;
+    int bestVisits = 0;
+    for(int m = 0; m < net::POLICY_SIZE; m++)
+    {
+        const int c = nodes[0].child[m];
+        if(c >= 0 && nodes[c].visits > bestVisits)
+        {
+            best = Move(m);
+            bestVisits = nodes[c].visits;
+        }
+    }
+    return best;
+}
+
+}
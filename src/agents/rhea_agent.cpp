@@ -0,0 +1,284 @@
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+
+#include "bboard.hpp"
+#include "agents.hpp"
+
+using namespace bboard;
+
+namespace agents
+{
+
+namespace
+{
+
+inline uint64_t SplitMix(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+int CountWood(const State& state)
+{
+    int wood = 0;
+    for(int y = 0; y < BOARD_SIZE; y++)
+    {
+        for(int x = 0; x < BOARD_SIZE; x++)
+        {
+            wood += IS_WOOD(state.board[y][x]);
+        }
+    }
+    return wood;
+}
+
+}
+
+/**
+ * The caller evaluates slice 0 of a batch, the workers the slices
+ * 1 .. threads - 1.
+ */
+struct RHEAAgent::Pool
+{
+    std::mutex mutex;
+    std::condition_variable start;
+    std::condition_variable done;
+    std::vector<std::thread> workers;
+
+    // the current batch
+    long batch = 0;
+    int pending = 0;
+    bool stop = false;
+    Move* genomes = nullptr;
+    float* fitness = nullptr;
+    int from = 0;
+    int count = 0;
+};
+
+RHEAAgent::RHEAAgent(int horizon, int populationSize, int threads, uint64_t seed)
+    : horizon(std::max(1, horizon)), populationSize(std::max(2, populationSize)),
+      threads(std::max(1, threads)), pool(std::make_unique<Pool>()), rng(seed),
+      scratch(search::StatePool::BATCH * this->threads)
+{
+    genomes.resize(size_t(this->populationSize) * this->horizon);
+    offspring.resize(genomes.size());
+    fitness.resize(this->populationSize);
+    offspringFitness.resize(this->populationSize);
+    order.resize(this->populationSize);
+
+    for(int t = 1; t < this->threads; t++)
+    {
+        pool->workers.emplace_back([this, t]
+        {
+            long seen = 0;
+            std::unique_lock<std::mutex> lock(pool->mutex);
+            while(true)
+            {
+                pool->start.wait(lock, [this, seen] { return pool->stop || pool->batch != seen; });
+                if(pool->stop)
+                {
+                    return;
+                }
+                seen = pool->batch;
+                lock.unlock();
+                EvaluateSlice(pool->genomes, pool->fitness, pool->from, pool->count, t);
+                lock.lock();
+                if(--pool->pending == 0)
+                {
+                    pool->done.notify_one();
+                }
+            }
+        });
+    }
+}
+
+RHEAAgent::~RHEAAgent()
+{
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->stop = true;
+    }
+    pool->start.notify_all();
+    for(std::thread& w : pool->workers)
+    {
+        w.join();
+    }
+}
+
+float RHEAAgent::Evaluate(const Move* genome, State& s, uint64_t seed) const
+{
+    s = *root;
+    uint64_t r = SplitMix(seed) | 1;
+    Move moves[AGENT_COUNT];
+    for(int t = 0; t < horizon; t++)
+    {
+        for(int i = 0; i < AGENT_COUNT; i++)
+        {
+            // xorshift, the opponents play random moves
+            r ^= r << 13;
+            r ^= r >> 7;
+            r ^= r << 17;
+            moves[i] = Move((r >> 32) % ACTION_COUNT);
+        }
+        moves[id] = genome[t];
+        Step(&s, moves);
+
+        if(s.agents[id].dead)
+        {
+            // dying later is better than dying early
+            return -1.0f + 0.1f * float(t) / horizon;
+        }
+    }
+
+    if(heuristic != nullptr)
+    {
+        return heuristic->Evaluate(s, id);
+    }
+
+    const AgentInfo& me = s.agents[id];
+    int opponents = 0;
+    for(int i = 0; i < AGENT_COUNT; i++)
+    {
+        opponents += i != id && !s.agents[i].dead;
+    }
+    return 0.3f * float(AGENT_COUNT - 1 - opponents) / (AGENT_COUNT - 1)
+           + 0.02f * float(rootWood - CountWood(s))
+           + 0.05f * float(std::min(me.bombStrength - 1, 4))
+           + 0.05f * float(std::min(me.maxBombCount - 1, 4))
+           + (me.canKick ? 0.1f : 0.0f);
+}
+
+void RHEAAgent::EvaluateSlice(Move* g, float* f, int from, int count, int slice)
+{
+    State* s = scratch.Acquire();
+    for(int k = slice; k < count; k += threads)
+    {
+        const int i = from + k;
+        f[i] = Evaluate(g + size_t(i) * horizon, *s, batchSeed + uint64_t(i));
+    }
+    scratch.Release(s);
+}
+
+void RHEAAgent::EvaluateAll(Move* g, float* f, int from, int count)
+{
+    // the seeds of a batch only depend on the agent's generator, not
+    // on the thread that evaluates an individual
+    batchSeed = rng();
+    evaluations += count;
+    if(threads == 1)
+    {
+        EvaluateSlice(g, f, from, count, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->genomes = g;
+        pool->fitness = f;
+        pool->from = from;
+        pool->count = count;
+        pool->pending = threads - 1;
+        pool->batch++;
+    }
+    pool->start.notify_all();
+    EvaluateSlice(g, f, from, count, 0);
+
+    std::unique_lock<std::mutex> lock(pool->mutex);
+    pool->done.wait(lock, [this] { return pool->pending == 0; });
+}
+
+void RHEAAgent::Evolve()
+{
+    for(int i = 0; i < populationSize; i++)
+    {
+        order[i] = i;
+    }
+    const int keep = std::min(std::max(elites, 0), populationSize - 1);
+    std::partial_sort(order.begin(), order.begin() + keep, order.end(),
+                      [this](int a, int b) { return fitness[a] > fitness[b]; });
+
+    std::uniform_int_distribution<int> pick(0, populationSize - 1);
+    std::uniform_int_distribution<int> gene(0, ACTION_COUNT - 1);
+    std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+    auto tournament = [&]()
+    {
+        const int a = pick(rng), b = pick(rng);
+        return fitness[a] >= fitness[b] ? a : b;
+    };
+
+    for(int i = 0; i < populationSize; i++)
+    {
+        Move* child = &offspring[size_t(i) * horizon];
+        if(i < keep)
+        {
+            std::copy_n(&genomes[size_t(order[i]) * horizon], horizon, child);
+            offspringFitness[i] = fitness[order[i]];
+            continue;
+        }
+        const Move* p1 = &genomes[size_t(tournament()) * horizon];
+        const Move* p2 = &genomes[size_t(tournament()) * horizon];
+        for(int t = 0; t < horizon; t++)
+        {
+            child[t] = chance(rng) < 0.5f ? p1[t] : p2[t];
+            if(chance(rng) < mutationRate)
+            {
+                child[t] = Move(gene(rng));
+            }
+        }
+    }
+    EvaluateAll(offspring.data(), offspringFitness.data(), keep, populationSize - keep);
+
+    genomes.swap(offspring);
+    fitness.swap(offspringFitness);
+}
+
+Move RHEAAgent::act(const State* state)
+{
+    const auto start = std::chrono::steady_clock::now();
+    std::uniform_int_distribution<int> gene(0, ACTION_COUNT - 1);
+
+    if(state->timeStep != lastTimeStep + 1)
+    {
+        // a new game, start with random plans
+        for(Move& m : genomes)
+        {
+            m = Move(gene(rng));
+        }
+    }
+    lastTimeStep = state->timeStep;
+
+    root = state;
+    rootWood = CountWood(*state);
+    EvaluateAll(genomes.data(), fitness.data(), 0, populationSize);
+
+    generations = 0;
+    while(maxGenerations == 0 || generations < maxGenerations)
+    {
+        Evolve();
+        generations++;
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        if(elapsed.count() >= budget)
+        {
+            break;
+        }
+    }
+
+    const int best = int(std::max_element(fitness.begin(), fitness.end()) - fitness.begin());
+    const Move move = genomes[size_t(best) * horizon];
+
+    // roll the horizon: the plans continue where they left off
+    for(int i = 0; i < populationSize; i++)
+    {
+        Move* g = &genomes[size_t(i) * horizon];
+        std::copy(g + 1, g + horizon, g);
+        g[horizon - 1] = Move(gene(rng));
+    }
+    root = nullptr;
+    return move;
+}
+
+}
@@ -11,7 +11,7 @@ namespace agents
 
 bool _CheckPos(const State& state, int x, int y)
 {
-    return !util::IsOutOfBounds(x, y) && IS_WALKABLE(state.board[y][x]);
+    return IS_WALKABLE(state.board[y][x]);
 }
 
 SimpleAgent::SimpleAgent()
@@ -34,11 +34,11 @@ bool _HasRPLoop(SimpleAgent& me)
     return true;
 }
 
-Move _MoveSafeOneSpace(SimpleAgent& me, const State* state)
+Move _MoveSafeOneSpace(SimpleAgent& me, const State* state, const DangerMap& d)
 {
     const AgentInfo& a = state->agents[me.id];
     me.moveQueue.count = 0;
-    SafeDirections(*state, me.moveQueue, a.x, a.y);
+    SafeDirections(*state, d, me.moveQueue, a.x, a.y);
     SortDirections(me.moveQueue, me.recentPositions, a.x, a.y);
 
     if(me.moveQueue.count == 0)
@@ -48,25 +48,24 @@ Move _MoveSafeOneSpace(SimpleAgent& me, const State* state)
 }
 
 
-Move _Decide(SimpleAgent& me, const State* state)
+Move _Decide(SimpleAgent& me, const State* state, const RMap& r, const DangerMap& d)
 {
     const AgentInfo& a = state->agents[me.id];
-    FillRMap(*state, me.r, me.id);
 
-    me.danger = IsInDanger(*state, me.id);
+    me.danger = d.Get(a.x, a.y);
 
     if(me.danger > 0) // ignore danger if not too high
     {
-        Move m = MoveTowardsSafePlace(*state, me.r, me.danger);
+        Move m = MoveTowardsSafePlace(d, r, me.danger);
         Position p = util::DesiredPosition(a.x, a.y, m);
-        if(!util::IsOutOfBounds(p.x, p.y) && IS_WALKABLE(state->board[p.y][p.x]) &&
-                _safe_condition(IsInDanger(*state, p.x, p.y), 2))
+        if(IS_WALKABLE(state->board[p.y][p.x]) &&
+                _safe_condition(d.Get(p.x, p.y), 2))
         {
             return m;
         }
         else // move towards safe direction
         {
-            return _MoveSafeOneSpace(me, state);
+            return _MoveSafeOneSpace(me, state, d);
         }
 
     }
@@ -86,10 +85,10 @@ Move _Decide(SimpleAgent& me, const State* state)
         }
         if(IsAdjacentEnemy(*state, me.id, 7))
         {
-            Move m = MoveTowardsEnemy(*state, me.r, 7);
+            Move m = MoveTowardsEnemy(*state, r, 7);
             Position p = util::DesiredPosition(a.x, a.y, m);
-            if(!util::IsOutOfBounds(p.x, p.y) && IS_WALKABLE(state->board[p.y][p.x]) &&
-                    _safe_condition(IsInDanger(*state, p.x, p.y), 5))
+            if(IS_WALKABLE(state->board[p.y][p.x]) &&
+                    _safe_condition(d.Get(p.x, p.y), 5))
             {
                 return m;
             }
@@ -101,7 +100,7 @@ Move _Decide(SimpleAgent& me, const State* state)
         }
     }
     me.moveQueue.count = 0;
-    SafeDirections(*state, me.moveQueue, a.x, a.y);
+    SafeDirections(*state, d, me.moveQueue, a.x, a.y);
     SortDirections(me.moveQueue, me.recentPositions, a.x, a.y);
 
     if(me.moveQueue.count == 0)
@@ -113,21 +112,33 @@ Move _Decide(SimpleAgent& me, const State* state)
         return me.moveQueue[me.intDist(me.rng) % 2];
     }
 }
-Move SimpleAgent::act(const State* state)
+Move _Act(SimpleAgent& me, const State* state, const RMap& r, const DangerMap& d)
 {
-    const AgentInfo& a = state->agents[id];
-    Move m = _Decide(*this, state);
+    const AgentInfo& a = state->agents[me.id];
+    Move m = _Decide(me, state, r, d);
     Position p = util::DesiredPosition(a.x, a.y, m);
 
-    if(recentPositions.RemainingCapacity() == 0)
+    if(me.recentPositions.RemainingCapacity() == 0)
     {
-        recentPositions.PopElem();
+        me.recentPositions.PopElem();
     }
-    recentPositions.AddElem(p);
+    me.recentPositions.AddElem(p);
 
     return m;
 }
 
+Move SimpleAgent::act(const State* state)
+{
+    FillRMap(*state, r, id);
+    FillDangerMap(*state, dangerMap);
+    return _Act(*this, state, r, dangerMap);
+}
+
+Move SimpleAgent::act(const State* state, const AnalysisContext& analysis)
+{
+    return _Act(*this, state, analysis.GetRMap(id), analysis.GetDangerMap());
+}
+
 void SimpleAgent::PrintDetailedInfo()
 {
     for(int i = 0; i < recentPositions.count; i++)
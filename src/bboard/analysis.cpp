@@ -0,0 +1,91 @@
+#include "bboard.hpp"
+#include "analysis.hpp"
+
+namespace bboard::strategy
+{
+
+template<typename F>
+void AnalysisContext::Ensure(Part part, F fill) const
+{
+    if(ready[part].load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(locks[part]);
+    if(!ready[part].load(std::memory_order_relaxed))
+    {
+        fill();
+        computeCount++;
+        ready[part].store(true, std::memory_order_release);
+    }
+}
+
+void AnalysisContext::Reset(const State* state)
+{
+    this->state = state;
+    for(int i = 0; i < PART_COUNT; i++)
+    {
+        ready[i].store(false, std::memory_order_relaxed);
+    }
+    computeCount = 0;
+}
+
+const State& AnalysisContext::GetState() const
+{
+    return *state;
+}
+
+const DangerMap& AnalysisContext::GetDangerMap() const
+{
+    Ensure(DANGER, [this]()
+    {
+        FillDangerMap(*state, dangerMap);
+    });
+    return dangerMap;
+}
+
+const Timeline& AnalysisContext::GetTimeline() const
+{
+    Ensure(TIMELINE, [this]()
+    {
+        ProjectState(*state, timeline);
+    });
+    return timeline;
+}
+
+const RMap& AnalysisContext::GetRMap(int agentID) const
+{
+    Ensure(Part(RMAP0 + agentID), [this, agentID]()
+    {
+        FillRMap(*state, rmaps[agentID], agentID);
+    });
+    return rmaps[agentID];
+}
+
+const MoveMask* AnalysisContext::GetLegalMoves() const
+{
+    Ensure(LEGAL, [this]()
+    {
+        LegalMoves(*state, legal);
+    });
+    return legal;
+}
+
+const MoveMask* AnalysisContext::GetNonFatalMoves() const
+{
+    const Timeline& t = GetTimeline();
+    const MoveMask* l = GetLegalMoves();
+    Ensure(NONFATAL, [this, &t, l]()
+    {
+        NonFatalMoves(*state, t, l, nonFatal);
+    });
+    return nonFatal;
+}
+
+int AnalysisContext::GetComputeCount() const
+{
+    return computeCount;
+}
+
+}
@@ -4,6 +4,7 @@
 #include <iostream>
 
 #include "bboard.hpp"
+#include "step_utility.hpp"
 #include "colors.hpp"
 
 namespace bboard
@@ -13,25 +14,42 @@ namespace bboard
 // Auxiliary Functions //
 /////////////////////////
 
+/**
+ * @brief KillByFlame Kills an agent that stands in a flame
+ */
+template<int S, int N>
+void KillByFlame(BasicState<S, N>& s, int agentID, int x, int y, int owner)
+{
+    if(!s.agents[agentID].dead)
+    {
+        s.Kill(agentID);
+        util::RecordEvent(EventType::AGENT_DIED, agentID, x, y, owner);
+    }
+}
+
 /**
  * @brief SpawnFlameItem Spawns a single flame item on the board
  * @param s The state on which the flames should be spawned
  * @param x The x position of the fire
  * @param y The y position of the fire
  * @param signature An auxiliary integer less than 255
+ * @param owner The owner of the flame (for the events)
  * @return Could the flame be spawned?
  */
-bool SpawnFlameItem(State& s, int x, int y, uint16_t signature = 0)
+template<int S, int N>
+bool SpawnFlameItem(BasicState<S, N>& s, int x, int y, uint16_t signature = 0, int owner = -1)
 {
+    typedef typename BasicState<S, N>::Format F;
+
     if(s.board[y][x] >= Item::AGENT0)
     {
-        s.Kill(s.board[y][x] - Item::AGENT0);
+        KillByFlame(s, s.board[y][x] - Item::AGENT0, x, y, owner);
     }
     if(s.board[y][x] == Item::BOMB || s.board[y][x] >= Item::AGENT0)
     {
         for(int i = 0; i < s.bombs.count; i++)
         {
-            if(BMB_POS(s.bombs[i]) == (x + (y << 4)))
+            if(F::Pos(s.bombs[i]) == F::PositionKey(x, y))
             {
                 s.ExplodeBombAt(i);
                 break;
@@ -47,6 +65,7 @@ bool SpawnFlameItem(State& s, int x, int y, uint16_t signature = 0)
         if(wasWood)
         {
             s.board[y][x]+= WOOD_POWFLAG(old); // set the powerup flag
+            util::RecordEvent(EventType::WOOD_DESTROYED, owner, x, y, WOOD_POWFLAG(old));
         }
         return !wasWood; // if wood, then only destroy 1
     }
@@ -90,51 +109,53 @@ int ChooseItemInner(int tmp)
  * @brief PopBomb A proxy for FixedQueue::PopElem, but also
  * takes care of agent count
  */
-inline void PopBomb(State& state)
+template<int S, int N>
+inline void PopBomb(BasicState<S, N>& state)
 {
-    state.agents[BMB_ID(state.bombs[0])].bombCount--;
+    state.agents[BasicState<S, N>::Format::ID(state.bombs[0])].bombCount--;
     state.bombs.PopElem();
 }
 
-/**
- * @brief IsOutOfBounds Checks wether a given position is out of bounds
- */
-inline bool IsOutOfBounds(const int& x, const int& y)
-{
-    return x < 0 || y < 0 || x >= BOARD_SIZE || y >= BOARD_SIZE;
-}
-
 ///////////////////
 // State Methods //
 ///////////////////
 
-void State::ExplodeBombAt(int i)
+template<int S, int N>
+void BasicState<S, N>::ExplodeBombAt(int i)
 {
-    int x = BMB_POS_X(bombs[i]);
-    int y = BMB_POS_Y(bombs[i]);
-    SpawnFlame(x, y, agents[BMB_ID(bombs[i])].bombStrength);
-    agents[BMB_ID(bombs[i])].bombCount--;
+    // remove the bomb first, the flames can explode (and remove)
+    // other bombs of the queue, which shifts the index i
+    const Bomb b = bombs[i];
+    const int id = Format::ID(b);
     bombs.RemoveAt(i);
+    agents[id].bombCount--;
+    util::RecordEvent(EventType::BOMB_EXPLODED, id, Format::PosX(b), Format::PosY(b),
+                      agents[id].bombStrength);
+    SpawnFlame(Format::PosX(b), Format::PosY(b), agents[id].bombStrength, id);
 }
 
-void State::PlantBomb(int x, int y, int id, bool setItem)
+template<int S, int N>
+void BasicState<S, N>::PlantBomb(int x, int y, int id, bool setItem)
 {
     PlantBombModifiedLife(x, y,  id, BOMB_LIFETIME, setItem);
 }
 
-void State::PlantBombModifiedLife(int x, int y, int id, int lifeTime, bool setItem)
+template<int S, int N>
+void BasicState<S, N>::PlantBombModifiedLife(int x, int y, int id, int lifeTime, bool setItem)
 {
     if(agents[id].bombCount >= agents[id].maxBombCount)
     {
         return;
     }
 
+    // the slot may still hold an old (kicked) bomb, so start with
+    // an empty one that doesn't move
     Bomb* b = &bombs.NextPos();
-    SetBombID(*b, id);
-    SetBombPosition(*b, x, y);
-    SetBombStrength(*b, agents[id].bombStrength);
-    // TODO: velocity
-    SetBombTime(*b, lifeTime);
+    *b = 0;
+    Format::SetID(*b, id);
+    Format::SetPosition(*b, x, y);
+    Format::SetStrength(*b, agents[id].bombStrength);
+    Format::SetTime(*b, lifeTime);
 
     if(setItem)
     {
@@ -145,41 +166,41 @@ void State::PlantBombModifiedLife(int x, int y, int id, int lifeTime, bool setIt
     bombs.count++;
 }
 
-void State::PopFlame()
+template<int S, int N>
+void BasicState<S, N>::PopFlame()
 {
     Flame& f = flames[0];
     const int s = f.strength;
     int x = f.position.x;
     int y = f.position.y;
 
-    uint16_t signature = uint16_t(x + BOARD_SIZE * y);
+    uint16_t signature = uint16_t(x + S * y);
 
-    // iterate over both axis (from x-s to x+s // y-s to y+s)
-    for(int i = -s; i <= s; i++)
+    // iterate over both axis (from x-s to x+s // y-s to y+s),
+    // clamped to the board
+    for(int i = std::max(-s, -x); i <= std::min(s, S - 1 - x); i++)
     {
-        if(!IsOutOfBounds(x + i, y) && IS_FLAME(board[y][x + i]))
+        int b = board[y][x + i];
+        // only remove if this is my own flame
+        if(IS_FLAME(b) && FLAME_ID(b) == signature)
         {
-            // only remove if this is my own flame
-            int b = board[y][x + i];
-            if(FLAME_ID(b) == signature)
-            {
-                board[y][x + i] = FlagItem(FLAME_POWFLAG(b));
-            }
+            board[y][x + i] = FlagItem(FLAME_POWFLAG(b));
         }
-        if(!IsOutOfBounds(x, y + i) && IS_FLAME(board[y + i][x]))
+    }
+    for(int i = std::max(-s, -y); i <= std::min(s, S - 1 - y); i++)
+    {
+        int b = board[y + i][x];
+        if(IS_FLAME(b) && FLAME_ID(b) == signature)
         {
-            int b = board[y + i][x];
-            if(FLAME_ID(b) == signature)
-            {
-                board[y + i][x] = FlagItem(FLAME_POWFLAG(b));
-            }
+            board[y + i][x] = FlagItem(FLAME_POWFLAG(b));
         }
     }
 
     flames.PopElem();
 }
 
-Item State::FlagItem(int pwp)
+template<int S, int N>
+Item BasicState<S, N>::FlagItem(int pwp)
 {
     if     (pwp == 0) return Item::PASSAGE;
     else if(pwp == 1) return Item::EXTRABOMB;
@@ -188,41 +209,46 @@ Item State::FlagItem(int pwp)
     else              return Item::PASSAGE;
 }
 
-void State::ExplodeTopBomb()
+template<int S, int N>
+void BasicState<S, N>::ExplodeTopBomb()
 {
     Bomb& c = bombs[0];
-    SpawnFlame(BMB_POS_X(c), BMB_POS_Y(c), BMB_STRENGTH(c));
+    util::RecordEvent(EventType::BOMB_EXPLODED, Format::ID(c), Format::PosX(c), Format::PosY(c),
+                      Format::Strength(c));
+    SpawnFlame(Format::PosX(c), Format::PosY(c), Format::Strength(c), Format::ID(c));
     PopBomb(*this);
 }
 
-void State::SpawnFlame(int x, int y, int strength)
+template<int S, int N>
+void BasicState<S, N>::SpawnFlame(int x, int y, int strength, int owner)
 {
     Flame& f = flames.NextPos();
     f.position.x = x;
     f.position.y = y;
     f.strength = strength;
     f.timeLeft = FLAME_LIFETIME;
+    f.owner = owner;
 
     // unique flame id
-    uint16_t signature = uint16_t((x + BOARD_SIZE * y) << 3);
+    uint16_t signature = uint16_t((x + S * y) << 3);
 
     flames.count++;
 
     // kill agent possibly in origin
     if(board[y][x] >= Item::AGENT0)
     {
-        Kill(board[y][x] - Item::AGENT0);
+        KillByFlame(*this, board[y][x] - Item::AGENT0, x, y, owner);
     }
 
     // override origin
     board[y][x] = Item::FLAMES + signature;
 
+    // the rays stop at the border (rigid)
+
     // right
     for(int i = 1; i <= strength; i++)
     {
-        if(x + i >= BOARD_SIZE) break; // bounds
-
-        if(!SpawnFlameItem(*this, x + i, y, signature))
+        if(!SpawnFlameItem(*this, x + i, y, signature, owner))
         {
             break;
         }
@@ -231,9 +257,7 @@ void State::SpawnFlame(int x, int y, int strength)
     // left
     for(int i = 1; i <= strength; i++)
     {
-        if(x - i < 0) break; // bounds
-
-        if(!SpawnFlameItem(*this, x - i, y, signature))
+        if(!SpawnFlameItem(*this, x - i, y, signature, owner))
         {
             break;
         }
@@ -242,9 +266,7 @@ void State::SpawnFlame(int x, int y, int strength)
     // top
     for(int i = 1; i <= strength; i++)
     {
-        if(y + i >= BOARD_SIZE) break; // bounds
-
-        if(!SpawnFlameItem(*this, x, y + i, signature))
+        if(!SpawnFlameItem(*this, x, y + i, signature, owner))
         {
             break;
         }
@@ -253,20 +275,19 @@ void State::SpawnFlame(int x, int y, int strength)
     // bottom
     for(int i = 1; i <= strength; i++)
     {
-        if(y - i < 0) break; // bounds
-
-        if(!SpawnFlameItem(*this, x, y - i, signature))
+        if(!SpawnFlameItem(*this, x, y - i, signature, owner))
         {
             break;
         }
     }
 }
 
-bool State::HasBomb(int x, int y)
+template<int S, int N>
+bool BasicState<S, N>::HasBomb(int x, int y)
 {
     for(int i = 0; i < bombs.count; i++)
     {
-        if(BMB_POS_X(bombs[i]) == x && BMB_POS_Y(bombs[i]) == y)
+        if(Format::PosX(bombs[i]) == x && Format::PosY(bombs[i]) == y)
         {
             return true;
         }
@@ -274,11 +295,12 @@ bool State::HasBomb(int x, int y)
     return false;
 }
 
-Bomb* State::GetBomb(int x, int y)
+template<int S, int N>
+Bomb* BasicState<S, N>::GetBomb(int x, int y)
 {
     for(int i = 0; i < bombs.count; i++)
     {
-        if(BMB_POS_X(bombs[i]) == x && BMB_POS_Y(bombs[i]) == y)
+        if(Format::PosX(bombs[i]) == x && Format::PosY(bombs[i]) == y)
         {
             return &bombs[i];
         }
@@ -286,9 +308,10 @@ Bomb* State::GetBomb(int x, int y)
     return nullptr;
 }
 
-int State::GetAgent(int x, int y)
+template<int S, int N>
+int BasicState<S, N>::GetAgent(int x, int y)
 {
-    for(int i = 0; i < AGENT_COUNT; i++)
+    for(int i = 0; i < N; i++)
     {
         if(!agents[i].dead && agents[i].x == x && agents[i].y == y)
         {
@@ -298,11 +321,12 @@ int State::GetAgent(int x, int y)
     return -1;
 }
 
-int State::GetBombIndex(int x, int y)
+template<int S, int N>
+int BasicState<S, N>::GetBombIndex(int x, int y)
 {
     for(int i = 0; i < bombs.count; i++)
     {
-        if(BMB_POS_X(bombs[i]) == x && BMB_POS_Y(bombs[i]) == y)
+        if(Format::PosX(bombs[i]) == x && Format::PosY(bombs[i]) == y)
         {
             return i;
         }
@@ -310,7 +334,8 @@ int State::GetBombIndex(int x, int y)
     return -1;
 }
 
-void State::PutAgent(int x, int y, int agentID)
+template<int S, int N>
+void BasicState<S, N>::PutAgent(int x, int y, int agentID)
 {
     int b = Item::AGENT0 + agentID;
     board[y][x] = b;
@@ -319,60 +344,81 @@ void State::PutAgent(int x, int y, int agentID)
     agents[agentID].y = y;
 }
 
-void State::PutAgentsInCorners(int a0, int a1, int a2, int a3)
+template<int S, int N>
+void BasicState<S, N>::PutAgentsInCorners(int a0, int a1, int a2, int a3)
 {
-    int b = Item::AGENT0;
-
-    board[0][0] = b + a0;
-    board[0][BOARD_SIZE - 1] = b + a1;
-    board[BOARD_SIZE - 1][BOARD_SIZE - 1] = b + a2;
-    board[BOARD_SIZE - 1][0] = b + a3;
-
-    agents[a1].x = agents[a2].x = BOARD_SIZE - 1;
-    agents[a2].y = agents[a3].y = BOARD_SIZE - 1;
+    const int ids[4] = {a0, a1, a2, a3};
+    const int ring = 4 * (S - 1);
+    for(int k = 0; k < N; k++)
+    {
+        const int id = k < 4 ? ids[k] : k;
+        // walk clockwise along the border, starting top left
+        const int p = k * ring / N;
+        const int side = p / (S - 1);
+        const int offset = p % (S - 1);
+        if     (side == 0) PutAgent(offset, 0, id);
+        else if(side == 1) PutAgent(S - 1, offset, id);
+        else if(side == 2) PutAgent(S - 1 - offset, S - 1, id);
+        else               PutAgent(0, S - 1 - offset, id);
+    }
 }
 
 //////////////////////
 // bboard namespace //
 //////////////////////
 
-void InitState(State* result, int a0, int a1, int a2, int a3)
+template<int S, int N>
+void InitState(BasicState<S, N>* result, int a0, int a1, int a2, int a3)
 {
     // Randomly put obstacles
     InitBoardItems(*result);
     result->PutAgentsInCorners(a0, a1, a2, a3);
 }
 
-void InitBoardItems(State& result, int seed)
+template<int S, int N>
+void InitBoardItems(BasicState<S, N>& result, int seed)
 {
     std::mt19937_64 rng(seed);
     std::uniform_int_distribution<int> intDist(0,6);
 
-    FixedQueue<int, BOARD_SIZE * BOARD_SIZE> q;
+    FixedQueue<int, S * S> q;
 
-    for(int i = 0; i < BOARD_SIZE; i++)
+    for(int i = 0; i < S; i++)
     {
-        for(int  j = 0; j < BOARD_SIZE; j++)
+        for(int  j = 0; j < S; j++)
         {
             int tmp = intDist(rng);
             result.board[i][j] = ChooseItemOuter(tmp);
 
             if(IS_WOOD(result.board[i][j]))
             {
-                q.AddElem(j + BOARD_SIZE * i);
+                q.AddElem(j + S * i);
             }
         }
     }
 
+    if(q.count == 0)
+    {
+        // no wood to hide power-ups in (possible on small boards)
+        return;
+    }
+
     std::uniform_int_distribution<int> idxSample(0, q.count);
     std::uniform_int_distribution<int> choosePwp(1, 4);
     int total = 0;
     while(true)
     {
-        int idx = q[idxSample(rng)];
-        if((result.board[0][idx] & 0xFF) == 0)
+        const int k = idxSample(rng);
+        if(k == q.count)
+        {
+            // keep the sampling sequence but never read past the queue
+            continue;
+        }
+        int idx = q[k];
+        int& item = result.board[idx / S][idx % S];
+        if((item & 0xFF) == 0)
         {
-            result.board[0][idx] += choosePwp(rng);
+            item += choosePwp(rng);
             total++;
         }
 
@@ -381,9 +427,91 @@ void InitBoardItems(State& result, int seed)
     }
 }
 
+inline void _HashCombine(uint64_t& h, uint64_t value)
+{
+    h = (h ^ value) * 0x9E3779B97F4A7C15ULL;
+    h ^= h >> 29;
+}
+
+template<int S, int N>
+uint64_t HashState(const BasicState<S, N>& state)
+{
+    uint64_t h = 0xCBF29CE484222325ULL;
+
+    for(int y = 0; y < S; y++)
+    {
+        for(int x = 0; x < S; x++)
+        {
+            _HashCombine(h, uint32_t(state.board[y][x]));
+        }
+    }
+    for(int i = 0; i < N; i++)
+    {
+        const AgentInfo& a = state.agents[i];
+        _HashCombine(h, uint64_t(a.x) | uint64_t(a.y) << 16 | uint64_t(a.dead) << 32
+                     | uint64_t(a.canKick) << 33);
+        _HashCombine(h, uint64_t(a.bombCount) | uint64_t(a.maxBombCount) << 16
+                     | uint64_t(a.bombStrength) << 32);
+    }
+    _HashCombine(h, uint64_t(state.bombs.count) | uint64_t(state.flames.count) << 32);
+    for(int i = 0; i < state.bombs.count; i++)
+    {
+        _HashCombine(h, uint32_t(state.bombs[i]));
+    }
+    for(int i = 0; i < state.flames.count; i++)
+    {
+        const Flame& f = state.flames[i];
+        _HashCombine(h, uint64_t(f.position.x) | uint64_t(f.position.y) << 16
+                     | uint64_t(f.timeLeft) << 32 | uint64_t(f.strength) << 48);
+    }
+    return h;
+}
+
+template<int S, int N>
+bool EqualStates(const BasicState<S, N>& a, const BasicState<S, N>& b)
+{
+    if(a.aliveAgents != b.aliveAgents || a.bombs.count != b.bombs.count
+            || a.flames.count != b.flames.count)
+    {
+        return false;
+    }
+    for(int y = 0; y < S; y++)
+    {
+        for(int x = 0; x < S; x++)
+        {
+            if(a.board[y][x] != b.board[y][x]) return false;
+        }
+    }
+    for(int i = 0; i < N; i++)
+    {
+        const AgentInfo& p = a.agents[i];
+        const AgentInfo& q = b.agents[i];
+        if(p.x != q.x || p.y != q.y || p.dead != q.dead || p.canKick != q.canKick
+                || p.bombCount != q.bombCount || p.maxBombCount != q.maxBombCount
+                || p.bombStrength != q.bombStrength)
+        {
+            return false;
+        }
+    }
+    for(int i = 0; i < a.bombs.count; i++)
+    {
+        if(a.bombs[i] != b.bombs[i]) return false;
+    }
+    for(int i = 0; i < a.flames.count; i++)
+    {
+        const Flame& f = a.flames[i];
+        const Flame& g = b.flames[i];
+        if(!(f.position == g.position) || f.timeLeft != g.timeLeft || f.strength != g.strength)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 void StartGame(State* state, Agent* agents[AGENT_COUNT], int timeSteps)
 {
-    Move moves[4];
+    Move moves[AGENT_COUNT];
 
     for(int i = 0; i < timeSteps; i++)
     {
@@ -400,7 +528,8 @@ void StartGame(State* state, Agent* agents[AGENT_COUNT], int timeSteps)
     }
 }
 
-void PrintState(State* state, bool clearConsole)
+template<int S, int N>
+void PrintState(BasicState<S, N>* state, bool clearConsole)
 {
     std::string result = "";
 
@@ -408,9 +537,9 @@ void PrintState(State* state, bool clearConsole)
     if(clearConsole)
         std::cout << "\033c";
 
-    for(int y = 0; y < BOARD_SIZE; y++)
+    for(int y = 0; y < S; y++)
     {
-        for(int x = 0; x < BOARD_SIZE; x++)
+        for(int x = 0; x < S; x++)
         {
             int item = state->board[y][x];
             result += PrintItem(item);
@@ -418,7 +547,7 @@ void PrintState(State* state, bool clearConsole)
         std::cout << (result) << "          ";
         result = "";
         // Print AgentInfo
-        if(y < AGENT_COUNT)
+        if(y < N)
         {
             int i = y;
             std::printf("Agent %d: %s %d  %s %d  %s %d",
@@ -427,16 +556,16 @@ void PrintState(State* state, bool clearConsole)
                         PrintItem(Item::INCRRANGE).c_str(),state->agents[i].bombStrength,
                         PrintItem(Item::KICK).c_str(),state->agents[i].canKick);
         }
-        else if(y == AGENT_COUNT + 1)
+        else if(y == N + 1)
         {
             std::cout << "Bombs:  [  ";
             for(int i = 0; i < state->bombs.count; i++)
             {
-                std::cout << BMB_ID(state->bombs[i]) << "  ";
+                std::cout << BasicState<S, N>::Format::ID(state->bombs[i]) << "  ";
             }
             std::cout << "]";
         }
-        else if(y == AGENT_COUNT + 2)
+        else if(y == N + 2)
         {
             std::cout << "Flames: [  ";
             for(int i = 0; i < state->flames.count; i++)
@@ -488,5 +617,18 @@ std::string PrintItem(int item)
     }
 }
 
-}
+////////////////////////////
+// Explicit Instantiation //
+////////////////////////////
+
+#define INSTANTIATE_STATE(S, N)                                                  \
+    template struct BasicState<S, N>;                                            \
+    template void InitBoardItems(BasicState<S, N>&, int);                        \
+    template void InitState(BasicState<S, N>*, int, int, int, int);              \
+    template uint64_t HashState(const BasicState<S, N>&);                        \
+    template bool EqualStates(const BasicState<S, N>&, const BasicState<S, N>&); \
+    template void PrintState(BasicState<S, N>*, bool);
 
+BBOARD_FOR_EACH_SHAPE(INSTANTIATE_STATE)
+
+}
@@ -0,0 +1,368 @@
+#include <cmath>
+#include <algorithm>
+
+#include "bboard.hpp"
+#include "duct.hpp"
+#include "symmetry.hpp"
+
+namespace bboard::search
+{
+
+namespace
+{
+
+/**
+ * @brief SYMMETRY_SALT Separates the approximate entries of
+ * mergeSymmetries from the exact ones in a shared table
+ */
+const uint64_t SYMMETRY_SALT = 0xD6E8FEB86659FD93ULL;
+
+inline size_t Slot(int parent, uint64_t hash, size_t mask)
+{
+    uint64_t x = hash ^ (uint64_t(parent) * 0x9E3779B97F4A7C15ULL);
+    x = (x ^ (x >> 29)) * 0xBF58476D1CE4E5B9ULL;
+    return size_t(x ^ (x >> 32)) & mask;
+}
+
+/**
+ * @brief Rewards Writes the reward of every agent if at most one agent
+ * is alive
+ */
+bool Rewards(const State& state, float rewards[AGENT_COUNT])
+{
+    int alive = 0;
+    for(int i = 0; i < AGENT_COUNT; i++)
+    {
+        alive += !state.agents[i].dead;
+    }
+    if(alive > 1)
+    {
+        return false;
+    }
+    for(int i = 0; i < AGENT_COUNT; i++)
+    {
+        strategy::TerminalValue(state, i, rewards[i]);
+    }
+    return true;
+}
+
+}
+
+DecoupledUCT::DecoupledUCT(int maxNodes, uint64_t seed)
+    : rng(seed), maxNodes(std::max(1, maxNodes))
+{
+    nodes.reserve(this->maxNodes);
+    size_t size = 1;
+    while(size < 2 * size_t(this->maxNodes))
+    {
+        size *= 2;
+    }
+    table.resize(size);
+    path.reserve(64);
+}
+
+int DecoupledUCT::AddNode(int parent, uint64_t hash, const State& state)
+{
+    if(int(nodes.size()) == maxNodes)
+    {
+        return -1;
+    }
+    nodes.emplace_back();
+    const int index = int(nodes.size()) - 1;
+    DUCTNode& n = nodes[index];
+    n.hash = hash;
+    n.parent = parent;
+    n.visits = 0;
+    strategy::LegalMoves(state, n.legal);
+    std::fill_n(&n.stats[0].visits[0], AGENT_COUNT * ACTION_COUNT, 0);
+    for(ActionStats& s : n.stats)
+    {
+        std::fill_n(s.reward, ACTION_COUNT, 0.0f);
+    }
+
+    if(parent >= 0)
+    {
+        size_t t = Slot(parent, hash, table.size() - 1);
+        while(table[t] != -1)
+        {
+            t = (t + 1) & (table.size() - 1);
+        }
+        table[t] = index;
+    }
+    return index;
+}
+
+int DecoupledUCT::GetChild(int node, uint64_t hash) const
+{
+    // linear probing
+    size_t t = Slot(node, hash, table.size() - 1);
+    while(table[t] != -1)
+    {
+        const DUCTNode& n = nodes[table[t]];
+        if(n.hash == hash && n.parent == node)
+        {
+            return table[t];
+        }
+        t = (t + 1) & (table.size() - 1);
+    }
+    return -1;
+}
+
+size_t DecoupledUCT::GetMemoryUsage() const
+{
+    return nodes.capacity() * sizeof(DUCTNode) + table.size() * sizeof(int);
+}
+
+Move DecoupledUCT::Select(const DUCTNode& node, int agentID, float& probability)
+{
+    const strategy::MoveMask legal = node.legal[agentID];
+    const ActionStats& s = node.stats[agentID];
+    probability = 1.0f;
+    if((legal & (legal - 1)) == 0)
+    {
+        // a single option (dead agents idle)
+        return Move(__builtin_ctz(legal));
+    }
+
+    if(selection == Selection::UCT)
+    {
+        // every move is tried once, in a random order
+        int untried = 0;
+        for(int m = 0; m < ACTION_COUNT; m++)
+        {
+            untried += strategy::HasMove(legal, Move(m)) && s.visits[m] == 0;
+        }
+        if(untried > 0)
+        {
+            int k = std::uniform_int_distribution<int>(0, untried - 1)(rng);
+            for(int m = 0; m < ACTION_COUNT; m++)
+            {
+                if(strategy::HasMove(legal, Move(m)) && s.visits[m] == 0 && k-- == 0)
+                {
+                    return Move(m);
+                }
+            }
+        }
+
+        const float logVisits = std::log(float(node.visits));
+        int best = 0;
+        float bestScore = -1e9f;
+        for(int m = 0; m < ACTION_COUNT; m++)
+        {
+            if(!strategy::HasMove(legal, Move(m)))
+            {
+                continue;
+            }
+            const float score = s.reward[m] / s.visits[m]
+                                + exploration * std::sqrt(logVisits / s.visits[m]);
+            if(score > bestScore)
+            {
+                best = m;
+                bestScore = score;
+            }
+        }
+        return Move(best);
+    }
+
+    // EXP3 with the learning rate gamma / K
+    const int k = __builtin_popcount(legal);
+    const float eta = gamma / k;
+    float maxReward = -1e30f;
+    for(int m = 0; m < ACTION_COUNT; m++)
+    {
+        if(strategy::HasMove(legal, Move(m)))
+        {
+            maxReward = std::max(maxReward, s.reward[m]);
+        }
+    }
+    float p[ACTION_COUNT] = {};
+    float sum = 0;
+    for(int m = 0; m < ACTION_COUNT; m++)
+    {
+        if(strategy::HasMove(legal, Move(m)))
+        {
+            p[m] = std::exp(eta * (s.reward[m] - maxReward));
+            sum += p[m];
+        }
+    }
+    float r = std::uniform_real_distribution<float>(0.0f, 1.0f)(rng);
+    int last = 0;
+    for(int m = 0; m < ACTION_COUNT; m++)
+    {
+        if(!strategy::HasMove(legal, Move(m)))
+        {
+            continue;
+        }
+        p[m] = (1 - gamma) * p[m] / sum + gamma / k;
+        last = m;
+        if(r < p[m])
+        {
+            probability = p[m];
+            return Move(m);
+        }
+        r -= p[m];
+    }
+    // rounding
+    probability = p[last];
+    return Move(last);
+}
+
+void DecoupledUCT::Rollout(State& state, float rewards[AGENT_COUNT])
+{
+    Move moves[AGENT_COUNT];
+    strategy::MoveMask legal[AGENT_COUNT];
+    for(int t = 0; t < rolloutDepth; t++)
+    {
+        if(Rewards(state, rewards))
+        {
+            return;
+        }
+        strategy::LegalMoves(state, legal);
+        for(int i = 0; i < AGENT_COUNT; i++)
+        {
+            moves[i] = strategy::RandomLegalMove(legal[i], rng);
+        }
+        Step(&state, moves);
+    }
+
+    if(!Rewards(state, rewards))
+    {
+        for(int i = 0; i < AGENT_COUNT; i++)
+        {
+            rewards[i] = state.agents[i].dead ? -1.0f : 0.0f;
+        }
+    }
+}
+
+void DecoupledUCT::Evaluate(State& state, uint64_t hash, float rewards[AGENT_COUNT])
+{
+    if(transpositions == nullptr || Rewards(state, rewards))
+    {
+        Rollout(state, rewards);
+        return;
+    }
+
+    if(mergeSymmetries)
+    {
+        hash = CanonicalHash(state) ^ SYMMETRY_SALT;
+    }
+    bool known = true;
+    for(int i = 0; i < AGENT_COUNT && known; i++)
+    {
+        TTData d;
+        rewards[i] = -1.0f;
+        if(!state.agents[i].dead)
+        {
+            known = transpositions->Probe(TranspositionTable::Key(hash, i), d) && d.count >= ttSamples;
+            rewards[i] = d.value;
+        }
+    }
+    if(known)
+    {
+        return;
+    }
+
+    // the leaf is valued by the mean of all its rollouts so far
+    bool alive[AGENT_COUNT];
+    for(int i = 0; i < AGENT_COUNT; i++)
+    {
+        alive[i] = !state.agents[i].dead;
+    }
+    Rollout(state, rewards);
+    for(int i = 0; i < AGENT_COUNT; i++)
+    {
+        if(alive[i])
+        {
+            rewards[i] = transpositions->AddSample(TranspositionTable::Key(hash, i), rewards[i]).value;
+        }
+    }
+}
+
+void DecoupledUCT::Search(const State& root, int iterations)
+{
+    nodes.clear();
+    std::fill(table.begin(), table.end(), -1);
+    AddNode(-1, HashState(root), root);
+
+    State s;
+    float rewards[AGENT_COUNT];
+    for(int k = 0; k < iterations; k++)
+    {
+        s = root;
+        path.clear();
+        int n = 0;
+        while(true)
+        {
+            DUCTNode& node = nodes[n];
+            node.visits++;
+            if(Rewards(s, rewards))
+            {
+                break;
+            }
+            if(int(path.size()) == maxDepth)
+            {
+                Evaluate(s, HashState(s), rewards);
+                break;
+            }
+
+            Edge e;
+            e.node = n;
+            for(int i = 0; i < AGENT_COUNT; i++)
+            {
+                e.moves[i] = Select(node, i, e.probability[i]);
+            }
+            path.push_back(e);
+            Step(&s, e.moves);
+
+            const uint64_t hash = HashState(s);
+            int c = GetChild(n, hash);
+            if(c < 0)
+            {
+                // a new leaf (or a full arena)
+                c = AddNode(n, hash, s);
+                if(c >= 0)
+                {
+                    nodes[c].visits++;
+                }
+                Evaluate(s, hash, rewards);
+                break;
+            }
+            n = c;
+        }
+
+        // every agent learns from its own reward
+        for(const Edge& e : path)
+        {
+            DUCTNode& node = nodes[e.node];
+            for(int i = 0; i < AGENT_COUNT; i++)
+            {
+                const int m = int(e.moves[i]);
+                node.stats[i].visits[m]++;
+                if(selection == Selection::UCT)
+                {
+                    node.stats[i].reward[m] += rewards[i];
+                }
+                else
+                {
+                    node.stats[i].reward[m] += 0.5f * (rewards[i] + 1) / e.probability[i];
+                }
+            }
+        }
+    }
+}
+
+Move DecoupledUCT::BestMove(int agentID) const
+{
+    const ActionStats& s = nodes[0].stats[agentID];
+    int best = int(Move::IDLE);
+    for(int m = 0; m < ACTION_COUNT; m++)
+    {
+        if(s.visits[m] > s.visits[best])
+        {
+            best = m;
+        }
+    }
+    return Move(best);
+}
+
+}
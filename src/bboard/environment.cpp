@@ -4,6 +4,8 @@
 #include <algorithm>
 
 #include "bboard.hpp"
+#include "trace.hpp"
+#include "analysis.hpp"
 
 namespace bboard
 {
@@ -48,8 +50,12 @@ void PrintGameResult(Environment& env)
 Environment::Environment()
 {
     state = std::make_unique<State>();
+    analysis = std::make_unique<strategy::AnalysisContext>();
+    analysis->Reset(state.get());
 }
 
+Environment::~Environment() = default;
+
 void Environment::MakeGame(std::array<Agent*, AGENT_COUNT> a, bool random)
 {
     bboard::InitBoardItems(*state.get());
@@ -62,6 +68,7 @@ void Environment::MakeGame(std::array<Agent*, AGENT_COUNT> a, bool random)
     state->PutAgentsInCorners(f[0], f[1], f[2], f[3]);
 
     SetAgents(a);
+    analysis->Reset(state.get());
     hasStarted = true;
 }
 
@@ -76,7 +83,10 @@ void Environment::StartGame(int timeSteps, bool render, bool stepByStep)
             Print();
 
             if(listener)
+            {
+                trace::Span span(trace::ENVIRONMENT, "Listener");
                 listener(*this);
+            }
 
             if(stepByStep)
                 Pause(false);
@@ -87,13 +97,17 @@ void Environment::StartGame(int timeSteps, bool render, bool stepByStep)
     PrintGameResult(*this);
 }
 
-void ProxyAct(Move& writeBack, Agent& agent, State& state)
+void ProxyAct(Move& writeBack, Agent& agent, State& state,
+              const strategy::AnalysisContext& analysis)
 {
-    writeBack = agent.act(&state);
+    trace::Span span(trace::AGENTS, "Agent::act", agent.id);
+    writeBack = agent.act(&state, analysis);
 }
 
 void CollectMovesAsync(Move m[AGENT_COUNT], Environment& e)
 {
+    trace::Span span(trace::ENVIRONMENT, "CollectMovesAsync");
+    trace::Span startUp(trace::ENVIRONMENT, "Thread Start-Up");
     std::thread threads[AGENT_COUNT];
     for(uint i = 0; i < AGENT_COUNT; i++)
     {
@@ -102,10 +116,16 @@ void CollectMovesAsync(Move m[AGENT_COUNT], Environment& e)
             threads[i] = std::thread(ProxyAct,
                                      std::ref(m[i]),
                                      std::ref(*e.GetAgent(i)),
-                                     std::ref(e.GetState()));
+                                     std::ref(e.GetState()),
+                                     std::cref(e.GetAnalysis()));
         }
     }
+    startUp.End();
+    trace::Span pause(trace::ENVIRONMENT, "Time Limit");
     Pause(true); //competitive pause
+    pause.End();
+
+    trace::Span join(trace::ENVIRONMENT, "Join");
     for(uint i = 0; i < AGENT_COUNT; i++)
     {
         if(!e.GetState().agents[i].dead)
@@ -127,8 +147,12 @@ void Environment::Step(bool competitiveTimeLimit)
         return;
     }
 
+    trace::Span span(trace::ENVIRONMENT, "Environment::Step");
     Move m[AGENT_COUNT];
 
+    // nothing is computed until an agent asks for it (the state
+    // might have been modified since the last step)
+    analysis->Reset(state.get());
 
     if(competitiveTimeLimit)
     {
@@ -140,7 +164,8 @@ void Environment::Step(bool competitiveTimeLimit)
         {
             if(!state->agents[i].dead)
             {
-                m[i] = agents[i]->act(state.get());
+                trace::Span act(trace::AGENTS, "Agent::act", int(i));
+                m[i] = agents[i]->act(state.get(), *analysis);
                 lastMoves[i] = m[i];
             }
         }
@@ -148,6 +173,7 @@ void Environment::Step(bool competitiveTimeLimit)
 
     bboard::Step(state.get(), m);
     state->timeStep++;
+    analysis->Reset(state.get());
 
     if(state->aliveAgents == 1)
     {
@@ -170,6 +196,7 @@ void Environment::Step(bool competitiveTimeLimit)
 
 void Environment::Print(bool clear)
 {
+    trace::Span span(trace::ENVIRONMENT, "Print");
     PrintState(state.get(), true);
 }
 
@@ -178,6 +205,11 @@ State& Environment::GetState() const
     return *state.get();
 }
 
+const strategy::AnalysisContext& Environment::GetAnalysis() const
+{
+    return *analysis.get();
+}
+
 Agent* Environment::GetAgent(uint agentID) const
 {
     return agents[agentID];
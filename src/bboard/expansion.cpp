@@ -0,0 +1,122 @@
+#include "bboard.hpp"
+#include "expansion.hpp"
+
+namespace bboard::search
+{
+
+int JointActionExpander::Insert(int slot)
+{
+    const Outcome& o = outcomes[slot];
+    int t = int(o.hash & (TABLE_SIZE - 1));
+
+    // linear probing
+    while(table[t] != -1)
+    {
+        const Outcome& other = outcomes[table[t]];
+        if(other.hash == o.hash && EqualStates(other.state, o.state))
+        {
+            return table[t];
+        }
+        t = (t + 1) & (TABLE_SIZE - 1);
+    }
+    table[t] = int16_t(slot);
+    return slot;
+}
+
+void JointActionExpander::Expand(const State& state)
+{
+    strategy::MoveMask legal[AGENT_COUNT];
+    strategy::LegalMoves(state, legal);
+
+    // the canonical moves of every agent
+    Move options[AGENT_COUNT][ACTION_COUNT];
+    int optionCount[AGENT_COUNT] = {};
+    for(int i = 0; i < AGENT_COUNT; i++)
+    {
+        for(int m = 0; m < ACTION_COUNT; m++)
+        {
+            if(strategy::HasMove(legal[i], Move(m)))
+            {
+                options[i][optionCount[i]++] = Move(m);
+            }
+        }
+    }
+
+    // the move-independent part of the step is shared by all successors
+    prepared = state;
+    PrepareStep(&prepared);
+
+    std::fill(table, table + TABLE_SIZE, -1);
+    outcomeCount = 0;
+    stepCount = 0;
+
+    // iterate over all combinations of canonical moves
+    int option[AGENT_COUNT] = {};
+    Move moves[AGENT_COUNT];
+    while(true)
+    {
+        for(int i = 0; i < AGENT_COUNT; i++)
+        {
+            moves[i] = options[i][option[i]];
+        }
+        const JointAction a = EncodeJointAction(moves);
+
+        Outcome& o = outcomes[outcomeCount];
+        o.state = prepared;
+        ResolveStep(&o.state, moves);
+        o.hash = HashState(o.state);
+        stepCount++;
+
+        const int k = Insert(outcomeCount);
+        if(k == outcomeCount)
+        {
+            o.action = a;
+            o.count = 0;
+            outcomeCount++;
+        }
+        outcomeOfCanonical[a] = int16_t(k);
+
+        int i = 0;
+        for(; i < AGENT_COUNT; i++)
+        {
+            if(++option[i] < optionCount[i])
+            {
+                break;
+            }
+            option[i] = 0;
+        }
+        if(i == AGENT_COUNT)
+        {
+            break;
+        }
+    }
+
+    // map every joint action to its canonical counterpart
+    for(JointAction a = 0; a < JOINT_ACTION_COUNT; a++)
+    {
+        DecodeJointAction(a, moves);
+        for(int i = 0; i < AGENT_COUNT; i++)
+        {
+            moves[i] = CanonicalMove(legal[i], moves[i]);
+        }
+
+        const int k = outcomeOfCanonical[EncodeJointAction(moves)];
+        outcomeOf[a] = int16_t(k);
+        outcomes[k].count++;
+    }
+}
+
+int JointActionExpander::GetJointActions(int outcome, JointAction actions[JOINT_ACTION_COUNT]) const
+{
+    int count = 0;
+    for(JointAction a = 0; a < JOINT_ACTION_COUNT; a++)
+    {
+        if(outcomeOf[a] == outcome)
+        {
+            actions[count++] = a;
+        }
+    }
+    return count;
+}
+
+}
@@ -0,0 +1,339 @@
+#include <cstdlib>
+#include <sstream>
+#include <algorithm>
+
+#include "bboard.hpp"
+#include "fixture.hpp"
+
+namespace bboard
+{
+
+namespace
+{
+
+struct BombLine
+{
+    int x, y;
+    int owner = -1;    // the agent on the cell or 0
+    int timer = BOMB_LIFETIME;
+    int strength = -1; // the owner's
+    Direction dir = Direction::IDLE;
+};
+
+struct FlameLine
+{
+    int x, y;
+    int strength = 1;
+    int timer = FLAME_LIFETIME;
+    int owner = -1;
+};
+
+bool Fail(std::string* error, int line, const std::string& reason)
+{
+    if(error != nullptr)
+    {
+        *error = "line " + std::to_string(line) + ": " + reason;
+    }
+    return false;
+}
+
+bool ParseInt(const std::string& s, int& value)
+{
+    char* end = nullptr;
+    const long v = std::strtol(s.c_str(), &end, 10);
+    if(s.empty() || *end != '\0')
+    {
+        return false;
+    }
+    value = int(v);
+    return true;
+}
+
+bool ParseMove(const std::string& s, Move& m)
+{
+    const char* names[] = {"idle", "up", "down", "left", "right", "bomb"};
+    for(int i = 0; i <= int(Move::BOMB); i++)
+    {
+        if(s == names[i])
+        {
+            m = Move(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief ParseOption Splits `key=value` (or a plain flag)
+ */
+void ParseOption(const std::string& token, std::string& key, std::string& value)
+{
+    const size_t eq = token.find('=');
+    key = token.substr(0, eq);
+    value = eq == std::string::npos ? "" : token.substr(eq + 1);
+}
+
+bool OnBoard(int x, int y)
+{
+    return x >= 0 && y >= 0 && x < BOARD_SIZE && y < BOARD_SIZE;
+}
+
+}
+
+void Fixture::GetMoves(int step, Move m[AGENT_COUNT]) const
+{
+    for(int i = 0; i < AGENT_COUNT; i++)
+    {
+        m[i] = moves.empty() ? Move::IDLE : moves[step % moves.size()][i];
+    }
+}
+
+bool LoadFixture(const std::string& text, Fixture& fixture, std::string* error)
+{
+    State& s = fixture.state;
+    s = State();
+    fixture.moves.clear();
+
+    std::vector<BombLine> bombs;
+    std::vector<FlameLine> flames;
+    bool present[AGENT_COUNT] = {};
+    bool bombLine[BOARD_SIZE][BOARD_SIZE] = {};
+
+    std::istringstream in(text);
+    std::string raw;
+    int lineNumber = 0, rows = 0;
+    while(std::getline(in, raw))
+    {
+        lineNumber++;
+        const std::string line = raw.substr(0, raw.find('#'));
+        std::istringstream tokens(line);
+        std::string keyword;
+        if(!(tokens >> keyword))
+        {
+            continue;
+        }
+
+        if(keyword == "agent")
+        {
+            std::string token, key, value;
+            int id;
+            if(!(tokens >> token) || !ParseInt(token, id) || id < 0 || id >= AGENT_COUNT)
+            {
+                return Fail(error, lineNumber, "expected an agent id");
+            }
+            AgentInfo& a = s.agents[id];
+            while(tokens >> token)
+            {
+                ParseOption(token, key, value);
+                int v;
+                if(key == "kick" && value.empty())
+                {
+                    a.canKick = true;
+                }
+                else if(key == "bombs" && ParseInt(value, v) && v >= 0)
+                {
+                    a.maxBombCount = v;
+                }
+                else if(key == "strength" && ParseInt(value, v) && v >= 1 && v <= 15)
+                {
+                    a.bombStrength = v;
+                }
+                else
+                {
+                    return Fail(error, lineNumber, "unknown agent property " + token);
+                }
+            }
+        }
+        else if(keyword == "bomb" || keyword == "flame")
+        {
+            int x, y;
+            std::string tx, ty;
+            if(!(tokens >> tx >> ty) || !ParseInt(tx, x) || !ParseInt(ty, y) || !OnBoard(x, y))
+            {
+                return Fail(error, lineNumber, "expected a position on the board");
+            }
+            BombLine b;
+            FlameLine f;
+            b.x = f.x = x;
+            b.y = f.y = y;
+            const int maxTimer = keyword == "bomb" ? BOMB_LIFETIME : FLAME_LIFETIME;
+            std::string token, key, value;
+            while(tokens >> token)
+            {
+                ParseOption(token, key, value);
+                int v = 0;
+                const bool isInt = ParseInt(value, v);
+                if(key == "owner" && isInt && v >= 0 && v < AGENT_COUNT)
+                {
+                    b.owner = f.owner = v;
+                }
+                else if(key == "timer" && isInt && v >= 1 && v <= maxTimer)
+                {
+                    b.timer = f.timer = v;
+                }
+                else if(key == "strength" && isInt && v >= 1 && v <= 15)
+                {
+                    b.strength = f.strength = v;
+                }
+                else if(key == "dir" && keyword == "bomb")
+                {
+                    const char* names[] = {"idle", "up", "down", "left", "right"};
+                    auto it = std::find(std::begin(names), std::end(names), value);
+                    if(it == std::end(names))
+                    {
+                        return Fail(error, lineNumber, "unknown direction " + value);
+                    }
+                    b.dir = Direction(it - std::begin(names));
+                }
+                else
+                {
+                    return Fail(error, lineNumber, "unknown " + keyword + " property " + token);
+                }
+            }
+            if(keyword == "bomb")
+            {
+                if(bombLine[y][x])
+                {
+                    return Fail(error, lineNumber, "two bombs on one cell");
+                }
+                bombLine[y][x] = true;
+                bombs.push_back(b);
+            }
+            else
+            {
+                flames.push_back(f);
+            }
+        }
+        else if(keyword == "moves")
+        {
+            std::array<Move, AGENT_COUNT> m;
+            std::string token;
+            for(int i = 0; i < AGENT_COUNT; i++)
+            {
+                if(!(tokens >> token) || !ParseMove(token, m[i]))
+                {
+                    return Fail(error, lineNumber, "expected " + std::to_string(AGENT_COUNT) + " moves");
+                }
+            }
+            fixture.moves.push_back(m);
+        }
+        else
+        {
+            // a row of the board
+            std::string cells;
+            for(char c : line)
+            {
+                if(c != ' ' && c != '\t' && c != '\r')
+                {
+                    cells += c;
+                }
+            }
+            if(rows == BOARD_SIZE)
+            {
+                return Fail(error, lineNumber, "too many rows or an unknown keyword");
+            }
+            if(int(cells.size()) != BOARD_SIZE)
+            {
+                return Fail(error, lineNumber, "a row needs " + std::to_string(BOARD_SIZE) + " cells");
+            }
+            for(int x = 0; x < BOARD_SIZE; x++)
+            {
+                int& cell = s.board[rows][x];
+                const char c = cells[x];
+                switch(c)
+                {
+                    case '.': cell = Item::PASSAGE; break;
+                    case 'X': cell = Item::RIGID; break;
+                    case 'W': cell = Item::WOOD; break;
+                    case 'E': cell = Item::WOOD + 1; break;
+                    case 'R': cell = Item::WOOD + 2; break;
+                    case 'K': cell = Item::WOOD + 3; break;
+                    case 'e': cell = Item::EXTRABOMB; break;
+                    case 'r': cell = Item::INCRRANGE; break;
+                    case 'k': cell = Item::KICK; break;
+                    case 'o': cell = Item::BOMB; break;
+                    default:
+                        if(c < '0' || c >= '0' + AGENT_COUNT || present[c - '0'])
+                        {
+                            return Fail(error, lineNumber, std::string("unknown cell ") + c);
+                        }
+                        present[c - '0'] = true;
+                        s.PutAgent(x, rows, c - '0');
+                }
+            }
+            rows++;
+        }
+    }
+    if(rows != BOARD_SIZE)
+    {
+        return Fail(error, lineNumber, "a board needs " + std::to_string(BOARD_SIZE) + " rows");
+    }
+
+    s.aliveAgents = 0;
+    for(int i = 0; i < AGENT_COUNT; i++)
+    {
+        s.agents[i].dead = !present[i];
+        s.aliveAgents += present[i];
+    }
+
+    // bomb cells without a line
+    for(int y = 0; y < BOARD_SIZE; y++)
+    {
+        for(int x = 0; x < BOARD_SIZE; x++)
+        {
+            if(s.board[y][x] == Item::BOMB && !bombLine[y][x])
+            {
+                BombLine b;
+                b.x = x;
+                b.y = y;
+                bombs.push_back(b);
+            }
+        }
+    }
+    if(int(bombs.size()) > State::MAX_BOMBS || int(flames.size()) > State::MAX_BOMBS)
+    {
+        return Fail(error, lineNumber, "more than " + std::to_string(State::MAX_BOMBS) + " bombs or flames");
+    }
+
+    // bombs explode from the front of the queue
+    std::stable_sort(bombs.begin(), bombs.end(),
+                     [](const BombLine& a, const BombLine& b) { return a.timer < b.timer; });
+    for(BombLine& b : bombs)
+    {
+        int& cell = s.board[b.y][b.x];
+        if(b.owner < 0)
+        {
+            b.owner = IS_AGENT(cell) ? cell - Item::AGENT0 : 0;
+        }
+        if(cell == Item::PASSAGE)
+        {
+            cell = Item::BOMB;
+        }
+        else if(cell != Item::BOMB && !IS_AGENT(cell))
+        {
+            return Fail(error, lineNumber, "a bomb needs a free cell or an agent");
+        }
+        AgentInfo& a = s.agents[b.owner];
+        Bomb& bomb = s.bombs.NextPos();
+        bomb = 0;
+        State::Format::SetID(bomb, b.owner);
+        State::Format::SetPosition(bomb, b.x, b.y);
+        State::Format::SetStrength(bomb, b.strength < 0 ? a.bombStrength : b.strength);
+        State::Format::SetTime(bomb, b.timer);
+        State::Format::SetDirection(bomb, b.dir);
+        s.bombs.count++;
+        a.bombCount++;
+        a.maxBombCount = std::max(a.maxBombCount, a.bombCount);
+    }
+
+    std::stable_sort(flames.begin(), flames.end(),
+                     [](const FlameLine& a, const FlameLine& b) { return a.timer < b.timer; });
+    for(const FlameLine& f : flames)
+    {
+        s.SpawnFlame(f.x, f.y, f.strength, f.owner);
+        s.flames[s.flames.count - 1].timeLeft = f.timer;
+    }
+    return true;
+}
+
+}
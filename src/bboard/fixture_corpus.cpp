@@ -0,0 +1,171 @@
+#include <cstdlib>
+#include <iostream>
+
+#include "bboard.hpp"
+#include "fixture.hpp"
+
+namespace bboard
+{
+
+namespace
+{
+
+struct Entry
+{
+    const char* name;
+    const char* text;
+};
+
+const Entry CORPUS[] =
+{
+    {
+        "Chain Reaction 20",
+        R"(
+        # one bomb sets off all 20, the agents hide at the right border
+        . W . W . W . W . W 0
+        W X W X W X W X W X .
+        o o o o o o o o o o .
+        . X W X W X W X W X .
+        . W . W . W . W . W 1
+        . X W X W X W X W X .
+        . W . W . W . W . W 2
+        . X W X W X W X W X .
+        o o o o o o o o o o .
+        W X W X W X W X W X .
+        . W . W . W . W . W 3
+        agent 0 strength=6
+        bomb 0 2 timer=1
+        )"
+    },
+    {
+        "Ouroboros",
+        R"(
+        # the agents chase each other around a square forever
+        . . . . . . . . . . .
+        . . . . . . . . . . .
+        . . . . . . . . . . .
+        . . . . . . . . . . .
+        . . . . 0 1 . . . . .
+        . . . . 3 2 . . . . .
+        . . . . . . . . . . .
+        . . . . . . . . . . .
+        . . . . . . . . . . .
+        . . . . . . . . . . .
+        . . . . . . . . . . .
+        moves right down left up
+        moves down left up right
+        moves left up right down
+        moves up right down left
+        )"
+    },
+    {
+        "Ouroboros On Bombs",
+        R"(
+        # every agent leaves its bomb for the bomb of the next one
+        . . . . . . . . . . .
+        . . . . . . . . . . .
+        . . . . . . . . . . .
+        . . . . . . . . . . .
+        . . . . 0 1 . . . . .
+        . . . . 3 2 . . . . .
+        . . . . . . . . . . .
+        . . . . . . . . . . .
+        . . . . . . . . . . .
+        . . . . . . . . . . .
+        . . . . . . . . . . .
+        agent 0 kick
+        agent 1 kick
+        agent 2 kick
+        agent 3 kick
+        bomb 4 4
+        bomb 5 4
+        bomb 5 5
+        bomb 4 5
+        moves right down left up
+        moves down left up right
+        moves left up right down
+        moves up right down left
+        )"
+    },
+    {
+        "Four Kickers",
+        R"(
+        # four bombs are kicked into the center at once, two more fly
+        # into each other
+        . . . . . . . . . . .
+        . o . . . . . . . o .
+        . . . . . . . . . . .
+        . . . . . 0 . . . . .
+        . . . . . o . . . . .
+        . . . 3 o . o 1 . . .
+        . . . . . o . . . . .
+        . . . . . 2 . . . . .
+        . . . . . . . . . . .
+        . o . . . . . . . o .
+        . . . . . . . . . . .
+        agent 0 kick
+        agent 1 kick
+        agent 2 kick
+        agent 3 kick
+        bomb 1 1 dir=right
+        bomb 9 1 dir=left
+        bomb 1 9 dir=right
+        bomb 9 9 dir=left
+        moves down left up right
+        moves idle idle idle idle
+        )"
+    },
+    {
+        "Crossing Flames",
+        R"(
+        # nine bombs of the maximum strength explode over burning rows
+        . . . . . . . . . . .
+        . o . . . o . . . o .
+        . . . . . . . . . . .
+        . . . 0 . . . 1 . . .
+        . . . . . . . . . . .
+        . o . . . o . . . o .
+        . . . . . . . . . . .
+        . . . 3 . . . 2 . . .
+        . . . . . . . . . . .
+        . o . . . o . . . o .
+        . . . . . . . . . . .
+        agent 0 strength=10
+        flame 0 0 strength=10 timer=2
+        flame 10 10 strength=10 timer=3
+        flame 10 0 strength=10 timer=4
+        bomb 1 1 timer=1
+        bomb 5 1 timer=1
+        bomb 9 1 timer=1
+        bomb 1 5 timer=1
+        bomb 5 5 timer=1
+        bomb 9 5 timer=1
+        bomb 1 9 timer=1
+        bomb 5 9 timer=1
+        bomb 9 9 timer=1
+        )"
+    },
+};
+
+}
+
+std::vector<Fixture> PathologicalFixtures()
+{
+    std::vector<Fixture> fixtures;
+    for(const Entry& e : CORPUS)
+    {
+        Fixture f;
+        std::string error;
+        if(!LoadFixture(e.text, f, &error))
+        {
+            // the corpus is part of the code, a broken entry is a bug
+            std::cerr << "Fixture \"" << e.name << "\" is invalid, " << error << std::endl;
+            std::abort();
+        }
+        f.name = e.name;
+        fixtures.push_back(f);
+    }
+    return fixtures;
+}
+
+}
@@ -0,0 +1,68 @@
+#include "bboard.hpp"
+#include "projection.hpp"
+#include "step_utility.hpp"
+
+namespace bboard::strategy
+{
+
+int Timeline::NextFlame(int x, int y, int from) const
+{
+    for(int t = from; t <= ticks; t++)
+    {
+        if(IsFlame(t, x, y))
+        {
+            return t;
+        }
+    }
+    return -1;
+}
+
+void FillFlameMask(const State& state, FlameMask& mask)
+{
+    mask.reset();
+    for(int y = 0; y < BOARD_SIZE; y++)
+    {
+        for(int x = 0; x < BOARD_SIZE; x++)
+        {
+            if(IS_FLAME(state.board[y][x]))
+            {
+                mask.set(x + BOARD_SIZE * y);
+            }
+        }
+    }
+}
+
+void ProjectState(const State& state, Timeline& timeline, int ticks)
+{
+    ticks = std::min(ticks, PROJECTION_HORIZON);
+
+    FillFlameMask(state, timeline.flames[0]);
+    timeline.ticks = ticks;
+
+    // agents stay on the board (they block kicked bombs and
+    // can die in the projection), but never move
+    State s = state;
+
+    int t = 1;
+    for(; t <= ticks; t++)
+    {
+        if(s.bombs.count == 0 && s.flames.count == 0)
+        {
+            break;
+        }
+
+        util::TickFlames(s);
+        util::MoveBombsForward(s);
+        util::TickBombs(s);
+
+        FillFlameMask(s, timeline.flames[t]);
+    }
+
+    // nothing is left that could burn
+    for(; t <= PROJECTION_HORIZON; t++)
+    {
+        timeline.flames[t].reset();
+    }
+}
+
+}
@@ -0,0 +1,157 @@
+#include <cstring>
+#include <algorithm>
+
+#include "bboard.hpp"
+#include "snapshot.hpp"
+
+namespace bboard::search
+{
+
+namespace
+{
+
+inline void PutVarint(std::vector<uint8_t>& out, uint32_t v)
+{
+    while(v >= 0x80)
+    {
+        out.push_back(uint8_t(v) | 0x80);
+        v >>= 7;
+    }
+    out.push_back(uint8_t(v));
+}
+
+inline uint32_t GetVarint(const uint8_t*& p)
+{
+    uint32_t v = 0;
+    for(int shift = 0; ; shift += 7)
+    {
+        const uint8_t b = *p++;
+        v |= uint32_t(b & 0x7F) << shift;
+        if(b < 0x80)
+        {
+            return v;
+        }
+    }
+}
+
+inline const uint32_t* Words(const State& state)
+{
+    return reinterpret_cast<const uint32_t*>(&state);
+}
+
+inline uint32_t* Words(State& state)
+{
+    return reinterpret_cast<uint32_t*>(&state);
+}
+
+}
+
+SnapshotTree::SnapshotTree(int checkpointInterval)
+    : checkpointInterval(std::max(1, checkpointInterval))
+{
+}
+
+void SnapshotTree::Reserve(int nodes, int deltaBytes)
+{
+    snapshots.reserve(nodes);
+    deltas.reserve(size_t(nodes) * deltaBytes);
+    checkpoints.reserve(nodes / checkpointInterval + 1);
+}
+
+int SnapshotTree::AddRoot(const State& state)
+{
+    snapshots.clear();
+    deltas.clear();
+    checkpoints.clear();
+    checkpoints.push_back(state);
+    snapshots.push_back({-1, 0, 0, 0, 0});
+    return 0;
+}
+
+int SnapshotTree::Add(int parent, const State& parentState, const State& state)
+{
+    Snapshot s;
+    s.parent = parent;
+    s.depth = uint16_t(snapshots[parent].depth + 1);
+    s.offset = uint32_t(deltas.size());
+    s.checkpoint = -1;
+
+    const uint32_t* a = Words(parentState);
+    const uint32_t* b = Words(state);
+    int last = -1;
+    for(int w = 0; w < WORDS; w++)
+    {
+        const uint32_t x = a[w] ^ b[w];
+        if(x != 0)
+        {
+            PutVarint(deltas, uint32_t(w - last));
+            PutVarint(deltas, x);
+            last = w;
+        }
+    }
+    s.length = uint16_t(deltas.size() - s.offset);
+
+    if(s.depth % checkpointInterval == 0)
+    {
+        s.checkpoint = int(checkpoints.size());
+        checkpoints.push_back(state);
+    }
+    snapshots.push_back(s);
+    return int(snapshots.size()) - 1;
+}
+
+void SnapshotTree::Xor(int node, State& state) const
+{
+    const Snapshot& s = snapshots[node];
+    const uint8_t* p = deltas.data() + s.offset;
+    const uint8_t* end = p + s.length;
+    uint32_t* words = Words(state);
+    int w = -1;
+    while(p < end)
+    {
+        w += int(GetVarint(p));
+        words[w] ^= GetVarint(p);
+    }
+}
+
+void SnapshotTree::Restore(int node, State& state) const
+{
+    int n = node;
+    while(snapshots[n].checkpoint < 0)
+    {
+        n = snapshots[n].parent;
+    }
+    state = checkpoints[snapshots[n].checkpoint];
+
+    // xors commute, so the order of the deltas doesn't matter
+    for(int k = node; k != n; k = snapshots[k].parent)
+    {
+        Xor(k, state);
+    }
+}
+
+void SnapshotTree::Move(int from, int to, State& state) const
+{
+    // climb from both ends to the common ancestor
+    int a = from, b = to;
+    while(a != b)
+    {
+        if(snapshots[a].depth >= snapshots[b].depth)
+        {
+            Xor(a, state);
+            a = snapshots[a].parent;
+        }
+        else
+        {
+            Xor(b, state);
+            b = snapshots[b].parent;
+        }
+    }
+}
+
+size_t SnapshotTree::GetMemoryUsage() const
+{
+    return snapshots.size() * sizeof(Snapshot) + deltas.size() + checkpoints.size() * sizeof(State);
+}
+
+}
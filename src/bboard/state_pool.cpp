@@ -0,0 +1,217 @@
+#include <cstring>
+#include <algorithm>
+
+#include "bboard.hpp"
+#include "state_pool.hpp"
+
+namespace bboard::search
+{
+
+namespace
+{
+
+/**
+ * @brief Hands out small thread indices. An index is reused after its
+ * thread exits, the next thread then takes over the free lists of the
+ * old one.
+ */
+struct ThreadIndex
+{
+    int index;
+
+    ThreadIndex()
+    {
+        std::lock_guard<std::mutex> lock(Mutex());
+        std::vector<int>& released = Released();
+        if(released.empty())
+        {
+            index = Next()++;
+        }
+        else
+        {
+            index = released.back();
+            released.pop_back();
+        }
+    }
+    ~ThreadIndex()
+    {
+        std::lock_guard<std::mutex> lock(Mutex());
+        Released().push_back(index);
+    }
+
+    static std::mutex& Mutex()
+    {
+        static std::mutex m;
+        return m;
+    }
+    static std::vector<int>& Released()
+    {
+        static std::vector<int> r;
+        return r;
+    }
+    static int& Next()
+    {
+        static int n = 0;
+        return n;
+    }
+};
+
+inline int CurrentThread()
+{
+    thread_local ThreadIndex t;
+    return t.index;
+}
+
+inline void Bump(std::atomic<uint64_t>& counter)
+{
+    // only the owner of a cache writes, so no read-modify-write
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+}
+
+StatePool::StatePool(int slabSize, int slabs)
+    : slabSize(std::max(1, slabSize))
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for(int k = 0; k < std::max(1, slabs); k++)
+    {
+        Grow();
+    }
+}
+
+StatePool::~StatePool() = default;
+
+void StatePool::Grow()
+{
+    slabs.emplace_back(new Slot[slabSize]);
+    allocations++;
+    Slot* slab = slabs.back().get();
+    shared.reserve(size_t(slabs.size()) * slabSize);
+    // hand out the first slots first
+    for(int i = slabSize - 1; i >= 0; i--)
+    {
+        shared.push_back(&slab[i].state);
+    }
+}
+
+State* StatePool::AcquireShared()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if(shared.empty())
+    {
+        Grow();
+    }
+    sharedAcquires++;
+    State* s = shared.back();
+    shared.pop_back();
+    return s;
+}
+
+void StatePool::ReleaseShared(State* state)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    sharedReleases++;
+    shared.push_back(state);
+}
+
+State* StatePool::Acquire()
+{
+    const int t = CurrentThread();
+    if(t >= MAX_THREADS)
+    {
+        return AcquireShared();
+    }
+
+    Cache& c = caches[t];
+    if(c.count == 0)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        while(shared.size() < size_t(BATCH))
+        {
+            Grow();
+        }
+        std::copy(shared.end() - BATCH, shared.end(), c.free);
+        shared.resize(shared.size() - BATCH);
+        c.count = BATCH;
+        transfers++;
+    }
+    Bump(c.acquires);
+    return c.free[--c.count];
+}
+
+State* StatePool::Clone(const State& state)
+{
+    State* s = Acquire();
+    std::memcpy(static_cast<void*>(s), &state, sizeof(State));
+
+    const int t = CurrentThread();
+    Bump(t < MAX_THREADS ? caches[t].clones : sharedClones);
+    return s;
+}
+
+void StatePool::Release(State* state)
+{
+    const int t = CurrentThread();
+    if(t >= MAX_THREADS)
+    {
+        ReleaseShared(state);
+        return;
+    }
+
+    Cache& c = caches[t];
+    if(c.count == 2 * BATCH)
+    {
+        // keep half, so alternating calls don't take the lock every time
+        std::lock_guard<std::mutex> lock(mutex);
+        shared.insert(shared.end(), c.free + BATCH, c.free + 2 * BATCH);
+        c.count = BATCH;
+        transfers++;
+    }
+    Bump(c.releases);
+    c.free[c.count++] = state;
+}
+
+void StatePool::Reset()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    shared.clear();
+    for(auto it = slabs.rbegin(); it != slabs.rend(); ++it)
+    {
+        for(int i = slabSize - 1; i >= 0; i--)
+        {
+            shared.push_back(&(*it)[i].state);
+        }
+    }
+    for(Cache& c : caches)
+    {
+        c.count = 0;
+    }
+}
+
+PoolCounters StatePool::GetCounters() const
+{
+    PoolCounters p;
+    for(const Cache& c : caches)
+    {
+        p.acquires += c.acquires.load(std::memory_order_relaxed);
+        p.releases += c.releases.load(std::memory_order_relaxed);
+        p.clones += c.clones.load(std::memory_order_relaxed);
+    }
+    p.clones += sharedClones.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    p.acquires += sharedAcquires;
+    p.releases += sharedReleases;
+    p.allocations = allocations;
+    p.transfers = transfers;
+    return p;
+}
+
+int StatePool::GetCapacity() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return int(slabs.size()) * slabSize;
+}
+
+}
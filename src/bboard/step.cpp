@@ -1,46 +1,104 @@
 #include <iostream>
+#include <algorithm>
 
 #include "bboard.hpp"
+#include "trace.hpp"
 #include "step_utility.hpp"
 
 namespace bboard
 {
 
-void Step(State* state, Move* moves)
+namespace
 {
 
+thread_local StepKernelCounters stepKernelCounters;
+
+}
+
+thread_local StepEvents* util::activeEvents = nullptr;
+
+StepKernelCounters& GetStepKernelCounters()
+{
+    return stepKernelCounters;
+}
+
+template<int S, int N>
+void Step(BasicState<S, N>* state, Move* moves)
+{
+    trace::EngineSpan span(trace::ENGINE, "Step");
+    PrepareStep(state);
+    ResolveStep(state, moves);
+}
+
+template<int S, int N>
+void Step(BasicState<S, N>* state, Move* moves, StepEvents* events)
+{
+    trace::EngineSpan span(trace::ENGINE, "Step");
+    events->Clear();
+    util::activeEvents = events;
+    PrepareStep(state);
+    ResolveStep(state, moves);
+    util::activeEvents = nullptr;
+}
+
+template<int S, int N>
+void PrepareStep(BasicState<S, N>* state)
+{
     ///////////////////
     //    Flames     //
     ///////////////////
+    trace::EngineSpan flames(trace::ENGINE, "Flames");
     util::TickFlames(*state);
+    flames.End();
+
+    ///////////////////
+    //  Bomb Timers  //
+    ///////////////////
+    trace::EngineSpan timers(trace::ENGINE, "Bomb Timers");
+    util::ReduceBombTimers(*state);
+}
+
+template<int S, int N>
+void ResolveStep(BasicState<S, N>* state, Move* moves)
+{
+    typedef typename BasicState<S, N>::Format F;
 
     ///////////////////////
     //  Player Movement  //
     ///////////////////////
+    trace::EngineSpan movement(trace::ENGINE, "Player Movement");
 
-    Position oldPos[AGENT_COUNT];
-    Position destPos[AGENT_COUNT];
+    Position oldPos[N];
+    Position destPos[N];
 
     util::FillPositions(state, oldPos);
     util::FillDestPos(state, moves, destPos);
-    util::FixSwitchMove(state, destPos);
 
-    int dependency[AGENT_COUNT] = {-1, -1, -1, -1};
-    int roots[AGENT_COUNT] = {-1, -1, -1, -1};
+    int dependency[N];
+    int roots[N];
+    bool collision[N];
+    std::fill_n(dependency, N, -1);
+    std::fill_n(roots, N, -1);
 
-    // the amount of chain roots
-    const int rootNumber = util::ResolveDependencies(state, destPos, dependency, roots);
+    // fixes switches, the amount of chain roots
+    const int rootNumber = util::ResolveMovement(state, destPos, dependency, roots, collision);
     const bool ouroboros = rootNumber == 0; // ouroboros formation?
 
     int rootIdx = 0;
     int i = rootNumber == 0 ? 0 : roots[0]; // no roots -> start from 0
 
-    // iterates 4 times but the index i jumps around the dependencies
-    for(int _ = 0; _ < AGENT_COUNT; _++, i = dependency[i])
+    // iterates N times but the index i jumps around the dependencies
+    for(int _ = 0; _ < N; _++, i = dependency[i])
     {
         if(i == -1)
         {
             rootIdx++;
+            if(rootIdx >= rootNumber)
+            {
+                // the remaining agents are not reachable from any root
+                // (blocked cycles, overwritten dependencies), they stay
+                break;
+            }
             i = roots[rootIdx];
         }
         const Move m = moves[i];
@@ -51,20 +109,21 @@ void Step(State* state, Move* moves)
         }
         else if(m == Move::BOMB)
         {
-            state->PlantBombModifiedLife(state->agents[i].x, state->agents[i].y, i, BOMB_LIFETIME + 1);
+            // the timers have already been counted down for this step
+            const int bombCount = state->bombs.count;
+            state->PlantBomb(state->agents[i].x, state->agents[i].y, i);
+            if(state->bombs.count != bombCount)
+            {
+                util::RecordEvent(EventType::BOMB_PLANTED, i, state->agents[i].x, state->agents[i].y);
+            }
             continue;
         }
 
         int x = state->agents[i].x;
         int y = state->agents[i].y;
 
+        // destinations outside of the board are rigid (see BasicBoard)
         Position desired = destPos[i];
-
-        if(util::IsOutOfBounds(desired))
-        {
-            continue;
-        }
-
         int itemOnDestination = state->board[desired.y][desired.x];
 
         //if ouroboros, the bomb will be covered by an agent
@@ -72,8 +131,8 @@ void Step(State* state, Move* moves)
         {
             for(int j = 0; j < state->bombs.count; j++)
             {
-                if(BMB_POS_X(state->bombs[j]) == desired.x
-                        && BMB_POS_Y(state->bombs[j]) == desired.y)
+                if(F::PosX(state->bombs[j]) == desired.x
+                        && F::PosY(state->bombs[j]) == desired.y)
                 {
                     itemOnDestination = Item::BOMB;
                     break;
@@ -84,6 +143,8 @@ void Step(State* state, Move* moves)
         if(IS_FLAME(itemOnDestination))
         {
             state->Kill(i);
+            util::RecordEvent(EventType::AGENT_DIED, i, x, y,
+                              util::FlameOwner(*state, desired.x, desired.y));
             if(state->board[y][x] == Item::AGENT0 + i)
             {
                 if(state->HasBomb(x, y))
@@ -97,7 +158,7 @@ void Step(State* state, Move* moves)
             }
             continue;
         }
-        if(util::HasDPCollision(*state, destPos, i))
+        if(collision[i])
         {
             continue;
         }
@@ -111,6 +172,7 @@ void Step(State* state, Move* moves)
         if(IS_POWERUP(itemOnDestination))
         {
             util::ConsumePowerup(*state, i, itemOnDestination);
+            util::RecordEvent(EventType::POWERUP_COLLECTED, i, desired.x, desired.y, itemOnDestination);
             itemOnDestination = Item::PASSAGE;
         }
 
@@ -165,7 +227,8 @@ void Step(State* state, Move* moves)
             // start moving the kicked bomb by setting a velocity
             // the first 5 values of Move and Direction are semantically identical
             Bomb& b = *state->GetBomb(desired.x,  desired.y);
-            SetBombDirection(b, Direction(m));
+            F::SetDirection(b, Direction(m));
+            util::RecordEvent(EventType::BOMB_KICKED, i, desired.x, desired.y, int(m));
         }
         else if(itemOnDestination == Item::BOMB && !state->agents[i].canKick)
         {
@@ -184,103 +247,69 @@ void Step(State* state, Move* moves)
         }
     }
 
-    // Before moving bombs, reset their "moved" flags
-    util::ResetBombFlags(*state);
+    movement.End();
 
-    // Fill array of desired positions
-    Position bombDestinations[MAX_BOMBS];
-    util::FillBombDestPos(state, bombDestinations);
+    ///////////////////
+    // Bomb Movement //
+    ///////////////////
+    trace::EngineSpan bombMovement(trace::ENGINE, "Bomb Movement");
+    const StepKernel kernel = util::ClassifyBombPhase(*state, moves, oldPos);
+    stepKernelCounters.ticks[int(kernel)]++;
 
-    // Set bomb directions to idle if they collide with an agent or a static obstacle
-    for(int i = 0; i < state->bombs.count; i++)
+    if(kernel == StepKernel::NO_BOMBS)
     {
-        Bomb& b = state->bombs[i];
-        int bx = BMB_POS_X(b);
-        int by = BMB_POS_Y(b);
-
-        Position target = util::DesiredPosition(b);
-
-        if(util::IsOutOfBounds(target) ||
-                IS_STATIC_MOV_BLOCK((*state)[target]) ||
-                IS_AGENT((*state)[target]))
-        {
-            SetBombDirection(b, Direction::IDLE);
-            int indexAgent = state->GetAgent(bx, by);
-            if(indexAgent > -1
-                    && moves[indexAgent] != Move::IDLE
-                    && moves[indexAgent] != Move::BOMB
-                    // if the agents is where he came from he probably got bounced
-                    // back to the bomb he was already standing on.
-                    && !(state->agents[indexAgent].GetPos() == oldPos[indexAgent]))
-
-            {
-
-                util::AgentBombChainReversion(*state, moves, bombDestinations, indexAgent);
-                if(state->GetAgent(bx, by) == -1)
-                {
-                    state->board[by][bx] = Item::BOMB;
-                }
-
-            }
-        }
-
+        return;
     }
-
-    // Move bombs
-    for(int i = 0; i < state->bombs.count; i++)
+    else if(kernel == StepKernel::BOMBS_AT_REST)
     {
-        Bomb& b = state->bombs[i];
-
-        if(Move(BMB_DIR(b)) == Move::IDLE)
-        {
-            if(util::HasBombCollision(*state, b, i))
-            {
-                util::ResolveBombCollision(*state, moves, bombDestinations, i);
-                continue;
-            }
-        }
-
-        int bx = BMB_POS_X(b);
-        int by = BMB_POS_Y(b);
+        util::MoveBombsAtRest(*state);
+    }
+    else
+    {
+        util::MoveBombs(*state, moves, oldPos);
+    }
 
-        Position target = util::DesiredPosition(b);
-        int& tItem = (*state)[target];
+    bombMovement.End();
 
-        if(!util::IsOutOfBounds(target) && !IS_STATIC_MOV_BLOCK(tItem))
-        {
-            if(util::HasBombCollision(*state, b, i))
-            {
-                util::ResolveBombCollision(*state, moves, bombDestinations, i);
-                continue;
-            }
+    ///////////////
+    // Explosion //
+    ///////////////
+    trace::EngineSpan explosion(trace::ENGINE, "Explosion");
+    util::ExplodeBombs(*state);
+}
 
-            // MOVE BOMB
-            SetBombPosition(b, target.x, target.y);
+template<int S, int N>
+void StepBatch(const BasicState<S, N>& parent, const Move moves[][N], int count,
+               BasicState<S, N>* successors)
+{
+    if(count <= 0)
+    {
+        return;
+    }
 
-            if(!state->HasBomb(bx, by) && state->board[by][bx] == Item::BOMB)
-            {
-                state->board[by][bx] = Item::PASSAGE;
-            }
+    // the first successor holds the shared prefix until it's resolved last
+    successors[0] = parent;
+    PrepareStep(&successors[0]);
 
-            if(IS_WALKABLE(tItem))
-            {
-                tItem = Item::BOMB;
-            }
-            else if(IS_FLAME(tItem))
-            {
-                state->ExplodeBombAt(state->GetBombIndex(target.x, target.y));
-            }
-        }
-        else
+    Move m[N];
+    for(int k = count - 1; k >= 0; k--)
+    {
+        if(k > 0)
         {
-            SetBombDirection(b, Direction::IDLE);
+            successors[k] = successors[0];
         }
+        std::copy(moves[k], moves[k] + N, m);
+        ResolveStep(&successors[k], m);
     }
-
-    ///////////////
-    // Explosion //
-    ///////////////
-    util::TickBombs(*state);
 }
 
+#define INSTANTIATE_STEP(S, N)                                 \
+    template void Step(BasicState<S, N>*, Move*);              \
+    template void Step(BasicState<S, N>*, Move*, StepEvents*); \
+    template void PrepareStep(BasicState<S, N>*);              \
+    template void ResolveStep(BasicState<S, N>*, Move*);       \
+    template void StepBatch(const BasicState<S, N>&, const Move[][N], int, BasicState<S, N>*);
+
+BBOARD_FOR_EACH_SHAPE(INSTANTIATE_STEP)
+
 }
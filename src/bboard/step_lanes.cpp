@@ -0,0 +1,651 @@
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#include "bboard.hpp"
+#include "step_lanes.hpp"
+
+namespace bboard
+{
+
+template<int W>
+void StateLanes<W>::Load(int lane, const State& state)
+{
+    for(int y = 0; y < BOARD_SIZE; y++)
+    {
+        for(int x = 0; x < BOARD_SIZE; x++)
+        {
+            board[y][x][lane] = state.board[y][x];
+        }
+    }
+    for(int i = 0; i < AGENT_COUNT; i++)
+    {
+        const AgentInfo& a = state.agents[i];
+        agentX[i][lane] = a.x;
+        agentY[i][lane] = a.y;
+        bombCount[i][lane] = a.bombCount;
+        maxBombCount[i][lane] = a.maxBombCount;
+        bombStrength[i][lane] = a.bombStrength;
+        canKick[i][lane] = a.canKick;
+        dead[i][lane] = a.dead;
+    }
+    for(int k = 0; k < MAX_BOMBS; k++)
+    {
+        bombs[k][lane] = state.bombs.queue[k];
+
+        const Flame& f = state.flames.queue[k];
+        flameX[k][lane] = f.position.x;
+        flameY[k][lane] = f.position.y;
+        flameTime[k][lane] = f.timeLeft;
+        flameStrength[k][lane] = f.strength;
+        flameOwner[k][lane] = f.owner;
+    }
+    bombIndex[lane] = state.bombs.index;
+    bombQueueCount[lane] = state.bombs.count;
+    flameIndex[lane] = state.flames.index;
+    flameQueueCount[lane] = state.flames.count;
+
+    timeStep[lane] = state.timeStep;
+    aliveAgents[lane] = state.aliveAgents;
+}
+
+template<int W>
+void StateLanes<W>::Store(int lane, State& state) const
+{
+    for(int y = 0; y < BOARD_SIZE; y++)
+    {
+        for(int x = 0; x < BOARD_SIZE; x++)
+        {
+            state.board[y][x] = board[y][x][lane];
+        }
+    }
+    for(int i = 0; i < AGENT_COUNT; i++)
+    {
+        AgentInfo& a = state.agents[i];
+        a.x = agentX[i][lane];
+        a.y = agentY[i][lane];
+        a.bombCount = bombCount[i][lane];
+        a.maxBombCount = maxBombCount[i][lane];
+        a.bombStrength = bombStrength[i][lane];
+        a.canKick = canKick[i][lane];
+        a.dead = dead[i][lane];
+    }
+    for(int k = 0; k < MAX_BOMBS; k++)
+    {
+        state.bombs.queue[k] = bombs[k][lane];
+
+        Flame& f = state.flames.queue[k];
+        f.position.x = flameX[k][lane];
+        f.position.y = flameY[k][lane];
+        f.timeLeft = flameTime[k][lane];
+        f.strength = flameStrength[k][lane];
+        f.owner = flameOwner[k][lane];
+    }
+    state.bombs.index = bombIndex[lane];
+    state.bombs.count = bombQueueCount[lane];
+    state.flames.index = flameIndex[lane];
+    state.flames.count = flameQueueCount[lane];
+
+    state.timeStep = timeStep[lane];
+    state.aliveAgents = aliveAgents[lane];
+}
+
+namespace
+{
+
+/**
+ * The vector operations used by StepLanes. Comparisons return masks
+ * (-1 in every lane where the comparison holds, 0 otherwise).
+ *
+ * The generic version works on plain arrays (and is left to the
+ * auto-vectorizer), the specializations below use intrinsics.
+ */
+template<int W>
+struct Lanes
+{
+    struct V
+    {
+        int v[W];
+    };
+
+    static V Set1(int a)
+    {
+        V r;
+        for(int l = 0; l < W; l++) r.v[l] = a;
+        return r;
+    }
+    static V Load(const int* p)
+    {
+        V r;
+        for(int l = 0; l < W; l++) r.v[l] = p[l];
+        return r;
+    }
+    static void Store(int* p, V a)
+    {
+        for(int l = 0; l < W; l++) p[l] = a.v[l];
+    }
+    static V Add(V a, V b)
+    {
+        for(int l = 0; l < W; l++) a.v[l] += b.v[l];
+        return a;
+    }
+    static V Sub(V a, V b)
+    {
+        for(int l = 0; l < W; l++) a.v[l] -= b.v[l];
+        return a;
+    }
+    static V Mul(V a, V b)
+    {
+        for(int l = 0; l < W; l++) a.v[l] *= b.v[l];
+        return a;
+    }
+    static V And(V a, V b)
+    {
+        for(int l = 0; l < W; l++) a.v[l] &= b.v[l];
+        return a;
+    }
+    static V Or(V a, V b)
+    {
+        for(int l = 0; l < W; l++) a.v[l] |= b.v[l];
+        return a;
+    }
+    // ~a & b
+    static V AndNot(V a, V b)
+    {
+        for(int l = 0; l < W; l++) a.v[l] = ~a.v[l] & b.v[l];
+        return a;
+    }
+    template<int N>
+    static V ShiftRight(V a)
+    {
+        for(int l = 0; l < W; l++) a.v[l] >>= N;
+        return a;
+    }
+    static V Eq(V a, V b)
+    {
+        for(int l = 0; l < W; l++) a.v[l] = a.v[l] == b.v[l] ? -1 : 0;
+        return a;
+    }
+    static V Gt(V a, V b)
+    {
+        for(int l = 0; l < W; l++) a.v[l] = a.v[l] > b.v[l] ? -1 : 0;
+        return a;
+    }
+    // m ? a : b
+    static V Select(V m, V a, V b)
+    {
+        for(int l = 0; l < W; l++) a.v[l] = m.v[l] ? a.v[l] : b.v[l];
+        return a;
+    }
+    // base[idx]
+    static V Gather(const int* base, V idx)
+    {
+        for(int l = 0; l < W; l++) idx.v[l] = base[idx.v[l]];
+        return idx;
+    }
+    // base[idx] = a (where m)
+    static void Scatter(int* base, V idx, V a, V m)
+    {
+        for(int l = 0; l < W; l++)
+        {
+            if(m.v[l]) base[idx.v[l]] = a.v[l];
+        }
+    }
+    static uint32_t Bits(V m)
+    {
+        uint32_t r = 0;
+        for(int l = 0; l < W; l++) r |= uint32_t(m.v[l] != 0) << l;
+        return r;
+    }
+};
+
+#if defined(__AVX2__)
+template<>
+struct Lanes<8>
+{
+    typedef __m256i V;
+
+    static V Set1(int a)
+    {
+        return _mm256_set1_epi32(a);
+    }
+    static V Load(const int* p)
+    {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    }
+    static void Store(int* p, V a)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), a);
+    }
+    static V Add(V a, V b)
+    {
+        return _mm256_add_epi32(a, b);
+    }
+    static V Sub(V a, V b)
+    {
+        return _mm256_sub_epi32(a, b);
+    }
+    static V Mul(V a, V b)
+    {
+        return _mm256_mullo_epi32(a, b);
+    }
+    static V And(V a, V b)
+    {
+        return _mm256_and_si256(a, b);
+    }
+    static V Or(V a, V b)
+    {
+        return _mm256_or_si256(a, b);
+    }
+    static V AndNot(V a, V b)
+    {
+        return _mm256_andnot_si256(a, b);
+    }
+    template<int N>
+    static V ShiftRight(V a)
+    {
+        return _mm256_srai_epi32(a, N);
+    }
+    static V Eq(V a, V b)
+    {
+        return _mm256_cmpeq_epi32(a, b);
+    }
+    static V Gt(V a, V b)
+    {
+        return _mm256_cmpgt_epi32(a, b);
+    }
+    static V Select(V m, V a, V b)
+    {
+        return _mm256_blendv_epi8(b, a, m);
+    }
+    static V Gather(const int* base, V idx)
+    {
+        return _mm256_i32gather_epi32(base, idx, 4);
+    }
+    static void Scatter(int* base, V idx, V a, V m)
+    {
+        alignas(32) int i[8], v[8];
+        Store(i, idx);
+        Store(v, a);
+        for(uint32_t bits = Bits(m); bits != 0; bits &= bits - 1)
+        {
+            const int l = __builtin_ctz(bits);
+            base[i[l]] = v[l];
+        }
+    }
+    static uint32_t Bits(V m)
+    {
+        return uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(m)));
+    }
+};
+#endif
+
+#if defined(__AVX512F__)
+template<>
+struct Lanes<16>
+{
+    typedef __m512i V;
+
+    static V Set1(int a)
+    {
+        return _mm512_set1_epi32(a);
+    }
+    static V Load(const int* p)
+    {
+        return _mm512_loadu_si512(p);
+    }
+    static void Store(int* p, V a)
+    {
+        _mm512_storeu_si512(p, a);
+    }
+    static V Add(V a, V b)
+    {
+        return _mm512_add_epi32(a, b);
+    }
+    static V Sub(V a, V b)
+    {
+        return _mm512_sub_epi32(a, b);
+    }
+    static V Mul(V a, V b)
+    {
+        return _mm512_mullo_epi32(a, b);
+    }
+    static V And(V a, V b)
+    {
+        return _mm512_and_si512(a, b);
+    }
+    static V Or(V a, V b)
+    {
+        return _mm512_or_si512(a, b);
+    }
+    static V AndNot(V a, V b)
+    {
+        return _mm512_andnot_si512(a, b);
+    }
+    template<int N>
+    static V ShiftRight(V a)
+    {
+        return _mm512_srai_epi32(a, N);
+    }
+    static V Eq(V a, V b)
+    {
+        return _mm512_maskz_set1_epi32(_mm512_cmpeq_epi32_mask(a, b), -1);
+    }
+    static V Gt(V a, V b)
+    {
+        return _mm512_maskz_set1_epi32(_mm512_cmpgt_epi32_mask(a, b), -1);
+    }
+    static V Select(V m, V a, V b)
+    {
+        return _mm512_mask_blend_epi32(_mm512_test_epi32_mask(m, m), b, a);
+    }
+    static V Gather(const int* base, V idx)
+    {
+        return _mm512_i32gather_epi32(idx, base, 4);
+    }
+    static void Scatter(int* base, V idx, V a, V m)
+    {
+        _mm512_mask_i32scatter_epi32(base, _mm512_test_epi32_mask(m, m), idx, a, 4);
+    }
+    static uint32_t Bits(V m)
+    {
+        return uint32_t(_mm512_test_epi32_mask(m, m));
+    }
+};
+#endif
+
+}
+
+template<int W>
+int StepLanesKernel(StateLanes<W>& s, const Move moves[W][AGENT_COUNT])
+{
+    typedef Lanes<W> L;
+    typedef typename L::V V;
+
+    const V zero = L::Set1(0);
+    const V ones = L::Set1(-1);
+    const V width = L::Set1(W);
+    const V boardSize = L::Set1(BOARD_SIZE);
+    const V queueSize = L::Set1(MAX_BOMBS);
+
+    alignas(64) int laneIdx[W];
+    alignas(64) int m[AGENT_COUNT][W];
+    for(int l = 0; l < W; l++)
+    {
+        laneIdx[l] = l;
+        for(int i = 0; i < AGENT_COUNT; i++)
+        {
+            m[i][l] = int(moves[l][i]);
+        }
+    }
+    const V lane = L::Load(laneIdx);
+
+    int* board = &s.board[0][0][0];
+    int* bombs = &s.bombs[0][0];
+
+    // index of a board cell in the transposed board
+    auto cellIndex = [&](V x, V y)
+    {
+        return L::Add(L::Mul(L::Add(L::Mul(y, boardSize), x), width), lane);
+    };
+    // offset of a ring-buffer slot from the front of its queue
+    auto queueOffset = [&](int slot, V front)
+    {
+        V offset = L::Sub(L::Set1(slot), front);
+        return L::Add(offset, L::And(L::Gt(zero, offset), queueSize));
+    };
+    auto isFlame = [&](V item)
+    {
+        return L::Eq(L::template ShiftRight<16>(item), L::Set1(4));
+    };
+
+    ///////////////////////////////
+    // Find lanes with rare paths //
+    ///////////////////////////////
+
+    // lanes that are stepped by bboard::Step
+    V rare = zero;
+
+    // the front flame expires
+    const V flameFront = L::Load(s.flameIndex);
+    const V flameCount = L::Load(s.flameQueueCount);
+    const V frontFlameTime = L::Gather(&s.flameTime[0][0], L::Add(L::Mul(flameFront, width), lane));
+    rare = L::Or(rare, L::And(L::Gt(flameCount, zero), L::Gt(L::Set1(2), frontFlameTime)));
+
+    const V bombFront = L::Load(s.bombIndex);
+    const V bombCount = L::Load(s.bombQueueCount);
+
+    // only look at the bombs that are in the queue of any lane
+    int maxBombCount = 0;
+    for(int l = 0; l < W; l++)
+    {
+        maxBombCount = std::max(maxBombCount, s.bombQueueCount[l]);
+    }
+
+    V bombPos[MAX_BOMBS]; // -1 if the lane has less bombs
+    V bombCell[MAX_BOMBS];
+    V bombOnPassage[MAX_BOMBS];
+    for(int o = 0; o < maxBombCount; o++)
+    {
+        const V live = L::Gt(bombCount, L::Set1(o));
+        V slot = L::Add(bombFront, L::Set1(o));
+        slot = L::Sub(slot, L::And(L::Gt(slot, L::Set1(MAX_BOMBS - 1)), queueSize));
+        const V b = L::Gather(bombs, L::Select(live, L::Add(L::Mul(slot, width), lane), zero));
+
+        // moving bombs
+        rare = L::Or(rare, L::AndNot(L::Eq(L::And(b, L::Set1(0xF00000)), zero), live));
+
+        // the front bomb explodes
+        if(o == 0)
+        {
+            const V time = L::And(L::template ShiftRight<16>(b), L::Set1(0xF));
+            rare = L::Or(rare, L::And(live, L::Gt(L::Set1(2), time)));
+        }
+
+        const V x = L::And(b, L::Set1(0xF));
+        const V y = L::And(L::template ShiftRight<4>(b), L::Set1(0xF));
+        bombPos[o] = L::Select(live, L::And(b, L::Set1(0xFF)), ones);
+        bombCell[o] = L::Select(live, cellIndex(x, y), zero);
+
+        // bombs on flames explode, bombs on passages turn into bomb items
+        const V item = L::Gather(board, bombCell[o]);
+        rare = L::Or(rare, L::And(live, isFlame(item)));
+        bombOnPassage[o] = L::And(live, L::Eq(item, zero));
+    }
+
+    V pos[AGENT_COUNT];
+    V dest[AGENT_COUNT];
+    V alive[AGENT_COUNT];
+    V walks[AGENT_COUNT];
+    V from[AGENT_COUNT];
+    V to[AGENT_COUNT];
+    V toX[AGENT_COUNT];
+    V toY[AGENT_COUNT];
+    V moved[AGENT_COUNT];
+    V onBomb[AGENT_COUNT];
+    V plants[AGENT_COUNT];
+    V plantSlot[AGENT_COUNT];
+    V planted = zero;
+
+    for(int i = 0; i < AGENT_COUNT; i++)
+    {
+        const V mi = L::Load(m[i]);
+        const V x = L::Load(s.agentX[i]);
+        const V y = L::Load(s.agentY[i]);
+        alive[i] = L::Eq(L::Load(s.dead[i]), zero);
+        pos[i] = L::Add(x, L::Mul(y, L::Set1(16)));
+
+        const V up = L::Eq(mi, L::Set1(int(Move::UP)));
+        const V down = L::Eq(mi, L::Set1(int(Move::DOWN)));
+        const V left = L::Eq(mi, L::Set1(int(Move::LEFT)));
+        const V right = L::Eq(mi, L::Set1(int(Move::RIGHT)));
+        walks[i] = L::And(alive[i], L::Or(L::Or(up, down), L::Or(left, right)));
+
+        // masks are -1, so left - right is the x-offset
+        const V nx = L::Add(x, L::Sub(left, right));
+        const V ny = L::Add(y, L::Sub(up, down));
+        const V outOfBounds = L::Or(L::Or(L::Gt(zero, nx), L::Gt(nx, L::Set1(BOARD_SIZE - 1))),
+                                    L::Or(L::Gt(zero, ny), L::Gt(ny, L::Set1(BOARD_SIZE - 1))));
+        const V walksIn = L::AndNot(outOfBounds, walks[i]);
+
+        // out of bounds destinations never collide
+        dest[i] = L::Select(walks[i],
+                            L::Select(outOfBounds, L::Set1(-2 - i), L::Add(nx, L::Mul(ny, L::Set1(16)))),
+                            pos[i]);
+
+        // dead agents might not have a position on the board
+        from[i] = L::Select(alive[i], cellIndex(x, y), zero);
+        to[i] = L::Select(walksIn, cellIndex(nx, ny), from[i]);
+        toX[i] = nx;
+        toY[i] = ny;
+
+        // flames, power-ups and bombs on the destination
+        const V item = L::Gather(board, to[i]);
+        const V powerup = L::And(L::Gt(item, L::Set1(5)), L::Gt(L::Set1(9), item));
+        const V special = L::Or(L::Or(isFlame(item), powerup), L::Eq(item, L::Set1(Item::BOMB)));
+        rare = L::Or(rare, L::And(walksIn, special));
+        moved[i] = L::And(walksIn, L::Eq(item, zero));
+
+        onBomb[i] = zero;
+        for(int o = 0; o < maxBombCount; o++)
+        {
+            onBomb[i] = L::Or(onBomb[i], L::Eq(bombPos[o], pos[i]));
+            rare = L::Or(rare, L::And(walksIn, L::Eq(bombPos[o], dest[i])));
+        }
+
+        plants[i] = L::And(L::And(alive[i], L::Eq(mi, L::Set1(int(Move::BOMB)))),
+                           L::Gt(L::Load(s.maxBombCount[i]), L::Load(s.bombCount[i])));
+        const V count = L::Sub(bombCount, planted);
+        V slot = L::Add(bombFront, count);
+        slot = L::Sub(slot, L::And(L::Gt(slot, L::Set1(MAX_BOMBS - 1)), queueSize));
+        slot = L::Sub(slot, L::And(L::Gt(slot, L::Set1(MAX_BOMBS - 1)), queueSize));
+        plantSlot[i] = L::Add(L::Mul(slot, width), lane);
+
+        const V overflow = L::And(plants[i], L::Gt(count, L::Set1(MAX_BOMBS - 1)));
+        rare = L::Or(rare, overflow);
+        planted = L::Add(planted, plants[i]);
+    }
+
+    // agents that depend on each other (chains, swaps, conflicts)
+    for(int i = 0; i < AGENT_COUNT; i++)
+    {
+        for(int j = 0; j < AGENT_COUNT; j++)
+        {
+            if(i == j) continue;
+            const V conflict = L::And(alive[j], L::Or(L::Eq(dest[i], dest[j]), L::Eq(dest[i], pos[j])));
+            rare = L::Or(rare, L::And(walks[i], conflict));
+        }
+    }
+
+    const uint32_t all = (1u << W) - 1;
+    const uint32_t rareBits = L::Bits(rare);
+
+    ///////////////
+    // Fast path //
+    ///////////////
+    if(rareBits != all)
+    {
+        const V fast = L::AndNot(rare, ones);
+
+        // count down flames
+        for(int k = 0; k < MAX_BOMBS; k++)
+        {
+            const V live = L::And(fast, L::Gt(flameCount, queueOffset(k, flameFront)));
+            const V t = L::Load(s.flameTime[k]);
+            L::Store(s.flameTime[k], L::Select(live, L::Sub(t, L::Set1(1)), t));
+        }
+
+        // count down bombs and reset their moved flags
+        for(int k = 0; k < MAX_BOMBS; k++)
+        {
+            const V live = L::And(fast, L::Gt(bombCount, queueOffset(k, bombFront)));
+            const V b = L::Load(s.bombs[k]);
+            const V nb = L::And(L::Sub(b, L::Set1(1 << 16)), L::Set1(cmask24_28));
+            L::Store(s.bombs[k], L::Select(live, nb, b));
+        }
+        for(int o = 0; o < maxBombCount; o++)
+        {
+            L::Scatter(board, bombCell[o], L::Set1(Item::BOMB), L::And(fast, bombOnPassage[o]));
+        }
+
+        // move agents
+        for(int i = 0; i < AGENT_COUNT; i++)
+        {
+            const V move = L::And(fast, moved[i]);
+            const V agentItem = L::Set1(Item::AGENT0 + i);
+
+            const V old = L::Gather(board, from[i]);
+            const V left = L::Select(onBomb[i], L::Set1(Item::BOMB), L::Set1(Item::PASSAGE));
+            L::Scatter(board, from[i], left, L::And(move, L::Eq(old, agentItem)));
+            L::Scatter(board, to[i], agentItem, move);
+
+            L::Store(s.agentX[i], L::Select(move, toX[i], L::Load(s.agentX[i])));
+            L::Store(s.agentY[i], L::Select(move, toY[i], L::Load(s.agentY[i])));
+        }
+
+        // plant bombs (in agent order, like bboard::Step)
+        V count = bombCount;
+        for(int i = 0; i < AGENT_COUNT; i++)
+        {
+            const V plant = L::And(fast, plants[i]);
+            const V x = L::Load(s.agentX[i]);
+            const V y = L::Load(s.agentY[i]);
+
+            // a fresh bomb like State::PlantBomb (no direction, no flags)
+            const V b = L::Add(L::Add(L::Set1((i << 8) + (BOMB_LIFETIME << 16)), L::Add(x, L::Mul(y, L::Set1(16)))),
+                               L::Mul(L::Load(s.bombStrength[i]), L::Set1(1 << 12)));
+            L::Scatter(bombs, plantSlot[i], b, plant);
+
+            L::Store(s.bombCount[i], L::Sub(L::Load(s.bombCount[i]), plant));
+            count = L::Sub(count, plant);
+        }
+        L::Store(s.bombQueueCount, count);
+    }
+
+    /////////////////
+    // Rare lanes  //
+    /////////////////
+    State state;
+    for(uint32_t bits = rareBits; bits != 0; bits &= bits - 1)
+    {
+        const int l = __builtin_ctz(bits);
+        Move mv[AGENT_COUNT];
+        std::copy(moves[l], moves[l] + AGENT_COUNT, mv);
+
+        s.Store(l, state);
+        Step(&state, mv);
+        s.Load(l, state);
+    }
+
+    return __builtin_popcount(rareBits);
+}
+
+template<int W>
+int StepLanes(StateLanes<W>& s, const Move moves[W][AGENT_COUNT])
+{
+    if(LanesVectorized(W))
+    {
+        return StepLanesKernel(s, moves);
+    }
+
+    State state;
+    for(int l = 0; l < W; l++)
+    {
+        Move mv[AGENT_COUNT];
+        std::copy(moves[l], moves[l] + AGENT_COUNT, mv);
+
+        s.Store(l, state);
+        Step(&state, mv);
+        s.Load(l, state);
+    }
+    return W;
+}
+
+template struct StateLanes<8>;
+template struct StateLanes<16>;
+template int StepLanes<8>(StateLanes<8>&, const Move[8][AGENT_COUNT]);
+template int StepLanes<16>(StateLanes<16>&, const Move[16][AGENT_COUNT]);
+template int StepLanesKernel<8>(StateLanes<8>&, const Move[8][AGENT_COUNT]);
+template int StepLanesKernel<16>(StateLanes<16>&, const Move[16][AGENT_COUNT]);
+
+}
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <algorithm>
 
 #include "bboard.hpp"
 #include "step_utility.hpp"
@@ -54,33 +55,63 @@ Position OriginPosition(int x, int y, Move move)
     return p;
 }
 
-Position DesiredPosition(const Bomb b)
+template<int S, int N>
+int FlameOwner(const BasicState<S, N>& state, int x, int y)
 {
-    return DesiredPosition(BMB_POS_X(b), BMB_POS_Y(b), Move(BMB_DIR(b)));
+    // the flame items carry the origin of their flame
+    const int origin = FLAME_ID(state.board[y][x]);
+
+    // the newest flame is the one that has overwritten the cell
+    for(int i = state.flames.count - 1; i >= 0; i--)
+    {
+        const Flame& f = state.flames[i];
+        if(f.position.x + S * f.position.y == origin)
+        {
+            return f.owner;
+        }
+    }
+    return -1;
 }
 
-Position AgentBombChainReversion(State& state, Move moves[AGENT_COUNT],
-                                 Position destBombs[MAX_BOMBS], int agentID)
+template<int S, int N>
+Position AgentBombChainReversion(BasicState<S, N>& state, Move moves[N],
+                                 Position destBombs[], CellIndex<S, N>& cells, int agentID)
 {
-    AgentInfo& agent = state.agents[agentID];
-    Position origin = OriginPosition(agent.x, agent.y, moves[agentID]);
+    typedef typename BasicState<S, N>::Format F;
 
-    if(!IsOutOfBounds(origin))
+    if(!cells.filled)
     {
-        int indexOriginAgent = state.GetAgent(origin.x, origin.y);
+        cells.Fill(state, destBombs);
+    }
 
-        int bombDestIndex = -1;
-        for(int i = 0; i < state.bombs.count; i++)
+    // every hop of the chain bounces back one agent, so the chain
+    // is walked in a loop instead of recursively
+    while(true)
+    {
+        AgentInfo& agent = state.agents[agentID];
+        Position origin = OriginPosition(agent.x, agent.y, moves[agentID]);
+
+        if(IsOutOfBounds(origin, S))
         {
-            if(destBombs[i] == origin)
-            {
-                bombDestIndex = i;
-                break;
-            }
+            return {agent.x, agent.y};
+        }
+        // an agent that didn't move (idle or planting) ends the chain
+        if(origin == agent.GetPos())
+        {
+            state[origin] = Item::AGENT0 + agentID;
+            return origin;
         }
 
-        bool hasBomb  = bombDestIndex != -1;
+        int indexOriginAgent = cells.Agent(state, origin);
 
+        // exploded bombs may have shortened the queue since the index was filled
+        int bombDestIndex = cells.bombs[origin.x + S * origin.y];
+        if(bombDestIndex >= state.bombs.count)
+        {
+            bombDestIndex = -1;
+        }
+
+        cells.MoveAgent(agentID, agent.GetPos(), origin);
         agent.x = origin.x;
         agent.y = origin.y;
 
@@ -88,75 +119,79 @@ Position AgentBombChainReversion(State& state, Move moves[AGENT_COUNT],
 
         if(indexOriginAgent != -1)
         {
-            return AgentBombChainReversion(state, moves, destBombs, indexOriginAgent);
+            agentID = indexOriginAgent;
+            continue;
         }
-        // move bomb back and check for an agent that needs to be reverted
-        else if(hasBomb)
+        else if(bombDestIndex == -1)
         {
-            Bomb& b = state.bombs[bombDestIndex];
-            Position bombDest = destBombs[bombDestIndex];
+            return origin;
+        }
 
-            Position originBomb = OriginPosition(bombDest.x, bombDest.y, Move(BMB_DIR(b)));
+        // move bomb back and check for an agent that needs to be reverted
+        Bomb& b = state.bombs[bombDestIndex];
+        Position bombDest = destBombs[bombDestIndex];
 
-            // this is the case when an agent gets bounced back to a bomb he laid
-            if(originBomb == bombDest)
-            {
-                state[originBomb] = Item::AGENT0 + agentID;
-                return originBomb;
-            }
+        Position originBomb = OriginPosition(bombDest.x, bombDest.y, Move(F::Dir(b)));
 
-            int hasAgent = state.GetAgent(originBomb.x, originBomb.y);
-            SetBombDirection(b, Direction::IDLE);
-            SetBombPosition(b, originBomb.x, originBomb.y);
-            state[originBomb] = Item::BOMB;
+        // this is the case when an agent gets bounced back to a bomb he laid
+        if(originBomb == bombDest)
+        {
+            state[originBomb] = Item::AGENT0 + agentID;
+            return originBomb;
+        }
 
-            if(hasAgent != -1)
-            {
-                return AgentBombChainReversion(state, moves, destBombs, hasAgent);
-            }
-            else
-            {
-                return originBomb;
-            }
+        int hasAgent = cells.Agent(state, originBomb);
+        F::SetDirection(b, Direction::IDLE);
+        F::SetPosition(b, originBomb.x, originBomb.y);
+        state[originBomb] = Item::BOMB;
+
+        if(hasAgent == -1)
+        {
+            return originBomb;
         }
-        return origin;
-    }
-    else
-    {
-        return {agent.x, agent.y};
+        agentID = hasAgent;
     }
 }
 
-void FillPositions(State* s, Position p[AGENT_COUNT])
+template<int S, int N>
+void FillPositions(BasicState<S, N>* s, Position p[N])
 {
-    for(int i = 0; i < AGENT_COUNT; i++)
+    for(int i = 0; i < N; i++)
     {
         p[i] = {s->agents[i].x, s->agents[i].y};
     }
 }
 
-void FillDestPos(State* s, Move m[AGENT_COUNT], Position p[AGENT_COUNT])
+template<int S, int N>
+void FillDestPos(BasicState<S, N>* s, Move m[N], Position p[N])
 {
-    for(int i = 0; i < AGENT_COUNT; i++)
+    for(int i = 0; i < N; i++)
     {
         p[i] = DesiredPosition(s->agents[i].x, s->agents[i].y, m[i]);
     }
 }
 
-void FillBombDestPos(State* s, Position p[MAX_BOMBS])
+template<int S, int N>
+void FillBombDestPos(BasicState<S, N>* s, Position p[])
 {
     for(int i = 0; i < s->bombs.count; i++)
     {
-        p[i] = DesiredPosition(s->bombs[i]);
+        p[i] = DesiredPosition<typename BasicState<S, N>::Format>(s->bombs[i]);
     }
 }
 
-void FixSwitchMove(State* s, Position d[AGENT_COUNT])
+template<int S, int N>
+void FixSwitchMove(BasicState<S, N>* s, Position d[N])
 {
-    for(int i = 0; i < AGENT_COUNT; i++)
+    for(int i = 0; i < N; i++)
     {
-        for(int j = i; j < AGENT_COUNT; j++)
+        // dead agents are not on the board, nobody can switch with them
+        if(s->agents[i].dead) continue;
+
+        for(int j = i; j < N; j++)
         {
+            if(s->agents[j].dead) continue;
+
             if(d[i].x == s->agents[j].x && d[i].y == s->agents[j].y &&
                     d[j].x == s->agents[i].x && d[j].y == s->agents[i].y)
             {
@@ -169,11 +204,12 @@ void FixSwitchMove(State* s, Position d[AGENT_COUNT])
     }
 }
 
-int ResolveDependencies(State* s, Position des[AGENT_COUNT],
-                        int dependency[AGENT_COUNT], int chain[AGENT_COUNT])
+template<int S, int N>
+int ResolveDependencies(BasicState<S, N>* s, Position des[N],
+                        int dependency[N], int chain[N])
 {
     int rootCount = 0;
-    for(int i = 0; i < AGENT_COUNT; i++)
+    for(int i = 0; i < N; i++)
     {
         // dead agents are handled as roots
         if(s->agents[i].dead)
@@ -184,7 +220,7 @@ int ResolveDependencies(State* s, Position des[AGENT_COUNT],
         }
 
         bool isChainRoot = true;
-        for(int j = 0; j < AGENT_COUNT; j++)
+        for(int j = 0; j < N; j++)
         {
             if(i == j || s->agents[j].dead) continue;
 
@@ -204,8 +240,142 @@ int ResolveDependencies(State* s, Position des[AGENT_COUNT],
     return rootCount;
 }
 
+/**
+ * Open addressing hash table over the (padded) cells of a board. Per
+ * step at most 2N cells are inserted (positions and destinations),
+ * so the table stays at most half full.
+ *
+ * @brief The CellTable struct maps cells to the agents standing on
+ * them and to the amount of agents that want to move there
+ */
+template<int S, int N>
+struct CellTable
+{
+    static const int CAPACITY = N <= 4 ? 16 : N <= 8 ? 32 : 64;
+
+    int key[CAPACITY];
+    // the agent with the lowest index standing on the cell
+    int head[CAPACITY];
+    // alive agents whose destination is the cell
+    int incoming[CAPACITY];
+
+    CellTable()
+    {
+        std::fill_n(key, CAPACITY, -1);
+    }
+
+    /**
+     * @brief Slot Returns the slot of the given position, inserts
+     * the position if it's not in the table yet
+     */
+    int Slot(const Position& p)
+    {
+        // destinations can lie on the border
+        const int cell = (p.y + 1) * (S + 2) + p.x + 1;
+        int k = int((uint32_t(cell) * 0x9E3779B1u) >> 16) & (CAPACITY - 1);
+        while(key[k] != cell)
+        {
+            if(key[k] == -1)
+            {
+                key[k] = cell;
+                head[k] = -1;
+                incoming[k] = 0;
+                break;
+            }
+            k = (k + 1) & (CAPACITY - 1);
+        }
+        return k;
+    }
+};
+
+template<int S, int N>
+int ResolveMovement(BasicState<S, N>* s, Position des[N], int dependency[N],
+                    int chain[N], bool collision[N], bool cellTable)
+{
+    static_assert(2 * N <= CellTable<S, N>::CAPACITY / 2, "Cell table too small");
+
+    if(!cellTable)
+    {
+        FixSwitchMove(s, des);
+        for(int i = 0; i < N; i++)
+        {
+            collision[i] = !s->agents[i].dead && HasDPCollision(*s, des, i);
+        }
+        return ResolveDependencies(s, des, dependency, chain);
+    }
+
+    CellTable<S, N> table;
+    Position pos[N];
+    int slot[N];
+    // agents standing on the same cell, in ascending order
+    int next[N];
+
+    FillPositions(s, pos);
+    for(int i = N - 1; i >= 0; i--)
+    {
+        slot[i] = table.Slot(pos[i]);
+        next[i] = table.head[slot[i]];
+        table.head[slot[i]] = i;
+    }
+
+    // switches (same order as FixSwitchMove, alive agents only)
+    for(int i = 0; i < N; i++)
+    {
+        if(s->agents[i].dead) continue;
+
+        for(int j = table.head[table.Slot(des[i])]; j != -1; j = next[j])
+        {
+            if(j >= i && !s->agents[j].dead && des[j] == pos[i])
+            {
+                des[i] = pos[i];
+                des[j] = pos[j];
+                break;
+            }
+        }
+    }
+
+    // dependencies (same order as ResolveDependencies)
+    int rootCount = 0;
+    for(int i = 0; i < N; i++)
+    {
+        if(s->agents[i].dead)
+        {
+            chain[rootCount] = i;
+            rootCount++;
+            continue;
+        }
+
+        const int k = table.Slot(des[i]);
+        table.incoming[k]++;
+        slot[i] = k;
+
+        int j = table.head[k];
+        while(j != -1 && (j == i || s->agents[j].dead))
+        {
+            j = next[j];
+        }
+        if(j != -1)
+        {
+            dependency[j] = i;
+        }
+        else
+        {
+            chain[rootCount] = i;
+            rootCount++;
+        }
+    }
+
+    // destination collisions with other alive agents
+    for(int i = 0; i < N; i++)
+    {
+        collision[i] = !s->agents[i].dead && table.incoming[slot[i]] > 1;
+    }
+    return rootCount;
+}
+
 
-void TickFlames(State& state)
+template<int S, int N>
+void TickFlames(BasicState<S, N>& state)
 {
     for(int i = 0; i < state.flames.count; i++)
     {
@@ -221,18 +391,30 @@ void TickFlames(State& state)
     }
 }
 
-void TickBombs(State& state)
+template<int S, int N>
+void TickBombs(BasicState<S, N>& state)
+{
+    ReduceBombTimers(state);
+    ExplodeBombs(state);
+}
+
+template<int S, int N>
+void ReduceBombTimers(BasicState<S, N>& state)
 {
     for(int i = 0; i < state.bombs.count; i++)
     {
-        ReduceBombTimer(state.bombs[i]);
+        BasicState<S, N>::Format::ReduceTimer(state.bombs[i]);
     }
+}
 
+template<int S, int N>
+void ExplodeBombs(BasicState<S, N>& state)
+{
     //explode timed-out bombs
     int bombCount = state.bombs.count;
     for(int i = 0; i < bombCount && state.bombs.count > 0; i++)
     {
-        if(BMB_TIME(state.bombs[0]) == 0)
+        if(BasicState<S, N>::Format::Time(state.bombs[0]) == 0)
         {
             state.ExplodeTopBomb();
         }
@@ -244,7 +426,215 @@ void TickBombs(State& state)
     }
 }
 
-void ConsumePowerup(State& state, int agentID, int powerUp)
+template<int S, int N>
+void MoveBombs(BasicState<S, N>& state, Move moves[N], Position oldPos[N])
+{
+    typedef typename BasicState<S, N>::Format F;
+
+    // Before moving bombs, reset their "moved" flags
+    ResetBombFlags(state);
+
+    // Fill array of desired positions
+    Position bombDestinations[BasicState<S, N>::MAX_BOMBS];
+    FillBombDestPos(&state, bombDestinations);
+    CellIndex<S, N> cells;
+
+    // Set bomb directions to idle if they collide with an agent or a static obstacle
+    for(int i = 0; i < state.bombs.count; i++)
+    {
+        Bomb& b = state.bombs[i];
+        int bx = F::PosX(b);
+        int by = F::PosY(b);
+
+        Position target = DesiredPosition<F>(b);
+
+        if(IS_STATIC_MOV_BLOCK(state[target]) ||
+                IS_AGENT(state[target]))
+        {
+            F::SetDirection(b, Direction::IDLE);
+            int indexAgent = state.GetAgent(bx, by);
+            if(indexAgent > -1
+                    && moves[indexAgent] != Move::IDLE
+                    && moves[indexAgent] != Move::BOMB
+                    // if the agents is where he came from he probably got bounced
+                    // back to the bomb he was already standing on.
+                    && !(state.agents[indexAgent].GetPos() == oldPos[indexAgent]))
+
+            {
+
+                AgentBombChainReversion(state, moves, bombDestinations, cells, indexAgent);
+                if(state.GetAgent(bx, by) == -1)
+                {
+                    state.board[by][bx] = Item::BOMB;
+                }
+
+            }
+        }
+
+    }
+
+    // Count the bombs that start or end their move on each cell (the
+    // border ring included). Until a bomb is moved below, its position
+    // and target stay on its two counted cells, so two bombs can only
+    // collide on a cell that is counted at least twice.
+    const int W = S + 2;
+    uint8_t cellCount[W * W] = {};
+    for(int i = 0; i < state.bombs.count; i++)
+    {
+        const Bomb b = state.bombs[i];
+        Position target = DesiredPosition<F>(b);
+        cellCount[(F::PosY(b) + 1) * W + F::PosX(b) + 1]++;
+        if(Move(F::Dir(b)) != Move::IDLE)
+        {
+            cellCount[(target.y + 1) * W + target.x + 1]++;
+        }
+    }
+
+    // Move bombs
+    for(int i = 0; i < state.bombs.count; i++)
+    {
+        Bomb& b = state.bombs[i];
+
+        int bx = F::PosX(b);
+        int by = F::PosY(b);
+
+        Position target = DesiredPosition<F>(b);
+        int& tItem = state[target];
+        bool mayCollide = cellCount[(target.y + 1) * W + target.x + 1] > 1;
+
+        if(Move(F::Dir(b)) == Move::IDLE)
+        {
+            if(mayCollide && HasBombCollision(state, b, i))
+            {
+                ResolveBombCollision(state, moves, bombDestinations, cells, i);
+                continue;
+            }
+            // a lying bomb that nothing runs into stays as it is
+            if(!IS_WALKABLE(tItem) && !IS_FLAME(tItem))
+            {
+                continue;
+            }
+        }
+
+        if(!IS_STATIC_MOV_BLOCK(tItem))
+        {
+            if(mayCollide && HasBombCollision(state, b, i))
+            {
+                ResolveBombCollision(state, moves, bombDestinations, cells, i);
+                continue;
+            }
+
+            // MOVE BOMB
+            F::SetPosition(b, target.x, target.y);
+
+            if(!state.HasBomb(bx, by) && state.board[by][bx] == Item::BOMB)
+            {
+                state.board[by][bx] = Item::PASSAGE;
+            }
+
+            if(IS_WALKABLE(tItem))
+            {
+                tItem = Item::BOMB;
+            }
+            else if(IS_FLAME(tItem))
+            {
+                state.ExplodeBombAt(state.GetBombIndex(target.x, target.y));
+            }
+        }
+        else
+        {
+            F::SetDirection(b, Direction::IDLE);
+        }
+    }
+}
+
+template<int S, int N>
+StepKernel ClassifyBombPhase(const BasicState<S, N>& state, Move moves[N], Position oldPos[N])
+{
+    typedef typename BasicState<S, N>::Format F;
+
+    if(state.bombs.count == 0)
+    {
+        return StepKernel::NO_BOMBS;
+    }
+
+    for(int i = 0; i < state.bombs.count; i++)
+    {
+        const Bomb b = state.bombs[i];
+        if(Direction(F::Dir(b)) != Direction::IDLE)
+        {
+            return StepKernel::BOMBS_IN_MOTION;
+        }
+
+        // MoveBombs bounces back agents that walked onto a bomb this tick
+        int bx = F::PosX(b);
+        int by = F::PosY(b);
+        int item = state.board[by][bx];
+        if(!IS_AGENT(item) && !IS_STATIC_MOV_BLOCK(item))
+        {
+            continue;
+        }
+        for(int j = 0; j < N; j++)
+        {
+            const AgentInfo& a = state.agents[j];
+            if(!a.dead && a.x == bx && a.y == by
+                    && moves[j] != Move::IDLE && moves[j] != Move::BOMB
+                    && !(oldPos[j] == Position{bx, by}))
+            {
+                return StepKernel::BOMBS_IN_MOTION;
+            }
+        }
+    }
+    return StepKernel::BOMBS_AT_REST;
+}
+
+template<int S, int N>
+void MoveBombsAtRest(BasicState<S, N>& state)
+{
+    typedef typename BasicState<S, N>::Format F;
+
+    ResetBombFlags(state);
+
+    // the same queue walk as MoveBombs, every bomb is its own target
+    for(int i = 0; i < state.bombs.count; i++)
+    {
+        const Bomb b = state.bombs[i];
+        int bx = F::PosX(b);
+        int by = F::PosY(b);
+        int& item = state.board[by][bx];
+
+        if(!IS_WALKABLE(item) && !IS_FLAME(item))
+        {
+            continue;
+        }
+        if(HasBombCollision(state, b, i))
+        {
+            continue;
+        }
+
+        if(IS_WALKABLE(item))
+        {
+            item = Item::BOMB;
+        }
+        else
+        {
+            state.ExplodeBombAt(state.GetBombIndex(bx, by));
+        }
+    }
+}
+
+template<int S, int N>
+void MoveBombsForward(BasicState<S, N>& state)
+{
+    Move idle[N] = {};
+    Position positions[N];
+    FillPositions(&state, positions);
+
+    MoveBombs(state, idle, positions);
+}
+
+template<int S, int N>
+void ConsumePowerup(BasicState<S, N>& state, int agentID, int powerUp)
 {
     if(powerUp == Item::EXTRABOMB)
     {
@@ -261,9 +651,10 @@ void ConsumePowerup(State& state, int agentID, int powerUp)
 
 }
 
-bool HasDPCollision(const State& state, Position dp[AGENT_COUNT], int agentID)
+template<int S, int N>
+bool HasDPCollision(const BasicState<S, N>& state, Position dp[N], int agentID)
 {
-    for(int i = 0; i < AGENT_COUNT; i++)
+    for(int i = 0; i < N; i++)
     {
         if(agentID == i || state.agents[i].dead) continue;
         if(dp[agentID] == dp[i])
@@ -276,13 +667,16 @@ bool HasDPCollision(const State& state, Position dp[AGENT_COUNT], int agentID)
     return false;
 }
 
-bool HasBombCollision(const State& state, const Bomb& b, int index)
+template<int S, int N>
+bool HasBombCollision(const BasicState<S, N>& state, const Bomb& b, int index)
 {
-    Position bmbTarget = util::DesiredPosition(b);
+    typedef typename BasicState<S, N>::Format F;
+
+    Position bmbTarget = util::DesiredPosition<F>(b);
 
     for(int i = index; i < state.bombs.count; i++)
     {
-        Position target = util::DesiredPosition(state.bombs[i]);
+        Position target = util::DesiredPosition<F>(state.bombs[i]);
 
         if(b != state.bombs[i] && target == bmbTarget)
         {
@@ -292,35 +686,38 @@ bool HasBombCollision(const State& state, const Bomb& b, int index)
     return false;
 }
 
-void ResolveBombCollision(State& state, Move moves[AGENT_COUNT],
-                          Position destBombs[MAX_BOMBS], int index)
+template<int S, int N>
+void ResolveBombCollision(BasicState<S, N>& state, Move moves[N],
+                          Position destBombs[], CellIndex<S, N>& cells, int index)
 {
+    typedef typename BasicState<S, N>::Format F;
+
     Bomb& b = state.bombs[index];
     Bomb collidees[4]; //more than 4 bombs cannot collide
-    Position bmbTarget = util::DesiredPosition(b);
+    Position bmbTarget = util::DesiredPosition<F>(b);
     bool hasCollided = false;
 
     for(int i = index; i < state.bombs.count; i++)
     {
-        Position target = util::DesiredPosition(state.bombs[i]);
+        Position target = util::DesiredPosition<F>(state.bombs[i]);
 
         if(b != state.bombs[i] && target == bmbTarget)
         {
-            SetBombDirection(state.bombs[i], Direction::IDLE);
+            F::SetDirection(state.bombs[i], Direction::IDLE);
             hasCollided = true;
         }
     }
     if(hasCollided)
     {
-        if(Direction(BMB_DIR(b)) != Direction::IDLE)
+        if(Direction(F::Dir(b)) != Direction::IDLE)
         {
-            SetBombDirection(b, Direction::IDLE);
-            int index = state.GetAgent(BMB_POS_X(b), BMB_POS_Y(b));
+            F::SetDirection(b, Direction::IDLE);
+            int index = state.GetAgent(F::PosX(b), F::PosY(b));
             // move != idle means the agent moved on it this turn
             if(index > -1 && moves[index] != Move::IDLE && moves[index] != Move::BOMB)
             {
-                Position origin = AgentBombChainReversion(state, moves, destBombs, index);
-                state.board[BMB_POS_Y(b)][BMB_POS_X(b)] = Item::BOMB;
+                Position origin = AgentBombChainReversion(state, moves, destBombs, cells, index);
+                state.board[F::PosY(b)][F::PosX(b)] = Item::BOMB;
             }
 
         }
@@ -328,11 +725,12 @@ void ResolveBombCollision(State& state, Move moves[AGENT_COUNT],
 
 }
 
-void ResetBombFlags(State& state)
+template<int S, int N>
+void ResetBombFlags(BasicState<S, N>& state)
 {
     for(int i = 0; i < state.bombs.count; i++)
     {
-        SetBombMovedFlag(state.bombs[i], false);
+        BasicState<S, N>::Format::SetMovedFlag(state.bombs[i], false);
     }
 }
 
@@ -371,4 +769,31 @@ void PrintDependencyChain(int dependency[AGENT_COUNT], int chain[AGENT_COUNT])
 }
 
 
+#define INSTANTIATE_STEP_UTILITY(S, N)                                                       \
+    template int FlameOwner(const BasicState<S, N>&, int, int);                              \
+    template Position AgentBombChainReversion(BasicState<S, N>&, Move[], Position[],         \
+                                              CellIndex<S, N>&, int);                        \
+    template void FillPositions(BasicState<S, N>*, Position[]);                              \
+    template void FillDestPos(BasicState<S, N>*, Move[], Position[]);                        \
+    template void FillBombDestPos(BasicState<S, N>*, Position[]);                            \
+    template void FixSwitchMove(BasicState<S, N>*, Position[]);                              \
+    template int ResolveDependencies(BasicState<S, N>*, Position[], int[], int[]);           \
+    template int ResolveMovement(BasicState<S, N>*, Position[], int[], int[], bool[], bool); \
+    template void TickFlames(BasicState<S, N>&);                                             \
+    template void TickBombs(BasicState<S, N>&);                                              \
+    template void ReduceBombTimers(BasicState<S, N>&);                                       \
+    template void ExplodeBombs(BasicState<S, N>&);                                           \
+    template void MoveBombs(BasicState<S, N>&, Move[], Position[]);                          \
+    template StepKernel ClassifyBombPhase(const BasicState<S, N>&, Move[], Position[]);      \
+    template void MoveBombsAtRest(BasicState<S, N>&);                                        \
+    template void MoveBombsForward(BasicState<S, N>&);                                       \
+    template void ConsumePowerup(BasicState<S, N>&, int, int);                               \
+    template bool HasDPCollision(const BasicState<S, N>&, Position[], int);                  \
+    template bool HasBombCollision(const BasicState<S, N>&, const Bomb&, int);               \
+    template void ResolveBombCollision(BasicState<S, N>&, Move[], Position[],                \
+                                       CellIndex<S, N>&, int);                               \
+    template void ResetBombFlags(BasicState<S, N>&);
+
+BBOARD_FOR_EACH_SHAPE(INSTANTIATE_STEP_UTILITY)
+
 }
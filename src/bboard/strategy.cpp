@@ -92,6 +92,148 @@ void FillRMap(const State& s, RMap& r, int agentID)
     r.info = result;
 }
 
+//////////////////////////
+// Danger Map Functions //
+//////////////////////////
+
+inline void _MinDanger(int& current, int time)
+{
+    if(time < current)
+    {
+        current = time;
+    }
+}
+
+void FillDangerMap(const State& s, DangerMap& d)
+{
+    const int none = std::numeric_limits<int>::max();
+    std::fill(d.map[0], d.map[0] + BOARD_SIZE * BOARD_SIZE, none);
+
+    for(int i = 0; i < s.bombs.count; i++)
+    {
+        const Bomb& b = s.bombs[i];
+        const int x = BMB_POS_X(b);
+        const int y = BMB_POS_Y(b);
+        const int strength = BMB_STRENGTH(b);
+        const int time = BMB_TIME(b);
+
+        // same range as IsInBombRange (obstacles are ignored)
+        for(int k = std::max(0, x - strength); k <= std::min(BOARD_SIZE - 1, x + strength); k++)
+        {
+            _MinDanger(d.map[y][k], time);
+        }
+        for(int k = std::max(0, y - strength); k <= std::min(BOARD_SIZE - 1, y + strength); k++)
+        {
+            _MinDanger(d.map[k][x], time);
+        }
+    }
+
+    for(int y = 0; y < BOARD_SIZE; y++)
+    {
+        for(int x = 0; x < BOARD_SIZE; x++)
+        {
+            if(d.map[y][x] == none)
+            {
+                d.map[y][x] = 0;
+            }
+        }
+    }
+}
+
+/////////////////////////
+// Move Mask Functions //
+/////////////////////////
+
+void LegalMoves(const State& state, MoveMask legal[AGENT_COUNT])
+{
+    for(int i = 0; i < AGENT_COUNT; i++)
+    {
+        const AgentInfo& a = state.agents[i];
+        legal[i] = MoveBit(Move::IDLE);
+
+        if(a.dead)
+        {
+            continue;
+        }
+
+        for(Move m : {Move::UP, Move::DOWN, Move::LEFT, Move::RIGHT})
+        {
+            Position p = util::DesiredPosition(a.x, a.y, m);
+            int item = state.board[p.y][p.x];
+            if(item != Item::RIGID && !IS_WOOD(item))
+            {
+                legal[i] |= MoveBit(m);
+            }
+        }
+
+        if(a.bombCount < a.maxBombCount)
+        {
+            legal[i] |= MoveBit(Move::BOMB);
+        }
+    }
+}
+
+Move RandomLegalMove(MoveMask legal, std::mt19937_64& rng)
+{
+    if(legal == 0)
+    {
+        return Move::IDLE;
+    }
+    int k = std::uniform_int_distribution<int>(0, __builtin_popcount(legal) - 1)(rng);
+    for(int m = 0; m < ACTION_COUNT; m++)
+    {
+        if(HasMove(legal, Move(m)) && k-- == 0)
+        {
+            return Move(m);
+        }
+    }
+    return Move::IDLE;
+}
+
+bool TerminalValue(const State& state, int id, float& value)
+{
+    int alive = 0;
+    for(int i = 0; i < AGENT_COUNT; i++)
+    {
+        alive += i != id && !state.agents[i].dead;
+    }
+    if(state.agents[id].dead)
+    {
+        value = alive == 0 ? 0.0f : -1.0f;
+        return true;
+    }
+    if(alive == 0)
+    {
+        value = 1.0f;
+        return true;
+    }
+    return false;
+}
+
+void NonFatalMoves(const State& state, const Timeline& timeline,
+                   const MoveMask legal[AGENT_COUNT], MoveMask nonFatal[AGENT_COUNT])
+{
+    for(int i = 0; i < AGENT_COUNT; i++)
+    {
+        const AgentInfo& a = state.agents[i];
+        nonFatal[i] = 0;
+
+        for(int m = 0; m < 6; m++)
+        {
+            if(!HasMove(legal[i], Move(m)))
+            {
+                continue;
+            }
+
+            Position p = util::DesiredPosition(a.x, a.y, Move(m));
+            if(a.dead || !timeline.IsFlame(1, p.x, p.y))
+            {
+                nonFatal[i] |= MoveBit(Move(m));
+            }
+        }
+    }
+}
+
 ///////////////////////
 // General Functions //
 ///////////////////////
@@ -119,7 +261,12 @@ Move MoveTowardsPosition(const RMap& r, const Position& position)
     }
 }
 
-Move MoveTowardsSafePlace(const State& state, const RMap& r, int radius)
+/**
+ * @brief MoveTowardsSafePlaceBy The body of both MoveTowardsSafePlace
+ * overloads, danger(x, y) returns the danger value of a position
+ */
+template <typename Danger>
+inline Move MoveTowardsSafePlaceBy(const Danger& danger, const RMap& r, int radius)
 {
     int originX = r.source.x;
     int originY = r.source.y;
@@ -130,7 +277,7 @@ Move MoveTowardsSafePlace(const State& state, const RMap& r, int radius)
             if(util::IsOutOfBounds({x, y}) ||
                     std::abs(x - originX) + std::abs(y - originY) > radius) continue;
 
-            if(r.GetDistance(x, y) != 0 && _safe_condition(IsInDanger(state, x, y)))
+            if(r.GetDistance(x, y) != 0 && _safe_condition(danger(x, y)))
             {
                 return MoveTowardsPosition(r, {x, y});
             }
@@ -139,6 +286,16 @@ Move MoveTowardsSafePlace(const State& state, const RMap& r, int radius)
     return Move::IDLE;
 }
 
+Move MoveTowardsSafePlace(const State& state, const RMap& r, int radius)
+{
+    return MoveTowardsSafePlaceBy([&state](int x, int y) { return IsInDanger(state, x, y); }, r, radius);
+}
+
+Move MoveTowardsSafePlace(const DangerMap& d, const RMap& r, int radius)
+{
+    return MoveTowardsSafePlaceBy([&d](int x, int y) { return d.Get(x, y); }, r, radius);
+}
+
 Move MoveTowardsPowerup(const State& state, const RMap& r, int radius)
 {
     const Position& a = r.source;
@@ -186,40 +343,49 @@ Move MoveTowardsEnemy(const State& state, const RMap& r, int radius)
 
 bool _CheckPos(const State& state, int x, int y)
 {
-    return !util::IsOutOfBounds(x, y) && IS_WALKABLE(state.board[y][x]);
+    return IS_WALKABLE(state.board[y][x]);
 }
 
 bool _safe_condition(int danger, int min)
 {
     return danger == 0 || danger >= min;
 }
-void SafeDirections(const State& state, FixedQueue<Move, MOVE_COUNT>& q, int x, int y)
+/**
+ * @brief SafeDirectionsBy The body of both SafeDirections overloads
+ */
+template <typename Danger>
+inline void SafeDirectionsBy(const State& state, const Danger& danger,
+                             FixedQueue<Move, MOVE_COUNT>& q, int x, int y)
 {
-    int d = IsInDanger(state, x + 1, y);
-    if(_CheckPos(state, x + 1, y) && _safe_condition(d))
+    if(_CheckPos(state, x + 1, y) && _safe_condition(danger(x + 1, y)))
     {
         q.AddElem(Move::RIGHT);
     }
-
-    d = IsInDanger(state, x - 1, y);
-    if(_CheckPos(state, x - 1, y) && _safe_condition(d))
+    if(_CheckPos(state, x - 1, y) && _safe_condition(danger(x - 1, y)))
     {
         q.AddElem(Move::LEFT);
     }
-
-    d = IsInDanger(state, x, y + 1);
-    if(_CheckPos(state, x, y + 1) && _safe_condition(d))
+    if(_CheckPos(state, x, y + 1) && _safe_condition(danger(x, y + 1)))
     {
         q.AddElem(Move::DOWN);
     }
-
-    d = IsInDanger(state, x, y - 1);
-    if(_CheckPos(state, x, y - 1) && _safe_condition(d))
+    if(_CheckPos(state, x, y - 1) && _safe_condition(danger(x, y - 1)))
     {
         q.AddElem(Move::UP);
     }
 }
 
+void SafeDirections(const State& state, FixedQueue<Move, MOVE_COUNT>& q, int x, int y)
+{
+    SafeDirectionsBy(state, [&state](int px, int py) { return IsInDanger(state, px, py); }, q, x, y);
+}
+
+void SafeDirections(const State& state, const DangerMap& d,
+                    FixedQueue<Move, MOVE_COUNT>& q, int x, int y)
+{
+    SafeDirectionsBy(state, [&d](int px, int py) { return d.Get(px, py); }, q, x, y);
+}
+
 int IsInDanger(const State& state, int agentID)
 {
     const AgentInfo& a = state.agents[agentID];
@@ -0,0 +1,190 @@
+#include <climits>
+#include <algorithm>
+
+#include "bboard.hpp"
+#include "symmetry.hpp"
+
+namespace bboard
+{
+
+namespace
+{
+
+/**
+ * @brief The permutations of the cells of an S x S board
+ */
+template<int S>
+struct SymmetryTables
+{
+    static const int PADDED = S + 2;
+
+    /**
+     * @brief source The (padded) board offset that the cell
+     * x + S * y of the transformed board is read from
+     */
+    int source[SYMMETRY_COUNT][S * S];
+
+    /**
+     * @brief target The cell (x + S * y) that a cell moves to
+     */
+    int target[SYMMETRY_COUNT][S * S];
+
+    SymmetryTables()
+    {
+        for(int t = 0; t < SYMMETRY_COUNT; t++)
+        {
+            for(int y = 0; y < S; y++)
+            {
+                for(int x = 0; x < S; x++)
+                {
+                    const Position p = TransformPosition<S>(t, {x, y});
+                    target[t][x + S * y] = p.x + S * p.y;
+                    source[t][p.x + S * p.y] = (y + 1) * PADDED + x + 1;
+                }
+            }
+        }
+    }
+
+    static const SymmetryTables& Get()
+    {
+        static const SymmetryTables tables;
+        return tables;
+    }
+};
+
+/**
+ * @brief TransformedCell The item of the cell k of the transformed
+ * board. Flames refer to the cell of their bomb, which moves as well.
+ */
+template<int S>
+inline int TransformedCell(const SymmetryTables<S>& tables, const int* cells, int t, int k)
+{
+    const int item = cells[tables.source[t][k]];
+    const int origin = std::min(FLAME_ID(item), S * S - 1);
+    const int moved = (item & ~0xFFF8) | tables.target[t][origin] << 3;
+    return IS_FLAME(item) ? moved : item;
+}
+
+}
+
+template<int S, int N>
+void TransformState(const BasicState<S, N>& state, BasicState<S, N>& out, int t)
+{
+    typedef typename BasicState<S, N>::Format Format;
+    const SymmetryTables<S>& tables = SymmetryTables<S>::Get();
+    const int* in = &state.board.cells[0][0];
+    int* cells = &out.board.cells[0][0];
+
+    for(int y = 0; y < S; y++)
+    {
+        for(int x = 0; x < S; x++)
+        {
+            cells[(y + 1) * (S + 2) + x + 1] = TransformedCell(tables, in, t, x + S * y);
+        }
+    }
+
+    out.timeStep = state.timeStep;
+    out.aliveAgents = state.aliveAgents;
+    for(int i = 0; i < N; i++)
+    {
+        out.agents[i] = state.agents[i];
+        const Position p = TransformPosition<S>(t, {state.agents[i].x, state.agents[i].y});
+        out.agents[i].x = p.x;
+        out.agents[i].y = p.y;
+    }
+
+    out.bombs = state.bombs;
+    for(int i = 0; i < out.bombs.count; i++)
+    {
+        Bomb& b = out.bombs[i];
+        const Position p = TransformPosition<S>(t, {Format::PosX(b), Format::PosY(b)});
+        Format::SetPosition(b, p.x, p.y);
+        Format::SetDirection(b, Direction(TransformMove(t, Move(Format::Dir(b)))));
+    }
+
+    out.flames = state.flames;
+    for(int i = 0; i < out.flames.count; i++)
+    {
+        Flame& f = out.flames[i];
+        f.position = TransformPosition<S>(t, f.position);
+    }
+}
+
+template<int S, int N>
+int CanonicalTransform(const BasicState<S, N>& state)
+{
+    const SymmetryTables<S>& tables = SymmetryTables<S>::Get();
+    const int* in = &state.board.cells[0][0];
+
+    // eliminate the transforms whose boards are larger, cell by cell
+    int candidates = (1 << SYMMETRY_COUNT) - 1;
+    for(int k = 0; k < S * S && (candidates & (candidates - 1)) != 0; k++)
+    {
+        int items[SYMMETRY_COUNT];
+        int smallest = INT_MAX;
+        for(int t = 0; t < SYMMETRY_COUNT; t++)
+        {
+            items[t] = TransformedCell(tables, in, t, k);
+            if(candidates & (1 << t))
+            {
+                smallest = std::min(smallest, items[t]);
+            }
+        }
+        for(int t = 0; t < SYMMETRY_COUNT; t++)
+        {
+            if(items[t] != smallest)
+            {
+                candidates &= ~(1 << t);
+            }
+        }
+    }
+    if((candidates & (candidates - 1)) == 0)
+    {
+        return __builtin_ctz(candidates);
+    }
+
+    // a symmetric board, the rest of the state decides
+    int best = -1;
+    uint64_t bestHash = 0;
+    BasicState<S, N> s;
+    for(int t = 0; t < SYMMETRY_COUNT; t++)
+    {
+        if(candidates & (1 << t))
+        {
+            TransformState(state, s, t);
+            const uint64_t h = HashState(s);
+            if(best < 0 || h < bestHash)
+            {
+                best = t;
+                bestHash = h;
+            }
+        }
+    }
+    return best;
+}
+
+template<int S, int N>
+uint64_t CanonicalHash(const BasicState<S, N>& state, int* transform)
+{
+    const int t = CanonicalTransform(state);
+    if(transform != nullptr)
+    {
+        *transform = t;
+    }
+    if(t == 0)
+    {
+        return HashState(state);
+    }
+    BasicState<S, N> s;
+    TransformState(state, s, t);
+    return HashState(s);
+}
+
+#define INSTANTIATE_SYMMETRY(S, N)                                                         \
+    template void TransformState(const BasicState<S, N>&, BasicState<S, N>&, int);       \
+    template int CanonicalTransform(const BasicState<S, N>&);                              \
+    template uint64_t CanonicalHash(const BasicState<S, N>&, int*);
+
+BBOARD_FOR_EACH_SHAPE(INSTANTIATE_SYMMETRY)
+
+}
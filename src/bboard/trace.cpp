@@ -0,0 +1,221 @@
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+
+#include "trace.hpp"
+
+namespace bboard::trace
+{
+
+namespace
+{
+
+struct Event
+{
+    const char* name;
+    int64_t begin;
+    int64_t end;
+    uint32_t thread;
+    int16_t agent;
+    uint8_t category;
+};
+
+struct Chunk
+{
+    static const int SIZE = 256;
+
+    Event events[SIZE];
+    /**
+     * @brief count Written by the thread that holds the chunk, read by
+     * Stop
+     */
+    std::atomic<int> count{0};
+};
+
+std::mutex mutex;
+std::vector<std::unique_ptr<Chunk>> chunks;
+std::vector<Chunk*> partial; // chunks of finished threads with room left
+size_t maxChunks = 0;
+std::string output;
+int64_t origin = 0;
+
+std::atomic<uint64_t> session{0};
+std::atomic<uint64_t> dropped{0};
+std::atomic<uint32_t> threads{0};
+
+struct Local
+{
+    Chunk* chunk = nullptr;
+    uint64_t session = 0;
+    uint32_t thread = 0;
+
+    ~Local()
+    {
+        if(chunk == nullptr)
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        if(session == trace::session.load()
+                && chunk->count.load(std::memory_order_relaxed) < Chunk::SIZE)
+        {
+            partial.push_back(chunk);
+        }
+    }
+};
+
+thread_local Local local;
+
+/**
+ * @brief NextChunk Gives the calling thread a chunk with room left
+ * @return false if the trace is full or has been stopped
+ */
+bool NextChunk(uint64_t current)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if(session.load() != current || activeCategories.load() == 0)
+    {
+        return false;
+    }
+    if(local.session != current)
+    {
+        local.session = current;
+        local.thread = threads.fetch_add(1);
+    }
+
+    local.chunk = nullptr;
+    if(!partial.empty())
+    {
+        local.chunk = partial.back();
+        partial.pop_back();
+    }
+    else if(chunks.size() < maxChunks)
+    {
+        chunks.push_back(std::make_unique<Chunk>());
+        local.chunk = chunks.back().get();
+    }
+    return local.chunk != nullptr;
+}
+
+const char* CategoryName(int category)
+{
+    switch(category)
+    {
+        case ENGINE: return "engine";
+        case AGENTS: return "agents";
+        default: return "environment";
+    }
+}
+
+bool Write(const std::string& path)
+{
+    std::ofstream out(path, std::ios::trunc);
+    if(!out)
+    {
+        return false;
+    }
+    out << std::fixed << std::setprecision(3) << "{\"traceEvents\": [\n";
+    bool first = true;
+    for(const auto& c : chunks)
+    {
+        const int count = c->count.load(std::memory_order_acquire);
+        for(int i = 0; i < count; i++)
+        {
+            const Event& e = c->events[i];
+            // complete events ("X") hold the begin and the duration in us
+            out << (first ? "" : ",\n") << "  {\"name\": \"" << e.name << "\", \"cat\": \""
+                << CategoryName(e.category) << "\", \"ph\": \"X\", \"ts\": "
+                << double(e.begin - origin) / 1000.0 << ", \"dur\": "
+                << double(e.end - e.begin) / 1000.0 << ", \"pid\": 1, \"tid\": " << e.thread;
+            if(e.agent >= 0)
+            {
+                out << ", \"args\": {\"agent\": " << e.agent << "}";
+            }
+            out << "}";
+            first = false;
+        }
+    }
+    out << "\n], \"displayTimeUnit\": \"ms\", \"otherData\": {\"dropped\": " << dropped.load()
+        << "}}\n";
+    return bool(out);
+}
+
+/**
+ * @brief The trace is written when the program ends without Stop
+ */
+struct Shutdown
+{
+    ~Shutdown()
+    {
+        Stop();
+    }
+} shutdown;
+
+}
+
+bool Start(const std::string& path, int categories, size_t maxEvents)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if(activeCategories.load() != 0 || !std::ofstream(path, std::ios::trunc))
+    {
+        return false;
+    }
+    chunks.clear();
+    partial.clear();
+    maxChunks = std::max<size_t>(1, maxEvents / Chunk::SIZE);
+    output = path;
+    dropped = 0;
+    threads = 0;
+    origin = Now();
+    session++;
+    activeCategories = categories & ALL;
+    return true;
+}
+
+bool Stop()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if(activeCategories.load() == 0)
+    {
+        return false;
+    }
+    activeCategories = 0;
+    return Write(output);
+}
+
+TraceCounters GetTraceCounters()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    TraceCounters c;
+    for(const auto& chunk : chunks)
+    {
+        c.events += uint64_t(chunk->count.load(std::memory_order_acquire));
+    }
+    c.dropped = dropped.load();
+    c.threads = threads.load();
+    return c;
+}
+
+void Record(Category category, const char* name, int agent, int64_t begin, int64_t end)
+{
+    const uint64_t current = session.load(std::memory_order_acquire);
+    if(local.session != current || local.chunk == nullptr
+            || local.chunk->count.load(std::memory_order_relaxed) == Chunk::SIZE)
+    {
+        if(!NextChunk(current))
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    Chunk& c = *local.chunk;
+    const int n = c.count.load(std::memory_order_relaxed);
+    c.events[n] = {name, begin, end, local.thread, int16_t(agent), uint8_t(category)};
+    c.count.store(n + 1, std::memory_order_release);
+}
+
+}
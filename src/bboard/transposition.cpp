@@ -0,0 +1,245 @@
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <algorithm>
+#include <functional>
+#include <sys/mman.h>
+
+#include "bboard.hpp"
+#include "transposition.hpp"
+
+namespace bboard::search
+{
+
+namespace
+{
+
+const size_t HUGE_PAGE = size_t(2) << 20;
+
+// data word: value (16 bits), count (16), move (8), generation (8),
+// unused (15), valid (1)
+const uint64_t VALID = uint64_t(1) << 63;
+
+inline uint64_t Pack(const TTData& d, uint8_t generation)
+{
+    const float v = std::min(std::max(d.value, -1.0f), 1.0f);
+    const int16_t value = int16_t(std::lround(v * 32767.0f));
+    const uint16_t count = uint16_t(std::min(std::max(d.count, 0), 65535));
+    return uint64_t(uint16_t(value)) | uint64_t(count) << 16 | uint64_t(uint8_t(d.move)) << 32
+           | uint64_t(generation) << 40 | VALID;
+}
+
+inline TTData Unpack(uint64_t data)
+{
+    TTData d;
+    d.value = float(int16_t(uint16_t(data))) / 32767.0f;
+    d.count = int(uint16_t(data >> 16));
+    d.move = Move(uint8_t(data >> 32));
+    return d;
+}
+
+inline uint8_t GenerationOf(uint64_t data)
+{
+    return uint8_t(data >> 40);
+}
+
+inline int CountOf(uint64_t data)
+{
+    return int(uint16_t(data >> 16));
+}
+
+}
+
+TranspositionTable::TranspositionTable(size_t megabytes, Replacement replacement)
+    : replacement(replacement)
+{
+    const size_t bytes = std::max(megabytes, size_t(1)) << 20;
+    bucketCount = 1;
+    while(2 * bucketCount * sizeof(Bucket) <= bytes)
+    {
+        bucketCount *= 2;
+    }
+    const size_t size = bucketCount * sizeof(Bucket);
+
+    // over-allocate to align the table to a huge page
+    mappingSize = size + (size >= HUGE_PAGE ? HUGE_PAGE : 0);
+    mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    void* p;
+    if(mapping == MAP_FAILED)
+    {
+        mapping = nullptr;
+        p = std::aligned_alloc(sizeof(Bucket), size);
+        std::memset(p, 0, size);
+    }
+    else
+    {
+        // anonymous pages are zero, i.e. all entries are empty
+        uintptr_t a = reinterpret_cast<uintptr_t>(mapping);
+        if(size >= HUGE_PAGE)
+        {
+            a = (a + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+        }
+        p = reinterpret_cast<void*>(a);
+#ifdef MADV_HUGEPAGE
+        hugePages = madvise(p, size, MADV_HUGEPAGE) == 0;
+#endif
+    }
+    buckets = static_cast<Bucket*>(p);
+    std::uninitialized_default_construct_n(buckets, bucketCount);
+}
+
+TranspositionTable::~TranspositionTable()
+{
+    if(mapping != nullptr)
+    {
+        munmap(mapping, mappingSize);
+    }
+    else
+    {
+        std::free(buckets);
+    }
+}
+
+TranspositionTable::CounterStripe& TranspositionTable::Stripe(CounterStripe* counters)
+{
+    thread_local const size_t stripe = std::hash<std::thread::id>()(std::this_thread::get_id()) % STRIPES;
+    return counters[stripe];
+}
+
+bool TranspositionTable::Probe(uint64_t key, TTData& data)
+{
+    CounterStripe& c = Stripe(counters);
+    c.probes.fetch_add(1, std::memory_order_relaxed);
+
+    const Bucket& b = BucketOf(key);
+    for(const Entry& e : b.entries)
+    {
+        const uint64_t d = e.data.load(std::memory_order_relaxed);
+        const uint64_t check = e.check.load(std::memory_order_relaxed);
+        // a torn entry doesn't verify
+        if((d & VALID) && (check ^ d) == key)
+        {
+            data = Unpack(d);
+            c.hits.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+int TranspositionTable::Victim(const Bucket& b, uint64_t key) const
+{
+    uint64_t data[BUCKET_SIZE];
+    for(int k = 0; k < BUCKET_SIZE; k++)
+    {
+        data[k] = b.entries[k].data.load(std::memory_order_relaxed);
+        const uint64_t check = b.entries[k].check.load(std::memory_order_relaxed);
+        if((data[k] & VALID) && (check ^ data[k]) == key)
+        {
+            return k;
+        }
+    }
+    for(int k = 0; k < BUCKET_SIZE; k++)
+    {
+        if(!(data[k] & VALID))
+        {
+            return k;
+        }
+    }
+
+    if(replacement == Replacement::ALWAYS)
+    {
+        return int(key & (BUCKET_SIZE - 1));
+    }
+
+    const uint8_t current = generation.load(std::memory_order_relaxed);
+    int victim = 0;
+    int victimScore = 1 << 30;
+    for(int k = 0; k < BUCKET_SIZE; k++)
+    {
+        int score = CountOf(data[k]);
+        if(replacement == Replacement::AGING && GenerationOf(data[k]) == current)
+        {
+            score += 1 << 16;
+        }
+        if(score < victimScore)
+        {
+            victim = k;
+            victimScore = score;
+        }
+    }
+    return victim;
+}
+
+void TranspositionTable::Store(uint64_t key, const TTData& data)
+{
+    CounterStripe& c = Stripe(counters);
+    c.stores.fetch_add(1, std::memory_order_relaxed);
+
+    Bucket& b = BucketOf(key);
+    Entry& e = b.entries[Victim(b, key)];
+    const uint64_t old = e.data.load(std::memory_order_relaxed);
+    if((old & VALID) && (e.check.load(std::memory_order_relaxed) ^ old) != key)
+    {
+        c.collisions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const uint64_t d = Pack(data, generation.load(std::memory_order_relaxed));
+    e.data.store(d, std::memory_order_relaxed);
+    e.check.store(key ^ d, std::memory_order_relaxed);
+}
+
+TTData TranspositionTable::AddSample(uint64_t key, float value)
+{
+    TTData d;
+    if(Probe(key, d))
+    {
+        const int n = std::min(d.count, 65534);
+        d.value = (d.value * n + value) / (n + 1);
+        d.count = n + 1;
+    }
+    else
+    {
+        d.value = value;
+        d.count = 1;
+    }
+    Store(key, d);
+    return d;
+}
+
+void TranspositionTable::Clear()
+{
+    for(size_t k = 0; k < bucketCount; k++)
+    {
+        for(Entry& e : buckets[k].entries)
+        {
+            e.check.store(0, std::memory_order_relaxed);
+            e.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    for(CounterStripe& c : counters)
+    {
+        c.probes = 0;
+        c.hits = 0;
+        c.stores = 0;
+        c.collisions = 0;
+    }
+    generation = 0;
+}
+
+TTCounters TranspositionTable::GetCounters() const
+{
+    TTCounters total;
+    for(const CounterStripe& c : counters)
+    {
+        total.probes += c.probes.load(std::memory_order_relaxed);
+        total.hits += c.hits.load(std::memory_order_relaxed);
+        total.stores += c.stores.load(std::memory_order_relaxed);
+        total.collisions += c.collisions.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+}
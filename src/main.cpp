@@ -1,12 +1,23 @@
 ﻿#include <iostream>
 #include <chrono>
 #include <thread>
+#include <string>
 
 #include "bboard.hpp"
+#include "trace.hpp"
 #include "agents.hpp"
 
-int main()
+int main(int argc, char** argv)
 {
+    // ./bin/exec --trace game.json records a Chrome trace of the game
+    if(argc == 3 && std::string(argv[1]) == "--trace")
+    {
+        if(!bboard::trace::Start(argv[2]))
+        {
+            std::cerr << "Can't write the trace to " << argv[2] << std::endl;
+            return 1;
+        }
+    }
 
     agents::SimpleAgent r[4];
     agents::SimpleAgent g[4];
@@ -0,0 +1,347 @@
+#include <new>
+#include <atomic>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+#include <functional>
+
+#include "catch.hpp"
+#include "testing_utilities.hpp"
+
+#include "bboard.hpp"
+#include "agents.hpp"
+#include "colors.hpp"
+#include "net.hpp"
+#include "evaluation_queue.hpp"
+#include "ntuple.hpp"
+
+using namespace bboard;
+using namespace agents;
+
+/*
+ * Every heap allocation of the test binary passes through the hooks
+ * below. They count while tracking is on, in any thread. With glibc,
+ * malloc, calloc and realloc are replaced as well (forwarding to the
+ * __libc_ functions), so allocations of C code and the standard
+ * library are counted too.
+ */
+
+namespace
+{
+
+std::atomic<bool> tracking(false);
+std::atomic<uint64_t> allocationCount(0);
+std::atomic<uint64_t> allocatedBytes(0);
+
+inline void Record(size_t bytes)
+{
+    if(tracking.load(std::memory_order_relaxed))
+    {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+}
+
+}
+
+#ifdef __GLIBC__
+extern "C"
+{
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* p, size_t size);
+
+void* malloc(size_t size)
+{
+    Record(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    Record(count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* p, size_t size)
+{
+    Record(size);
+    return __libc_realloc(p, size);
+}
+}
+
+inline void* RawMalloc(size_t size)
+{
+    return __libc_malloc(size);
+}
+#else
+inline void* RawMalloc(size_t size)
+{
+    return std::malloc(size);
+}
+#endif
+
+inline void* CountedNew(size_t size)
+{
+    Record(size);
+    void* p = RawMalloc(size == 0 ? 1 : size);
+    if(p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+inline void* CountedAlignedNew(size_t size, std::align_val_t align)
+{
+    Record(size);
+    const size_t a = size_t(align);
+    void* p = std::aligned_alloc(a, (size + a - 1) / a * a);
+    if(p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new(size_t size)
+{
+    return CountedNew(size);
+}
+void* operator new[](size_t size)
+{
+    return CountedNew(size);
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    Record(size);
+    return RawMalloc(size == 0 ? 1 : size);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    Record(size);
+    return RawMalloc(size == 0 ? 1 : size);
+}
+void* operator new(size_t size, std::align_val_t align)
+{
+    return CountedAlignedNew(size, align);
+}
+void* operator new[](size_t size, std::align_val_t align)
+{
+    return CountedAlignedNew(size, align);
+}
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+void operator delete[](void* p, size_t) noexcept
+{
+    std::free(p);
+}
+void operator delete(void* p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+void operator delete[](void* p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+void operator delete(void* p, size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+void operator delete[](void* p, size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+
+struct AllocationReport
+{
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    int ticks = 0;
+};
+
+/**
+ * @brief CountAllocations Runs the function `ticks` times and counts
+ * the heap allocations of all threads in the meantime
+ */
+AllocationReport CountAllocations(int ticks, const std::function<void()>& tick)
+{
+    AllocationReport r;
+    r.ticks = ticks;
+    allocationCount = 0;
+    allocatedBytes = 0;
+    tracking = true;
+    for(int k = 0; k < ticks; k++)
+    {
+        tick();
+    }
+    tracking = false;
+    r.allocations = allocationCount;
+    r.bytes = allocatedBytes;
+    return r;
+}
+
+/**
+ * @brief Positions Plays a random game and keeps a state of every
+ * step (restarts the game when it ends)
+ */
+std::vector<State> Positions(int count, uint32_t seed)
+{
+    std::vector<State> states(count);
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> moveDist(0, 5);
+    State s;
+    InitState(&s, 0, 1, 2, 3);
+    for(State& p : states)
+    {
+        if(s.aliveAgents < 2)
+        {
+            s = State();
+            InitBoardItems(s, int(rng()));
+            s.PutAgentsInCorners(0, 1, 2, 3);
+        }
+        p = s;
+        Move m[AGENT_COUNT];
+        for(int i = 0; i < AGENT_COUNT; i++)
+        {
+            m[i] = Move(moveDist(rng));
+        }
+        Step(&s, m);
+    }
+    return states;
+}
+
+/**
+ * @brief The built-in agents with the resources they need
+ */
+struct AgentZoo
+{
+    net::Network network;
+    ntuple::NTupleNetwork tuples;
+    std::unique_ptr<net::EvaluationQueue> queue;
+
+    std::vector<std::pair<std::string, std::unique_ptr<Agent>>> agents;
+
+    AgentZoo()
+    {
+        network.Init(16, 2, 2, 3);
+        queue = std::make_unique<net::EvaluationQueue>(network, 8);
+        // the evaluator thread sets up its buffers on the first batch,
+        // not while the other agents are counted
+        State s;
+        InitState(&s, 0, 1, 2, 3);
+        queue->Evaluate(s, 0);
+        agents.emplace_back("RandomAgent", std::make_unique<agents::RandomAgent>());
+        agents.emplace_back("HarmlessAgent", std::make_unique<agents::HarmlessAgent>());
+        agents.emplace_back("LazyAgent", std::make_unique<agents::LazyAgent>());
+        agents.emplace_back("SimpleAgent", std::make_unique<agents::SimpleAgent>());
+        agents.emplace_back("NetAgent", std::make_unique<agents::NetAgent>(&network));
+        agents.emplace_back("PUCTAgent", std::make_unique<agents::PUCTAgent>(queue.get(), 32, 4));
+        agents.emplace_back("NTupleAgent", std::make_unique<agents::NTupleAgent>(&tuples));
+        agents.emplace_back("RHEAAgent", std::make_unique<agents::RHEAAgent>(6, 6));
+        agents.emplace_back("DUCTAgent", std::make_unique<agents::DUCTAgent>(64, 1 << 10));
+        for(auto& a : agents)
+        {
+            a.second->id = 0;
+        }
+    }
+};
+
+/**
+ * @brief ForEachPath Counts the allocations of Step, the act of every
+ * built-in agent and Environment::Step (with and without the
+ * competitive time limit) after a warm-up
+ * @param report Called with the name of the path, the counts and
+ * whether the path must not allocate
+ */
+void ForEachPath(bool timeLimit,
+                 const std::function<void(const std::string&, const AllocationReport&, bool)>& report)
+{
+    const int warmUp = 20;
+    const std::vector<State> states = Positions(200, 3);
+
+    State s;
+    size_t k = 0;
+    report("bboard::Step", CountAllocations(int(states.size()), [&]()
+    {
+        s = states[k++];
+        Move m[AGENT_COUNT] = {Move::UP, Move::BOMB, Move::LEFT, Move::IDLE};
+        Step(&s, m);
+    }), true);
+
+    AgentZoo zoo;
+    for(auto& a : zoo.agents)
+    {
+        Agent* agent = a.second.get();
+        for(k = 0; k < warmUp; k++)
+        {
+            agent->act(&states[k]);
+        }
+        report(a.first + "::act", CountAllocations(int(states.size()) - warmUp, [&]()
+        {
+            agent->act(&states[k++]);
+        }), true);
+    }
+
+    for(bool competitive : {false, true})
+    {
+        if(competitive && !timeLimit)
+        {
+            continue;
+        }
+        SimpleAgent a[AGENT_COUNT];
+        Environment env;
+        env.MakeGame({&a[0], &a[1], &a[2], &a[3]});
+        env.Step(competitive);
+        // a thread per agent and step
+        report(competitive ? "Environment::Step (time limit)" : "Environment::Step",
+               CountAllocations(competitive ? 10 : 100, [&]()
+        {
+            env.Step(competitive);
+        }), !competitive);
+    }
+}
+
+}
+
+TEST_CASE("Zero Allocation Paths", "[allocation]")
+{
+    // the hooks see an allocation
+    std::vector<int>* v = nullptr;
+    REQUIRE(CountAllocations(1, [&]() { v = new std::vector<int>(16); }).allocations == 2);
+    delete v;
+
+    ForEachPath(false, [](const std::string& name, const AllocationReport& r, bool zero)
+    {
+        INFO(name << ": " << r.allocations << " allocations, " << r.bytes << " bytes");
+        REQUIRE((!zero || r.allocations == 0));
+    });
+}
+
+TEST_CASE("Allocations Per Tick", "[allocation][performance]")
+{
+    std::cout << std::endl << FGRN(std::string("Test Results:\n"));
+    ForEachPath(true, [](const std::string& name, const AllocationReport& r, bool zero)
+    {
+        std::cout << "  " << name << std::string(name.size() < 32 ? 32 - name.size() : 0, ' ')
+                  << double(r.allocations) / r.ticks << " allocations, "
+                  << double(r.bytes) / r.ticks << " bytes per tick"
+                  << (zero ? "" : " (may allocate)") << std::endl;
+    });
+    REQUIRE(1);
+}
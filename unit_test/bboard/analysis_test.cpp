@@ -0,0 +1,111 @@
+#include "catch.hpp"
+#include "bboard.hpp"
+#include "agents.hpp"
+#include "strategy.hpp"
+#include "analysis.hpp"
+
+using namespace bboard;
+
+TEST_CASE("Danger Map", "[strategy]")
+{
+    auto s = std::make_unique<State>();
+    InitBoardItems(*s.get(), 0x1337);
+    s->PutAgentsInCorners(0, 1, 2, 3);
+    s->agents[1].bombStrength = 4;
+    s->PlantBombModifiedLife(2, 0, 0, 3, true);
+    s->PlantBombModifiedLife(9, 1, 1, 5, true);
+    s->PlantBomb(5, 5, 2, true);
+
+    strategy::DangerMap d;
+    strategy::FillDangerMap(*s.get(), d);
+
+    for(int y = 0; y < BOARD_SIZE; y++)
+    {
+        for(int x = 0; x < BOARD_SIZE; x++)
+        {
+            REQUIRE(d.Get(x, y) == strategy::IsInDanger(*s.get(), x, y));
+        }
+    }
+}
+
+TEST_CASE("Analysis Context", "[strategy]")
+{
+    auto s = std::make_unique<State>();
+    InitBoardItems(*s.get(), 0x1337);
+    s->PutAgentsInCorners(0, 1, 2, 3);
+    s->PlantBomb(2, 0, 0, true);
+
+    strategy::AnalysisContext analysis;
+    analysis.Reset(s.get());
+
+    SECTION("Lazy Computation")
+    {
+        REQUIRE(analysis.GetComputeCount() == 0);
+
+        analysis.GetRMap(2);
+        analysis.GetRMap(2);
+        REQUIRE(analysis.GetComputeCount() == 1);
+
+        analysis.GetDangerMap();
+        analysis.GetTimeline();
+        REQUIRE(analysis.GetComputeCount() == 3);
+
+        analysis.Reset(s.get());
+        REQUIRE(analysis.GetComputeCount() == 0);
+    }
+    SECTION("Same Results")
+    {
+        strategy::RMap r;
+        strategy::FillRMap(*s.get(), r, 1);
+        const strategy::RMap& shared = analysis.GetRMap(1);
+
+        for(int y = 0; y < BOARD_SIZE; y++)
+        {
+            for(int x = 0; x < BOARD_SIZE; x++)
+            {
+                REQUIRE(shared.map[y][x] == r.map[y][x]);
+            }
+        }
+
+        strategy::Timeline t;
+        strategy::ProjectState(*s.get(), t);
+        for(int i = 0; i <= strategy::PROJECTION_HORIZON; i++)
+        {
+            REQUIRE(analysis.GetTimeline().flames[i] == t.flames[i]);
+        }
+    }
+}
+
+TEST_CASE("Simple Agent With Analysis", "[strategy]")
+{
+    agents::SimpleAgent plain[AGENT_COUNT];
+    agents::SimpleAgent shared[AGENT_COUNT];
+
+    auto s = std::make_unique<State>();
+    InitState(s.get(), 0, 1, 2, 3);
+    strategy::AnalysisContext analysis;
+
+    for(int i = 0; i < AGENT_COUNT; i++)
+    {
+        plain[i].id = shared[i].id = i;
+        plain[i].rng = shared[i].rng = std::mt19937_64(i);
+    }
+
+    // both variants have to make the same decisions
+    for(int t = 0; t < 200 && s->aliveAgents > 1; t++)
+    {
+        analysis.Reset(s.get());
+        Move m[AGENT_COUNT];
+        for(int i = 0; i < AGENT_COUNT; i++)
+        {
+            if(s->agents[i].dead)
+            {
+                m[i] = Move::IDLE;
+                continue;
+            }
+            m[i] = plain[i].act(s.get());
+            REQUIRE(shared[i].act(s.get(), analysis) == m[i]);
+        }
+        Step(s.get(), m);
+    }
+}
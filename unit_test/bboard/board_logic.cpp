@@ -1,4 +1,7 @@
 #include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
 
 #include "catch.hpp"
 #include "bboard.hpp"
@@ -236,6 +239,22 @@ TEST_CASE("Movement Dependency Handling", "[step function]")
         REQUIRE_AGENT(s, 1, 1, 1);
         REQUIRE_AGENT(s, 2, 0, 1);
     }
+    SECTION("Switch With A Dead Agent")
+    {
+        // the dead agent's cell is free, its move doesn't matter
+        s->PutAgent(5, 6, 0);
+        s->PutAgent(5, 5, 1);
+        s->PutAgent(0, 0, 2);
+        s->PutAgent(10, 10, 3);
+        s->Kill(1);
+        s->board[5][5] = bboard::Item::PASSAGE;
+
+        m[0] = bboard::Move::UP;
+        m[1] = bboard::Move::DOWN;
+
+        bboard::Step(s, m);
+        REQUIRE_AGENT(s, 0, 5, 5);
+    }
 }
 
 TEST_CASE("Bomb Mechanics", "[step function]")
@@ -255,6 +274,24 @@ TEST_CASE("Bomb Mechanics", "[step function]")
         bboard::Step(s.get(), m);
         REQUIRE(s->board[0][0] == bboard::Item::BOMB);
     }
+    SECTION("Planted Bombs Don't Move")
+    {
+        // the queue slot of the new bomb still holds a kicked bomb
+        s->PutAgentsInCorners(0, 1, 2, 3);
+        bboard::Bomb& stale = s->bombs.NextPos();
+        bboard::SetBombDirection(stale, bboard::Direction::RIGHT);
+        bboard::SetBombMovedFlag(stale, true);
+
+        m[0] = bboard::Move::BOMB;
+        bboard::Step(s.get(), m);
+        REQUIRE(s->bombs.count == 1);
+        REQUIRE(bboard::BMB_DIR(s->bombs[0]) == 0);
+        REQUIRE(bboard::BMB_MOVED(s->bombs[0]) == 0);
+
+        m[0] = bboard::Move::DOWN;
+        bboard::Step(s.get(), m);
+        REQUIRE(s->board[0][0] == bboard::Item::BOMB);
+    }
     SECTION("Bomb Movement Block Simple")
     {
         s->PutAgentsInCorners(0, 1, 2, 3);
@@ -467,6 +504,23 @@ TEST_CASE("Chained Explosions", "[step function]")
         REQUIRE(s->bombs.count == 0);
         REQUIRE(s->flames.count == 2);
     }
+    SECTION("Chained Bomb Earlier In The Queue")
+    {
+        s->PutAgentsInCorners(0, 1, 2, 3);
+        s->PlantBomb(4, 5, 1, true);
+        s->PlantBomb(5, 5, 0, true);
+        s->PlantBomb(8, 8, 2, true);
+
+        // (4, 5) goes off with (5, 5) and shifts the queue
+        s->ExplodeBombAt(1);
+
+        REQUIRE(s->bombs.count == 1);
+        REQUIRE(s->HasBomb(8, 8));
+        REQUIRE(s->board[8][8] == Item::BOMB);
+        REQUIRE(s->agents[0].bombCount == 0);
+        REQUIRE(s->agents[1].bombCount == 0);
+        REQUIRE(s->agents[2].bombCount == 1);
+    }
 
 
 }
@@ -657,3 +711,297 @@ TEST_CASE("Bomb Kick Mechanics", "[step function]")
 
         */
 }
+
+TEST_CASE("Step Kernels", "[step function]")
+{
+    auto s = std::make_unique<bboard::State>();
+    bboard::Move id = bboard::Move::IDLE;
+    bboard::Move m[4] = {id, id, id, id};
+    bboard::StepKernelCounters& c = bboard::GetStepKernelCounters();
+    c = bboard::StepKernelCounters();
+
+    s->PutAgent(0, 1, 0);
+    s->Kill(1, 2, 3);
+    bboard::Step(s.get(), m);
+    REQUIRE(c.ticks[int(bboard::StepKernel::NO_BOMBS)] == 1);
+
+    s->PlantBomb(1, 1, 0, true);
+    bboard::Step(s.get(), m);
+    REQUIRE(c.ticks[int(bboard::StepKernel::BOMBS_AT_REST)] == 1);
+
+    // walking onto the bomb without kick bounces the agent back
+    m[0] = bboard::Move::RIGHT;
+    bboard::Step(s.get(), m);
+    REQUIRE(c.ticks[int(bboard::StepKernel::BOMBS_IN_MOTION)] == 1);
+    REQUIRE_AGENT(s.get(), 0, 0, 1);
+    REQUIRE(s->board[1][1] == bboard::Item::BOMB);
+
+    s->agents[0].canKick = true;
+    bboard::Step(s.get(), m);
+    REQUIRE(c.ticks[int(bboard::StepKernel::BOMBS_IN_MOTION)] == 2);
+    REQUIRE_AGENT(s.get(), 0, 1, 1);
+    REQUIRE(s->board[1][2] == bboard::Item::BOMB);
+}
+
+namespace
+{
+
+bool HasEvent(const bboard::StepEvents& e, bboard::EventType type, int agent, int x, int y, int value)
+{
+    for(int i = 0; i < e.count; i++)
+    {
+        const bboard::Event& v = e.events[i];
+        if(v.type == type && v.agent == agent && v.position.x == x
+                && v.position.y == y && v.value == value)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+}
+
+TEST_CASE("Step Events", "[step function]")
+{
+    auto s = std::make_unique<bboard::State>();
+    auto e = std::make_unique<bboard::StepEvents>();
+    bboard::Move id = bboard::Move::IDLE;
+    bboard::Move m[4] = {id, id, id, id};
+
+    SECTION("Plant, Explode, Kill And Destroy Wood")
+    {
+        s->PutAgent(1, 1, 0);
+        s->PutAgent(2, 1, 1);
+        s->Kill(2, 3);
+        s->board[0][1] = Item::WOOD;
+
+        m[0] = bboard::Move::BOMB;
+        bboard::Step(s.get(), m, e.get());
+        REQUIRE(e->count == 1);
+        REQUIRE(HasEvent(*e, EventType::BOMB_PLANTED, 0, 1, 1, 0));
+
+        // agent 0 leaves the range of the bomb
+        for(int i = 0; i < bboard::BOMB_LIFETIME - 1; i++)
+        {
+            m[0] = i < 2 ? bboard::Move::DOWN : bboard::Move::IDLE;
+            bboard::Step(s.get(), m, e.get());
+            REQUIRE(e->count == 0);
+        }
+        bboard::Step(s.get(), m, e.get());
+        REQUIRE(e->count == 3);
+        REQUIRE(e->events[0].type == EventType::BOMB_EXPLODED);
+        REQUIRE(HasEvent(*e, EventType::BOMB_EXPLODED, 0, 1, 1, 1));
+        REQUIRE(HasEvent(*e, EventType::AGENT_DIED, 1, 2, 1, 0));
+        REQUIRE(HasEvent(*e, EventType::WOOD_DESTROYED, 0, 1, 0, 0));
+        REQUIRE(e->dropped == 0);
+    }
+    SECTION("Kick, Power-Up And Walking Into Flames")
+    {
+        s->PutAgent(0, 1, 0);
+        s->PutAgent(5, 5, 1);
+        s->PutAgent(8, 8, 2);
+        s->Kill(3);
+        s->agents[0].canKick = true;
+        s->PlantBomb(1, 1, 0, true);
+        s->board[5][6] = Item::EXTRABOMB;
+        s->SpawnFlame(9, 9, 1, 3);
+
+        m[0] = bboard::Move::RIGHT;
+        m[1] = bboard::Move::RIGHT;
+        m[2] = bboard::Move::RIGHT;
+        bboard::Step(s.get(), m, e.get());
+
+        REQUIRE(e->count == 3);
+        REQUIRE(HasEvent(*e, EventType::BOMB_KICKED, 0, 1, 1, int(bboard::Move::RIGHT)));
+        REQUIRE(HasEvent(*e, EventType::POWERUP_COLLECTED, 1, 6, 5, Item::EXTRABOMB));
+        REQUIRE(HasEvent(*e, EventType::AGENT_DIED, 2, 8, 8, 3));
+    }
+}
+
+TEST_CASE("Batch Step", "[step function]")
+{
+    auto s = std::make_unique<bboard::State>();
+    s->PutAgent(4, 4, 0);
+    s->PutAgent(5, 4, 1);
+    s->PutAgent(5, 5, 2);
+    s->PutAgent(4, 6, 3);
+    s->agents[0].canKick = s->agents[2].canKick = true;
+    s->PlantBomb(3, 4, 1, true);
+    s->PlantBomb(6, 5, 3, true);
+    s->PutItem(4, 3, bboard::Item::WOOD);
+    s->SpawnFlame(4, 8, 1);
+
+    // bomb (3,4) explodes in this step
+    for(int i = 0; i < bboard::BOMB_LIFETIME - 1; i++)
+    {
+        bboard::ReduceBombTimer(s->bombs[0]);
+    }
+
+    // every joint action
+    const int count = 6 * 6 * 6 * 6;
+    auto moves = std::make_unique<bboard::Move[][bboard::AGENT_COUNT]>(count);
+    for(int a = 0; a < count; a++)
+    {
+        for(int i = 0, r = a; i < bboard::AGENT_COUNT; i++, r /= 6)
+        {
+            moves[a][i] = bboard::Move(r % 6);
+        }
+    }
+
+    std::vector<bboard::State> successors(count);
+    bboard::StepBatch(*s.get(), moves.get(), count, successors.data());
+
+    auto t = std::make_unique<bboard::State>();
+    for(int a = 0; a < count; a++)
+    {
+        *t.get() = *s.get();
+        bboard::Step(t.get(), moves[a]);
+        REQUIRE(bboard::EqualStates(*t.get(), successors[a]));
+    }
+}
+
+namespace
+{
+
+/**
+ * @brief PlayRandomGame Plays random moves on a fresh game of the
+ * given shape and checks that agents, bombs and the border stay
+ * consistent with the board after every step
+ */
+template<int S, int N>
+void PlayRandomGame(int seed, int steps)
+{
+    typedef bboard::BasicState<S, N> GameState;
+    typedef typename GameState::Format F;
+
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> moveDist(0, 5);
+
+    auto s = std::make_unique<GameState>();
+    bboard::InitState(s.get(), 0, 1, 2, 3);
+
+    bboard::Move m[N];
+    for(int t = 0; t < steps && s->aliveAgents > 1; t++)
+    {
+        for(int i = 0; i < N; i++)
+        {
+            m[i] = bboard::Move(moveDist(rng));
+        }
+        bboard::Step(s.get(), m);
+
+        for(int i = 0; i < N; i++)
+        {
+            const bboard::AgentInfo& a = s->agents[i];
+            if(!a.dead)
+            {
+                REQUIRE(s->board[a.y][a.x] == bboard::Item::AGENT0 + i);
+            }
+        }
+        for(int i = 0; i < s->bombs.count; i++)
+        {
+            const int x = F::PosX(s->bombs[i]);
+            const int y = F::PosY(s->bombs[i]);
+            REQUIRE(x < S);
+            REQUIRE(y < S);
+            // a bomb planted on top of another one is in the flames
+            // of the first one until it explodes
+            const int item = s->board[y][x];
+            REQUIRE((item == bboard::Item::BOMB || IS_AGENT(item) || IS_FLAME(item)));
+        }
+        for(int i = -1; i <= S; i++)
+        {
+            REQUIRE(s->board[-1][i] == bboard::Item::RIGID);
+            REQUIRE(s->board[S][i] == bboard::Item::RIGID);
+            REQUIRE(s->board[i][-1] == bboard::Item::RIGID);
+            REQUIRE(s->board[i][S] == bboard::Item::RIGID);
+        }
+    }
+}
+
+}
+
+TEST_CASE("Game Shapes", "[step function]")
+{
+    SECTION("Bomb Format")
+    {
+        typedef bboard::BasicState<21, 4>::Format F;
+        REQUIRE(bboard::PositionBits(bboard::BOARD_SIZE) == 4);
+        REQUIRE(bboard::PositionBits(16) == 4);
+        REQUIRE(bboard::PositionBits(21) == 5);
+
+        bboard::Bomb b = 0;
+        F::SetPosition(b, 20, 17);
+        F::SetID(b, 3);
+        F::SetStrength(b, 7);
+        F::SetTime(b, bboard::BOMB_LIFETIME);
+        F::SetDirection(b, bboard::Direction::LEFT);
+        F::ReduceTimer(b);
+        REQUIRE(F::PosX(b) == 20);
+        REQUIRE(F::PosY(b) == 17);
+        REQUIRE(F::ID(b) == 3);
+        REQUIRE(F::Strength(b) == 7);
+        REQUIRE(F::Time(b) == bboard::BOMB_LIFETIME - 1);
+        REQUIRE(bboard::Direction(F::Dir(b)) == bboard::Direction::LEFT);
+    }
+    SECTION("Two Agents In Opposite Corners")
+    {
+        auto s = std::make_unique<bboard::BasicState<8, 2>>();
+        s->PutAgentsInCorners(1, 0, 2, 3);
+        REQUIRE(s->board[0][0] == bboard::Item::AGENT1);
+        REQUIRE(s->board[7][7] == bboard::Item::AGENT0);
+        REQUIRE(s->agents[0].x == 7);
+        REQUIRE(s->agents[1].y == 0);
+    }
+    SECTION("Small Board Without Wood")
+    {
+        // this seed draws no wood, there is nowhere to hide power-ups
+        auto s = std::make_unique<bboard::BasicState<8, 2>>();
+        bboard::InitBoardItems(*s.get(), 17128);
+        for(int y = 0; y < 8; y++)
+        {
+            for(int x = 0; x < 8; x++)
+            {
+                REQUIRE(!IS_WOOD(s->board[y][x]));
+            }
+        }
+    }
+    SECTION("Explosion On A Large Board")
+    {
+        auto s = std::make_unique<bboard::BasicState<21, 4>>();
+        s->PutAgent(20, 20, 0);
+        s->PutAgent(0, 0, 1);
+        s->PutAgent(20, 0, 2);
+        s->PutAgent(0, 20, 3);
+
+        bboard::Move m[4] = {bboard::Move::BOMB};
+        bboard::Step(s.get(), m);
+        m[0] = bboard::Move::UP;
+        bboard::Step(s.get(), m);
+        m[0] = bboard::Move::LEFT;
+        bboard::Step(s.get(), m);
+        m[0] = bboard::Move::IDLE;
+        for(int i = 0; i < bboard::BOMB_LIFETIME - 3; i++)
+        {
+            bboard::Step(s.get(), m);
+        }
+        REQUIRE(s->bombs.count == 1);
+
+        bboard::Step(s.get(), m);
+        REQUIRE(s->bombs.count == 0);
+        REQUIRE(IS_FLAME(s->board[20][20]));
+        REQUIRE(IS_FLAME(s->board[19][20]));
+        REQUIRE(IS_FLAME(s->board[20][19]));
+        REQUIRE(!s->agents[0].dead);
+    }
+    SECTION("Random Games")
+    {
+        for(int seed = 0; seed < 20; seed++)
+        {
+            PlayRandomGame<8, 2>(seed, 300);
+            PlayRandomGame<bboard::BOARD_SIZE, bboard::AGENT_COUNT>(seed, 300);
+            PlayRandomGame<21, 4>(seed, 300);
+            PlayRandomGame<21, 16>(seed, 300);
+        }
+    }
+}
@@ -0,0 +1,108 @@
+#include <set>
+
+#include "catch.hpp"
+#include "bboard.hpp"
+#include "expansion.hpp"
+#include "duct.hpp"
+#include "agents.hpp"
+#include "testing_utilities.hpp"
+
+using namespace bboard;
+
+TEST_CASE("Decoupled UCT", "[search]")
+{
+    auto s = std::make_unique<State>();
+    InitState(s.get(), 0, 1, 2, 3);
+
+    SECTION("Children Are Distinct Outcomes")
+    {
+        auto e = std::make_unique<search::JointActionExpander>();
+        e->Expand(*s.get());
+        std::set<uint64_t> outcomes;
+        for(int k = 0; k < e->outcomeCount; k++)
+        {
+            outcomes.insert(e->outcomes[k].hash);
+        }
+
+        search::DecoupledUCT d(4096, 1);
+        d.Search(*s.get(), 2000);
+        REQUIRE(d.GetNodeCount() <= 2001);
+
+        std::set<uint64_t> children;
+        for(int n = 1; n < d.GetNodeCount(); n++)
+        {
+            const search::DUCTNode& node = d.GetNode(n);
+            REQUIRE(d.GetChild(node.parent, node.hash) == n);
+            if(node.parent == 0)
+            {
+                REQUIRE(outcomes.count(node.hash) == 1);
+                children.insert(node.hash);
+            }
+        }
+        // joint actions with the same outcome share their child
+        REQUIRE(int(children.size()) <= e->outcomeCount);
+        REQUIRE(children.size() > 1);
+    }
+    SECTION("Statistics")
+    {
+        s->Kill(3);
+        for(search::Selection sel : {search::Selection::UCT, search::Selection::EXP3})
+        {
+            search::DecoupledUCT d(1 << 12, 2);
+            d.selection = sel;
+            d.Search(*s.get(), 500);
+            const search::DUCTNode& root = d.GetRoot();
+            REQUIRE(root.visits == 500);
+            for(int i = 0; i < AGENT_COUNT; i++)
+            {
+                int visits = 0;
+                for(int m = 0; m < ACTION_COUNT; m++)
+                {
+                    visits += root.stats[i].visits[m];
+                    if(!strategy::HasMove(root.legal[i], Move(m)))
+                    {
+                        REQUIRE(root.stats[i].visits[m] == 0);
+                    }
+                }
+                REQUIRE(visits == 500);
+            }
+            // the dead agent idles
+            REQUIRE(root.stats[3].visits[int(Move::IDLE)] == 500);
+        }
+    }
+    SECTION("Full Arena")
+    {
+        search::DecoupledUCT d(50, 3);
+        d.Search(*s.get(), 500);
+        REQUIRE(d.GetNodeCount() == 50);
+        REQUIRE(d.GetRoot().visits == 500);
+    }
+    SECTION("Same Seed, Same Tree")
+    {
+        search::DecoupledUCT a(1 << 12, 4), b(1 << 12, 4);
+        a.Search(*s.get(), 300);
+        b.Search(*s.get(), 300);
+        REQUIRE(a.GetNodeCount() == b.GetNodeCount());
+        for(int i = 0; i < AGENT_COUNT; i++)
+        {
+            REQUIRE(a.BestMove(i) == b.BestMove(i));
+        }
+    }
+    SECTION("Escapes Its Own Bomb")
+    {
+        for(search::Selection sel : {search::Selection::UCT, search::Selection::EXP3})
+        {
+            auto t = std::make_unique<State>();
+            PrepareDeadEnd(*t.get());
+            agents::DUCTAgent a(400, 1 << 12, sel, 5);
+            a.id = 0;
+            Move m[AGENT_COUNT] = {};
+            for(int k = 0; k < 6; k++)
+            {
+                m[0] = a.act(t.get());
+                Step(t.get(), m);
+            }
+            REQUIRE(!t->agents[0].dead);
+        }
+    }
+}
@@ -0,0 +1,128 @@
+#include <set>
+
+#include "catch.hpp"
+#include "bboard.hpp"
+#include "expansion.hpp"
+
+using namespace bboard;
+
+namespace
+{
+
+/**
+ * @brief REQUIRE_VALID_EXPANSION Steps every joint action of the given
+ * state and compares the result with the outcome it was grouped into
+ */
+void REQUIRE_VALID_EXPANSION(const State& state, const search::JointActionExpander& e)
+{
+    int total = 0;
+    std::set<uint64_t> hashes;
+    for(int k = 0; k < e.outcomeCount; k++)
+    {
+        total += e.outcomes[k].count;
+        hashes.insert(e.outcomes[k].hash);
+    }
+    REQUIRE(total == search::JOINT_ACTION_COUNT);
+    REQUIRE(int(hashes.size()) == e.outcomeCount);
+
+    auto s = std::make_unique<State>();
+    Move moves[AGENT_COUNT];
+    for(search::JointAction a = 0; a < search::JOINT_ACTION_COUNT; a++)
+    {
+        *s.get() = state;
+        search::DecodeJointAction(a, moves);
+        Step(s.get(), moves);
+
+        const search::Outcome& o = e.outcomes[e.outcomeOf[a]];
+        REQUIRE(HashState(*s.get()) == o.hash);
+        REQUIRE(EqualStates(*s.get(), o.state));
+    }
+}
+
+}
+
+TEST_CASE("State Hashing", "[search]")
+{
+    auto s = std::make_unique<State>();
+    InitState(s.get(), 0, 1, 2, 3);
+    auto t = std::make_unique<State>(*s.get());
+
+    REQUIRE(HashState(*s.get()) == HashState(*t.get()));
+    REQUIRE(EqualStates(*s.get(), *t.get()));
+
+    // the queue offset is not part of the state
+    t->bombs.index = 7;
+    t->flames.index = 3;
+    t->timeStep = 10;
+    REQUIRE(HashState(*s.get()) == HashState(*t.get()));
+
+    t->PlantBomb(1, 0, 0);
+    REQUIRE(HashState(*s.get()) != HashState(*t.get()));
+    REQUIRE(!EqualStates(*s.get(), *t.get()));
+}
+
+TEST_CASE("Joint Action Expansion", "[search]")
+{
+    auto s = std::make_unique<State>();
+    auto e = std::make_unique<search::JointActionExpander>();
+
+    SECTION("Joint Action Encoding")
+    {
+        Move m[AGENT_COUNT] = {Move::BOMB, Move::IDLE, Move::LEFT, Move::UP};
+        Move d[AGENT_COUNT];
+        search::DecodeJointAction(search::EncodeJointAction(m), d);
+        for(int i = 0; i < AGENT_COUNT; i++)
+        {
+            REQUIRE(d[i] == m[i]);
+        }
+    }
+    SECTION("Initial State")
+    {
+        InitState(s.get(), 0, 1, 2, 3);
+        e->Expand(*s.get());
+
+        REQUIRE(e->stepCount < search::JOINT_ACTION_COUNT);
+        REQUIRE_VALID_EXPANSION(*s.get(), *e.get());
+    }
+    SECTION("Dead Agents")
+    {
+        s->PutAgent(5, 5, 0);
+        s->PutAgent(6, 5, 1);
+        s->Kill(2, 3);
+        e->Expand(*s.get());
+
+        REQUIRE(e->stepCount == ACTION_COUNT * ACTION_COUNT);
+        REQUIRE_VALID_EXPANSION(*s.get(), *e.get());
+    }
+    SECTION("Dead Agent Next To A Live One")
+    {
+        // the moves of a dead agent are grouped with IDLE, so they
+        // must not swap it with a live agent
+        s->PutAgent(5, 6, 0);
+        s->PutAgent(5, 5, 1);
+        s->PutAgent(0, 0, 2);
+        s->PutAgent(10, 10, 3);
+        s->Kill(1);
+        s->board[5][5] = Item::PASSAGE;
+        e->Expand(*s.get());
+
+        // the agents in the corners can't move in two directions
+        REQUIRE(e->stepCount == ACTION_COUNT * 4 * 4);
+        REQUIRE_VALID_EXPANSION(*s.get(), *e.get());
+    }
+    SECTION("Interacting Agents")
+    {
+        s->PutAgent(4, 4, 0);
+        s->PutAgent(5, 4, 1);
+        s->PutAgent(5, 5, 2);
+        s->PutAgent(4, 5, 3);
+        s->agents[0].canKick = s->agents[2].canKick = true;
+        s->PlantBomb(3, 4, 1, true);
+        s->PlantBomb(6, 5, 3, true);
+        s->SpawnFlame(4, 7, 1);
+        e->Expand(*s.get());
+
+        REQUIRE(e->outcomeCount < e->stepCount);
+        REQUIRE_VALID_EXPANSION(*s.get(), *e.get());
+    }
+}
@@ -0,0 +1,157 @@
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "bboard.hpp"
+#include "fixture.hpp"
+
+using namespace bboard;
+
+TEST_CASE("Fixtures", "[fixture]")
+{
+    Fixture f;
+    std::string error;
+
+    SECTION("Cells And Properties")
+    {
+        const char* text = R"(
+            # a comment
+            0 . W E R K e r k X o
+            . . . . . . . . . . .
+            . . 1 . . . . . . . .  # agent 2 is missing
+            . . . . . . . . . . .
+            . . . . . . . . . . .
+            . . . . . . . . . . .
+            . . . . . . . . . . .
+            . . . . . . . . . . .
+            . . . . . . . . . . .
+            . . . . . . . . . . .
+            . . . . . . . . . . 3
+            agent 1 bombs=3 strength=4 kick
+            bomb 2 2 timer=7 dir=left
+            bomb 5 5 owner=3 timer=2 strength=9
+            flame 5 8 strength=2 timer=3
+            moves up down left right
+            moves bomb idle idle idle
+        )";
+        REQUIRE(LoadFixture(text, f, &error));
+        const State& s = f.state;
+
+        REQUIRE(s.board[0][0] == Item::AGENT0);
+        REQUIRE(s.board[0][1] == Item::PASSAGE);
+        REQUIRE(s.board[0][2] == Item::WOOD);
+        REQUIRE(s.board[0][3] == Item::WOOD + 1);
+        REQUIRE(s.board[0][4] == Item::WOOD + 2);
+        REQUIRE(s.board[0][5] == Item::WOOD + 3);
+        REQUIRE(s.board[0][6] == Item::EXTRABOMB);
+        REQUIRE(s.board[0][7] == Item::INCRRANGE);
+        REQUIRE(s.board[0][8] == Item::KICK);
+        REQUIRE(s.board[0][9] == Item::RIGID);
+        REQUIRE(s.board[0][10] == Item::BOMB);
+        REQUIRE(s.board[2][2] == Item::AGENT1);
+        REQUIRE(s.board[5][5] == Item::BOMB);
+        REQUIRE(IS_FLAME(s.board[8][5]));
+        REQUIRE(IS_FLAME(s.board[8][7]));
+
+        REQUIRE(s.aliveAgents == 3);
+        REQUIRE(s.agents[2].dead);
+        REQUIRE(s.agents[1].canKick);
+        REQUIRE(s.agents[1].bombStrength == 4);
+        REQUIRE((s.agents[3].x == 10 && s.agents[3].y == 10));
+
+        // queued by their timers
+        REQUIRE(s.bombs.count == 3);
+        REQUIRE(BMB_TIME(s.bombs[0]) == 2);
+        REQUIRE(BMB_ID(s.bombs[0]) == 3);
+        REQUIRE(BMB_STRENGTH(s.bombs[0]) == 9);
+        REQUIRE(BMB_TIME(s.bombs[1]) == 7);
+        REQUIRE(BMB_ID(s.bombs[1]) == 1);
+        REQUIRE(BMB_STRENGTH(s.bombs[1]) == 4);
+        REQUIRE(BMB_DIR(s.bombs[1]) == int(Direction::LEFT));
+        REQUIRE(BMB_TIME(s.bombs[2]) == BOMB_LIFETIME);
+        REQUIRE((BMB_POS_X(s.bombs[2]) == 10 && BMB_POS_Y(s.bombs[2]) == 0));
+        REQUIRE(s.agents[1].bombCount == 1);
+        REQUIRE(s.agents[1].maxBombCount == 3);
+        REQUIRE(s.agents[3].maxBombCount == 1);
+
+        REQUIRE(s.flames.count == 1);
+        REQUIRE(s.flames[0].timeLeft == 3);
+
+        Move m[AGENT_COUNT];
+        f.GetMoves(2, m);
+        REQUIRE(m[0] == Move::UP);
+        REQUIRE(m[3] == Move::RIGHT);
+        f.GetMoves(3, m);
+        REQUIRE(m[0] == Move::BOMB);
+    }
+    SECTION("Syntax Errors")
+    {
+        const std::string row = ". . . . . . . . . . .\n";
+        std::string board;
+        for(int i = 0; i < BOARD_SIZE; i++)
+        {
+            board += row;
+        }
+        REQUIRE(LoadFixture(board, f));
+        REQUIRE(f.state.aliveAgents == 0);
+
+        REQUIRE(!LoadFixture(row, f, &error));
+        REQUIRE(error.find("rows") != std::string::npos);
+        REQUIRE(!LoadFixture(". . .\n" + board, f, &error));
+        REQUIRE(error.find("line 1") == 0);
+        REQUIRE(!LoadFixture(board + row, f, &error));
+        REQUIRE(!LoadFixture("0 . . . . . . . . . 0\n" + board.substr(row.size()), f, &error));
+        REQUIRE(!LoadFixture(board + "bomb 11 0\n", f, &error));
+        REQUIRE(!LoadFixture(board + "bomb 1 1 timer=0\n", f, &error));
+        REQUIRE(!LoadFixture(board + "bomb 1 1 dir=sideways\n", f, &error));
+        REQUIRE(!LoadFixture(board + "agent 1 fly\n", f, &error));
+        REQUIRE(!LoadFixture(board + "moves up up\n", f, &error));
+        REQUIRE(error.find("line 12") == 0);
+    }
+    SECTION("Pathological Corpus")
+    {
+        std::vector<Fixture> corpus = PathologicalFixtures();
+        REQUIRE(corpus.size() == 5);
+        for(Fixture& c : corpus)
+        {
+            INFO(c.name);
+            Move m[AGENT_COUNT];
+            State s = c.state;
+            c.GetMoves(0, m);
+            Step(&s, m);
+
+            if(c.name == "Chain Reaction 20")
+            {
+                REQUIRE(c.state.bombs.count == 20);
+                REQUIRE(s.bombs.count == 0);
+                REQUIRE(s.flames.count == 20);
+                REQUIRE(s.aliveAgents == 4);
+            }
+            if(c.name == "Ouroboros")
+            {
+                for(int t = 1; t < 4; t++)
+                {
+                    c.GetMoves(t, m);
+                    Step(&s, m);
+                }
+                // once around the square
+                for(int i = 0; i < AGENT_COUNT; i++)
+                {
+                    REQUIRE(s.agents[i].x == c.state.agents[i].x);
+                    REQUIRE(s.agents[i].y == c.state.agents[i].y);
+                }
+            }
+            if(c.name == "Four Kickers")
+            {
+                REQUIRE(s.bombs.count == 8);
+                REQUIRE(s.aliveAgents == 4);
+            }
+            if(c.name == "Crossing Flames")
+            {
+                REQUIRE(s.bombs.count == 0);
+                REQUIRE(s.flames.count == 12);
+                REQUIRE(s.aliveAgents == 4);
+            }
+        }
+    }
+}
@@ -40,7 +40,8 @@ void TestQueue(FixedQueue<Bomb, 10>& queue)
 }
 TEST_CASE("Fixed Size Queue", "[general]")
 {
-    FixedQueue<Bomb, 10>& queue = *std::make_unique<FixedQueue<Bomb, 10>>().get();
+    auto owner = std::make_unique<FixedQueue<Bomb, 10>>();
+    FixedQueue<Bomb, 10>& queue = *owner;
     SECTION("Index 0")
     {
         queue.index = 0;
@@ -0,0 +1,291 @@
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+#include "catch.hpp"
+#include "bboard.hpp"
+#include "agents.hpp"
+#include "net.hpp"
+#include "evaluation_queue.hpp"
+
+using namespace bboard;
+using namespace agents;
+
+namespace
+{
+
+void REQUIRE_VALID_EVALUATION(const net::Evaluation& e)
+{
+    float sum = 0;
+    for(int m = 0; m < net::POLICY_SIZE; m++)
+    {
+        REQUIRE(e.policy[m] >= 0);
+        sum += e.policy[m];
+    }
+    REQUIRE(sum == Approx(1.0f));
+    REQUIRE(std::abs(e.value) <= 1.0f);
+}
+
+/**
+ * @brief SomeStates Fills states of a random game (with bombs, flames
+ * and dead agents along the way)
+ */
+void SomeStates(State* states, int count)
+{
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> moveDist(0, 5);
+    InitState(&states[0], 0, 1, 2, 3);
+    for(int k = 1; k < count; k++)
+    {
+        states[k] = states[k - 1];
+        Move m[AGENT_COUNT];
+        for(int t = 0; t < 5; t++)
+        {
+            for(int i = 0; i < AGENT_COUNT; i++) m[i] = Move(moveDist(rng));
+            Step(&states[k], m);
+        }
+    }
+}
+
+}
+
+TEST_CASE("Network Evaluation", "[net]")
+{
+    net::Network n;
+    net::Workspace ws;
+    REQUIRE(n.Init(20, 3, 2, 1));
+    REQUIRE(n.GetStride() == 32);
+
+    const int count = 8;
+    auto states = std::make_unique<State[]>(count);
+    SomeStates(states.get(), count);
+
+    SECTION("Input Planes")
+    {
+        auto planes = std::make_unique<float[]>(net::PLANE_CELLS * net::CHANNEL_ALIGN);
+        net::FillPlanes(states[0], 0, planes.get());
+
+        auto at = [&planes](int x, int y, int c)
+        {
+            return planes[((y + 1) * net::PLANE_SIZE + x + 1) * net::CHANNEL_ALIGN + c];
+        };
+        REQUIRE(at(0, 0, 10) == 1); // agent 0 sees itself in the corner
+        REQUIRE(at(BOARD_SIZE - 1, 0, 11) == 1);
+        REQUIRE(at(0, 0, 11) == 0);
+        // the padding stays empty
+        for(int c = 0; c < net::CHANNEL_ALIGN; c++)
+        {
+            REQUIRE(planes[c] == 0);
+        }
+    }
+    SECTION("Batch Equals Single")
+    {
+        const State* batch[count];
+        int ids[count];
+        net::Evaluation out[count];
+        for(int k = 0; k < count; k++)
+        {
+            batch[k] = &states[k];
+            ids[k] = k % AGENT_COUNT;
+        }
+
+        for(net::Precision p : {net::Precision::FP32, net::Precision::INT8})
+        {
+            n.Evaluate(batch, ids, count, out, ws, p);
+            for(int k = 0; k < count; k++)
+            {
+                REQUIRE_VALID_EVALUATION(out[k]);
+                net::Evaluation e = n.Evaluate(states[k], ids[k], ws, p);
+                for(int m = 0; m < net::POLICY_SIZE; m++)
+                {
+                    REQUIRE(e.policy[m] == Approx(out[k].policy[m]));
+                }
+                REQUIRE(e.value == Approx(out[k].value));
+            }
+        }
+    }
+    SECTION("INT8 Is Close To FP32")
+    {
+        for(int k = 0; k < count; k++)
+        {
+            net::Evaluation f = n.Evaluate(states[k], 0, ws, net::Precision::FP32);
+            net::Evaluation q = n.Evaluate(states[k], 0, ws, net::Precision::INT8);
+            for(int m = 0; m < net::POLICY_SIZE; m++)
+            {
+                REQUIRE(std::abs(f.policy[m] - q.policy[m]) < 0.05f);
+            }
+            REQUIRE(std::abs(f.value - q.value) < 0.05f);
+        }
+    }
+    SECTION("Save And Load")
+    {
+        const std::string path = "net_test_weights.bin";
+        REQUIRE(n.Save(path));
+
+        net::Network m;
+        REQUIRE(m.Load(path));
+        std::remove(path.c_str());
+        REQUIRE(m.GetChannels() == 20);
+        REQUIRE(m.GetConvLayers() == 3);
+        REQUIRE(m.GetPolicyChannels() == 2);
+
+        for(int k = 0; k < count; k++)
+        {
+            net::Evaluation a = n.Evaluate(states[k], 1, ws);
+            net::Evaluation b = m.Evaluate(states[k], 1, ws);
+            for(int i = 0; i < net::POLICY_SIZE; i++)
+            {
+                REQUIRE(a.policy[i] == b.policy[i]);
+            }
+            REQUIRE(a.value == b.value);
+        }
+    }
+    SECTION("Reject Invalid Files")
+    {
+        const std::string path = "net_test_invalid.bin";
+        {
+            std::ofstream f(path, std::ios::binary);
+            f << "PNOT";
+        }
+        REQUIRE(!n.Load(path));
+
+        // truncated weights
+        REQUIRE(n.Save(path));
+        {
+            std::ifstream f(path, std::ios::binary);
+            std::string data((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+            std::ofstream g(path, std::ios::binary | std::ios::trunc);
+            g.write(data.data(), data.size() / 2);
+        }
+        REQUIRE(!n.Load(path));
+        std::remove(path.c_str());
+
+        REQUIRE(!n.Load("does_not_exist.bin"));
+        // the network is unchanged
+        REQUIRE(n.GetChannels() == 20);
+        REQUIRE_VALID_EVALUATION(n.Evaluate(states[0], 0, ws));
+    }
+    SECTION("Agent Plays Legal Moves")
+    {
+        NetAgent a(&n, net::Precision::INT8);
+        a.id = 2;
+        for(int k = 0; k < count; k++)
+        {
+            strategy::MoveMask legal[AGENT_COUNT];
+            strategy::LegalMoves(states[k], legal);
+            Move m = a.act(&states[k]);
+            REQUIRE((strategy::HasMove(legal[2], m) || legal[2] == 0));
+        }
+    }
+}
+
+TEST_CASE("Evaluation Queue", "[net]")
+{
+    net::Network n;
+    net::Workspace ws;
+    REQUIRE(n.Init(16, 2, 2, 3));
+
+    const int count = 12;
+    auto states = std::make_unique<State[]>(count);
+    SomeStates(states.get(), count);
+
+    SECTION("Results Match The Network")
+    {
+        net::EvaluationQueue queue(n, 4, std::chrono::microseconds(200));
+        net::EvaluationRequest requests[count];
+        for(int k = 0; k < count; k++)
+        {
+            requests[k].state = &states[k];
+            requests[k].agentID = k % AGENT_COUNT;
+            queue.Submit(requests[k]);
+        }
+        for(int k = 0; k < count; k++)
+        {
+            queue.Wait(requests[k]);
+            REQUIRE(requests[k].IsReady());
+            net::Evaluation e = n.Evaluate(states[k], k % AGENT_COUNT, ws);
+            for(int m = 0; m < net::POLICY_SIZE; m++)
+            {
+                REQUIRE(requests[k].result.policy[m] == Approx(e.policy[m]));
+            }
+            REQUIRE(requests[k].result.value == Approx(e.value));
+        }
+        REQUIRE(queue.GetEvaluationCount() == count);
+        REQUIRE(queue.GetBatchCount() >= count / 4);
+    }
+    SECTION("Waits For Full Batches")
+    {
+        // a long deadline, so only full batches get evaluated
+        net::EvaluationQueue queue(n, 6, std::chrono::seconds(10));
+        net::EvaluationRequest requests[count];
+        for(int k = 0; k < count; k++)
+        {
+            requests[k].state = &states[k];
+            queue.Submit(requests[k]);
+        }
+        for(int k = 0; k < count; k++)
+        {
+            queue.Wait(requests[k]);
+        }
+        REQUIRE(queue.GetBatchCount() == 2);
+    }
+    SECTION("Partial Batches After The Deadline")
+    {
+        net::EvaluationQueue queue(n, 64, std::chrono::microseconds(100));
+        net::Evaluation e = queue.Evaluate(states[3], 1);
+        REQUIRE_VALID_EVALUATION(e);
+        REQUIRE(queue.GetBatchCount() == 1);
+    }
+    SECTION("Concurrent Callers")
+    {
+        net::EvaluationQueue queue(n, 8, std::chrono::milliseconds(1));
+        const int threads = 4;
+        bool match[threads] = {};
+        std::vector<std::thread> callers;
+        for(int t = 0; t < threads; t++)
+        {
+            callers.emplace_back([&, t]
+            {
+                net::Workspace own;
+                match[t] = true;
+                for(int k = 0; k < count; k++)
+                {
+                    net::Evaluation a = queue.Evaluate(states[k], t);
+                    net::Evaluation b = n.Evaluate(states[k], t, own);
+                    match[t] = match[t] && std::abs(a.value - b.value) < 1e-4f;
+                }
+            });
+        }
+        for(std::thread& c : callers)
+        {
+            c.join();
+        }
+        for(int t = 0; t < threads; t++)
+        {
+            REQUIRE(match[t]);
+        }
+        REQUIRE(queue.GetEvaluationCount() == threads * count);
+    }
+    SECTION("Suspended PUCT Simulations")
+    {
+        net::EvaluationQueue queue(n, 8, std::chrono::microseconds(200));
+        PUCTAgent a(&queue, 40, 8, 5);
+        a.id = 1;
+        for(int k = 0; k < count; k++)
+        {
+            strategy::MoveMask legal[AGENT_COUNT];
+            strategy::LegalMoves(states[k], legal);
+            Move m = a.act(&states[k]);
+            REQUIRE((strategy::HasMove(legal[1], m) || legal[1] == 0));
+            REQUIRE(a.nodes.size() <= 41);
+            if(!states[k].agents[1].dead)
+            {
+                // the root counts every finished simulation once
+                REQUIRE(a.nodes[0].visits == 40);
+            }
+        }
+        // several leaves were evaluated together
+        REQUIRE(queue.GetEvaluationCount() > queue.GetBatchCount());
+    }
+}
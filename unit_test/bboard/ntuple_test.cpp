@@ -0,0 +1,127 @@
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <algorithm>
+
+#include "catch.hpp"
+#include "bboard.hpp"
+#include "agents.hpp"
+#include "ntuple.hpp"
+#include "symmetry.hpp"
+
+using namespace bboard;
+using namespace agents;
+
+TEST_CASE("N-Tuple Network", "[ntuple]")
+{
+    ntuple::NTupleNetwork n;
+    auto s = std::make_unique<State>();
+    InitState(s.get(), 0, 1, 2, 3);
+
+    SECTION("Cell Encoding")
+    {
+        uint8_t cells[BOARD_SIZE * BOARD_SIZE];
+        s->PlantBomb(1, 0, 0, true);
+        ntuple::EncodeCells(*s, 0, cells);
+        REQUIRE(cells[0] == 6); // agent 0 sees itself
+        REQUIRE(cells[BOARD_SIZE - 1] == 7);
+        REQUIRE(cells[1] == 3);
+        ntuple::EncodeCells(*s, 1, cells);
+        REQUIRE(cells[0] == 7);
+        REQUIRE(cells[BOARD_SIZE - 1] == 6);
+    }
+    SECTION("Features")
+    {
+        uint32_t features[ntuple::FEATURE_COUNT];
+        n.Features(*s, 2, features);
+        for(int f = 0; f < ntuple::FEATURE_COUNT; f++)
+        {
+            REQUIRE(features[f] < n.GetWeights().size());
+        }
+        // every tuple indexes its own table
+        for(int f = 0; f < ntuple::TUPLE_COUNT; f++)
+        {
+            REQUIRE(features[f] / ntuple::TUPLE_ENTRIES == uint32_t(f));
+        }
+        REQUIRE(n.Evaluate(*s, 2) == 0);
+
+        n.GetWeights()[features[5]] = 0.5f;
+        REQUIRE(n.Evaluate(*s, 2) == Approx(std::tanh(0.5f)));
+        REQUIRE(n.Value(features) == n.Evaluate(*s, 2));
+    }
+    SECTION("Save And Load")
+    {
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<float> dist(-0.1f, 0.1f);
+        for(float& w : n.GetWeights()) w = dist(rng);
+
+        const std::string path = "ntuple_test_weights.bin";
+        REQUIRE(n.Save(path));
+        ntuple::NTupleNetwork m;
+        REQUIRE(m.Load(path));
+        REQUIRE(m.GetWeights() == n.GetWeights());
+
+        // truncated
+        {
+            std::ofstream f(path, std::ios::binary | std::ios::trunc);
+            f << "NTUP";
+        }
+        REQUIRE(!m.Load(path));
+        std::remove(path.c_str());
+        REQUIRE(!m.Load("does_not_exist.bin"));
+        REQUIRE(m.GetWeights() == n.GetWeights());
+    }
+    SECTION("Self-Play Training")
+    {
+        ntuple::TrainingConfig c;
+        c.rounds = 2;
+        c.games = 4;
+        c.maxSteps = 60;
+        c.seed = 3;
+
+        ntuple::NTupleNetwork a, b, t;
+        ntuple::TrainingStats sa = ntuple::TrainSelfPlay(a, c);
+        ntuple::TrainSelfPlay(b, c);
+        REQUIRE(sa.games == 8);
+        REQUIRE(sa.steps > 0);
+        REQUIRE(sa.updates >= sa.steps);
+        REQUIRE(a.GetWeights() == b.GetWeights());
+        REQUIRE(a.GetWeights() != n.GetWeights());
+
+        // more threads only change the rounding
+        c.threads = 3;
+        ntuple::TrainingStats st = ntuple::TrainSelfPlay(t, c);
+        REQUIRE(st.steps == sa.steps);
+        float maxDiff = 0;
+        for(size_t k = 0; k < a.GetWeights().size(); k++)
+        {
+            maxDiff = std::max(maxDiff, std::abs(t.GetWeights()[k] - a.GetWeights()[k]));
+        }
+        REQUIRE(maxDiff < 1e-6f);
+    }
+    SECTION("Symmetry Augmentation")
+    {
+        ntuple::TrainingConfig c;
+        c.rounds = 1;
+        c.games = 2;
+        c.maxSteps = 40;
+        c.seed = 5;
+
+        // the weights are fixed during a round, so both play the same games
+        ntuple::NTupleNetwork a, b;
+        ntuple::TrainingStats sa = ntuple::TrainSelfPlay(a, c);
+        c.symmetries = true;
+        ntuple::TrainingStats sb = ntuple::TrainSelfPlay(b, c);
+        REQUIRE(sb.steps == sa.steps);
+        REQUIRE(sb.updates == SYMMETRY_COUNT * sa.updates);
+        REQUIRE(a.GetWeights() != b.GetWeights());
+    }
+    SECTION("Agent Plays Legal Moves")
+    {
+        NTupleAgent a(&n);
+        a.id = 3;
+        strategy::MoveMask legal[AGENT_COUNT];
+        strategy::LegalMoves(*s, legal);
+        REQUIRE(strategy::HasMove(legal[3], a.act(s.get())));
+    }
+}
@@ -1,16 +1,30 @@
 #include <cmath>
+#include <algorithm>
 #include <thread>
 #include <future>
 #include <chrono>
+#include <random>
+#include <vector>
 #include <utility>
+#include <tuple>
 #include <iostream>
 
 #include "catch.hpp"
 #include "testing_utilities.hpp"
 
 #include "bboard.hpp"
+#include "step_lanes.hpp"
+#include "strategy.hpp"
 #include "agents.hpp"
 #include "colors.hpp"
+#include "net.hpp"
+#include "evaluation_queue.hpp"
+#include "ntuple.hpp"
+#include "duct.hpp"
+#include "transposition.hpp"
+#include "symmetry.hpp"
+#include "snapshot.hpp"
+#include "state_pool.hpp"
 
 using bboard::FixedQueue;
 
@@ -55,6 +69,7 @@ TEST_CASE("Step Function", "[performance]")
     int times = 1000;
     double t = -1;
     int totalSteps = 0;
+    bboard::GetStepKernelCounters() = bboard::StepKernelCounters();
 
     for(int _ = 0; _ < 10; _++)
     {
@@ -108,5 +123,560 @@ TEST_CASE("Step Function", "[performance]")
               << type_name<decltype(b)>()
               << "\nTime: " << t/100.0 << "\n";
 
+    if(!THREADING)
+    {
+        // the counters are per thread
+        const bboard::StepKernelCounters& c = bboard::GetStepKernelCounters();
+        double ticks = std::max(1L, c.ticks[0] + c.ticks[1] + c.ticks[2]);
+        std::cout << "No bombs / at rest / in motion:  "
+                  << c.ticks[int(bboard::StepKernel::NO_BOMBS)] / ticks << " / "
+                  << c.ticks[int(bboard::StepKernel::BOMBS_AT_REST)] / ticks << " / "
+                  << c.ticks[int(bboard::StepKernel::BOMBS_IN_MOTION)] / ticks << "\n";
+    }
+
+    REQUIRE(1);
+}
+
+TEST_CASE("Lane Step Function", "[performance]")
+{
+    const int W = bboard::LANE_WIDTH;
+    const int times = 10000;
+
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> moveDist(0, 5);
+    std::vector<bboard::State> start(W);
+    auto lanes = std::make_unique<bboard::StateLanes<W>>();
+    for(int l = 0; l < W; l++)
+    {
+        bboard::InitBoardItems(start[l], l);
+        start[l].PutAgentsInCorners(0, 1, 2, 3);
+    }
+
+    // restart every 100 steps so that the games don't end
+    auto moves = std::make_unique<bboard::Move[][bboard::AGENT_COUNT]>(times * W);
+    for(int k = 0; k < times * W; k++)
+    {
+        for(int i = 0; i < bboard::AGENT_COUNT; i++)
+        {
+            moves[k][i] = bboard::Move(moveDist(rng));
+        }
+    }
+
+    int fallbacks = 0;
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for(int t = 0; t < times; t++)
+    {
+        if(t % 100 == 0)
+        {
+            for(int l = 0; l < W; l++) lanes->Load(l, start[l]);
+        }
+        fallbacks += bboard::StepLanesKernel<W>(*lanes.get(), &moves[t * W]);
+    }
+    auto t1 = std::chrono::high_resolution_clock::now();
+    for(int t = 0; t < times; t++)
+    {
+        if(t % 100 == 0)
+        {
+            for(int l = 0; l < W; l++) lanes->Load(l, start[l]);
+        }
+        bboard::StepLanes<W>(*lanes.get(), &moves[t * W]);
+    }
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    std::vector<bboard::State> states(W);
+    for(int t = 0; t < times; t++)
+    {
+        if(t % 100 == 0)
+        {
+            states = start;
+        }
+        for(int l = 0; l < W; l++)
+        {
+            bboard::Step(&states[l], moves[t * W + l]);
+        }
+    }
+    auto t3 = std::chrono::high_resolution_clock::now();
+
+    std::chrono::duration<double, std::milli> kernel = t1 - t0, lane = t2 - t1, scalar = t3 - t2;
+    std::cout << std::endl
+              << FGRN(std::string("Test Results:\n"))
+              << "Lanes:                           " << W
+              << (bboard::LanesVectorized(W) ? " (vectorized)" : " (plain loops)") << std::endl
+              << "Kernel steps (ms):               " << kernel.count() << std::endl
+              << "Lane steps (ms):                 " << lane.count() << std::endl
+              << "Scalar steps (ms):               " << scalar.count() << std::endl
+              << "Scalar fallbacks:                " << double(fallbacks) / (times * W) << std::endl;
+
+    REQUIRE(1);
+}
+
+TEST_CASE("RMap Function", "[performance]")
+{
+    const int times = 100000;
+    auto s = std::make_unique<bboard::State>();
+    bboard::InitState(s.get(), 0, 1, 2, 3);
+    bboard::strategy::RMap r;
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+    for(int k = 0; k < times; k++)
+    {
+        bboard::strategy::FillRMap(*s.get(), r, k % bboard::AGENT_COUNT);
+    }
+    std::chrono::duration<double, std::milli> total = std::chrono::high_resolution_clock::now() - t1;
+
+    std::cout << std::endl
+              << FGRN(std::string("Test Results:\n"))
+              << "FillRMap calls (100ms):          ";
+    RecursiveCommas(std::cout, uint(std::floor(times / (total.count() / 100.0))));
+    std::cout << std::endl;
+
+    REQUIRE(1);
+}
+
+namespace
+{
+
+template<int S, int N>
+void PrintShapeSteps(int times)
+{
+    std::mt19937 rng(S);
+    std::uniform_int_distribution<int> moveDist(0, 5);
+    auto start = std::make_unique<bboard::BasicState<S, N>>();
+    auto s = std::make_unique<bboard::BasicState<S, N>>();
+    bboard::InitState(start.get(), 0, 1, 2, 3);
+
+    auto moves = std::make_unique<bboard::Move[][N]>(times);
+    for(int k = 0; k < times; k++)
+    {
+        for(int i = 0; i < N; i++)
+        {
+            moves[k][i] = bboard::Move(moveDist(rng));
+        }
+    }
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+    for(int k = 0; k < times; k++)
+    {
+        // restart every 100 steps so that the games don't end
+        if(k % 100 == 0)
+        {
+            *s.get() = *start.get();
+        }
+        bboard::Step(s.get(), moves[k]);
+    }
+    std::chrono::duration<double, std::milli> total = std::chrono::high_resolution_clock::now() - t1;
+
+    std::string shape = std::to_string(S) + "x" + std::to_string(S) + ", "
+            + std::to_string(N) + " agents (100ms):";
+    std::cout << shape << std::string(33 - shape.size(), ' ');
+    RecursiveCommas(std::cout, uint(std::floor(times / (total.count() / 100.0))));
+    std::cout << std::endl;
+}
+
+}
+
+TEST_CASE("Game Shape Scaling", "[performance]")
+{
+    std::cout << std::endl
+              << FGRN(std::string("Test Results:\n"));
+    PrintShapeSteps<8, 2>(100000);
+    PrintShapeSteps<bboard::BOARD_SIZE, bboard::AGENT_COUNT>(100000);
+    PrintShapeSteps<21, 4>(100000);
+    PrintShapeSteps<21, 16>(100000);
+
+    REQUIRE(1);
+}
+
+TEST_CASE("Net Evaluation", "[performance]")
+{
+    const int batch = 16;
+    const int rounds = 20;
+    agents::net::Network n;
+    agents::net::Workspace ws;
+    n.Init(32, 3, 2, 1);
+
+    auto states = std::make_unique<bboard::State[]>(batch);
+    const bboard::State* ptrs[batch];
+    int ids[batch];
+    agents::net::Evaluation out[batch];
+    for(int k = 0; k < batch; k++)
+    {
+        bboard::InitState(&states[k], k, 1, 2, 3);
+        ptrs[k] = &states[k];
+        ids[k] = k % bboard::AGENT_COUNT;
+    }
+
+    std::cout << std::endl
+              << FGRN(std::string("Test Results:\n"));
+    for(agents::net::Precision p : {agents::net::Precision::FP32, agents::net::Precision::INT8})
+    {
+        auto t1 = std::chrono::high_resolution_clock::now();
+        for(int r = 0; r < rounds; r++)
+        {
+            n.Evaluate(ptrs, ids, batch, out, ws, p);
+        }
+        std::chrono::duration<double, std::milli> total = std::chrono::high_resolution_clock::now() - t1;
+
+        std::cout << (p == agents::net::Precision::FP32 ? "FP32" : "INT8")
+                  << " evaluations (100ms):        ";
+        RecursiveCommas(std::cout, uint(std::floor(batch * rounds / (total.count() / 100.0))));
+        std::cout << std::endl;
+    }
+
+    REQUIRE(1);
+}
+
+TEST_CASE("Batched Leaf Evaluation", "[performance]")
+{
+    const int decisions = 20;
+    agents::net::Network n;
+    n.Init(32, 3, 2, 1);
+    auto s = std::make_unique<bboard::State>();
+    bboard::InitState(s.get(), 0, 1, 2, 3);
+
+    std::cout << std::endl
+              << FGRN(std::string("Test Results:\n"));
+    // (batch size, suspended simulations per search, searches)
+    for(auto [batch, parallel, searches] : {std::tuple<int, int, int>(1, 1, 1), {8, 8, 1}, {16, 4, 4}})
+    {
+        agents::net::EvaluationQueue queue(n, batch, std::chrono::microseconds(200));
+        auto t1 = std::chrono::high_resolution_clock::now();
+        std::vector<std::thread> threads;
+        for(int k = 0; k < searches; k++)
+        {
+            threads.emplace_back([&queue, &s, parallel = parallel, k]
+            {
+                agents::PUCTAgent a(&queue, 64, parallel, k);
+                a.id = k % bboard::AGENT_COUNT;
+                for(int d = 0; d < decisions; d++) a.act(s.get());
+            });
+        }
+        for(std::thread& t : threads) t.join();
+        std::chrono::duration<double, std::milli> total = std::chrono::high_resolution_clock::now() - t1;
+
+        std::cout << "Batch " << batch << ", " << searches << " search(es) (100ms):  ";
+        RecursiveCommas(std::cout, uint(std::floor(queue.GetEvaluationCount() / (total.count() / 100.0))));
+        std::cout << " leaves, " << double(queue.GetEvaluationCount()) / queue.GetBatchCount()
+                  << " per batch" << std::endl;
+    }
+
+    REQUIRE(1);
+}
+
+TEST_CASE("N-Tuple Evaluation", "[performance]")
+{
+    const int times = 100000;
+    agents::ntuple::NTupleNetwork n;
+    auto s = std::make_unique<bboard::State>();
+    bboard::InitState(s.get(), 0, 1, 2, 3);
+
+    float sum = 0;
+    auto t1 = std::chrono::high_resolution_clock::now();
+    for(int k = 0; k < times; k++)
+    {
+        sum += n.Evaluate(*s.get(), k % bboard::AGENT_COUNT);
+    }
+    std::chrono::duration<double, std::milli> eval = std::chrono::high_resolution_clock::now() - t1;
+
+    agents::ntuple::TrainingConfig c;
+    c.rounds = 1;
+    c.games = 4;
+    c.threads = THREAD_COUNT;
+    t1 = std::chrono::high_resolution_clock::now();
+    agents::ntuple::TrainingStats stats = agents::ntuple::TrainSelfPlay(n, c);
+    std::chrono::duration<double, std::milli> train = std::chrono::high_resolution_clock::now() - t1;
+
+    std::cout << std::endl
+              << FGRN(std::string("Test Results:\n"))
+              << "N-tuple evaluations (100ms):     ";
+    RecursiveCommas(std::cout, uint(std::floor(times / (eval.count() / 100.0))));
+    std::cout << std::endl
+              << "Self-play steps (100ms):         ";
+    RecursiveCommas(std::cout, uint(std::floor(stats.steps / (train.count() / 100.0))));
+    std::cout << std::endl;
+
+    REQUIRE(sum == 0);
+}
+
+TEST_CASE("RHEA Planning", "[performance]")
+{
+    const int games = 4;
+    const int threads[2] = {1, int(THREAD_COUNT)};
+
+    std::cout << std::endl
+              << FGRN(std::string("Test Results:\n"));
+    for(int k = 0; k < (THREAD_COUNT > 1 ? 2 : 1); k++)
+    {
+        int wins = 0, draws = 0;
+        long evaluations = 0;
+        std::chrono::duration<double, std::milli> total(0);
+        for(int g = 0; g < games; g++)
+        {
+            agents::RHEAAgent r(12, 10, threads[k], g);
+            r.budget = 5;
+            agents::SimpleAgent s[3];
+            bboard::Environment env;
+            env.MakeGame({&r, &s[0], &s[1], &s[2]}, true);
+
+            auto t1 = std::chrono::high_resolution_clock::now();
+            for(int t = 0; t < 800 && !env.IsDone(); t++)
+            {
+                env.Step();
+            }
+            total += std::chrono::high_resolution_clock::now() - t1;
+            evaluations += r.evaluations;
+            wins += env.IsDone() && env.GetWinner() == r.id;
+            draws += !env.IsDone() || env.IsDraw();
+        }
+
+        std::cout << "RHEA threads:                    " << threads[k] << std::endl
+                  << "Rollouts (100ms):                ";
+        RecursiveCommas(std::cout, uint(std::floor(evaluations / (total.count() / 100.0))));
+        std::cout << std::endl
+                  << "Wins / draws vs 3 SimpleAgents:  " << wins << " / " << draws
+                  << " of " << games << std::endl;
+    }
+
+    REQUIRE(1);
+}
+
+TEST_CASE("Decoupled UCT Search", "[performance]")
+{
+    const int iterations = 20000;
+    auto s = std::make_unique<bboard::State>();
+    bboard::InitState(s.get(), 0, 1, 2, 3);
+
+    std::cout << std::endl
+              << FGRN(std::string("Test Results:\n"));
+    for(auto sel : {bboard::search::Selection::UCT, bboard::search::Selection::EXP3})
+    {
+        bboard::search::DecoupledUCT d(iterations + 1, 0);
+        d.selection = sel;
+        auto t1 = std::chrono::high_resolution_clock::now();
+        d.Search(*s.get(), iterations);
+        std::chrono::duration<double, std::milli> total = std::chrono::high_resolution_clock::now() - t1;
+
+        std::cout << (sel == bboard::search::Selection::UCT ? "UCT" : "EXP3") << std::endl
+                  << "Simulations (100ms):             ";
+        RecursiveCommas(std::cout, uint(std::floor(iterations / (total.count() / 100.0))));
+        std::cout << std::endl
+                  << "Nodes (100ms):                   ";
+        RecursiveCommas(std::cout, uint(std::floor(d.GetNodeCount() / (total.count() / 100.0))));
+        std::cout << std::endl
+                  << "Bytes per node (arena + table):  " << d.GetMemoryUsage() / (iterations + 1)
+                  << " (a state: " << sizeof(bboard::State) << ")" << std::endl;
+    }
+
+    REQUIRE(1);
+}
+
+TEST_CASE("Transposition Table Access", "[performance]")
+{
+    const int times = 2000000;
+    bboard::search::TranspositionTable t(256);
+
+    auto work = [&t](int w)
+    {
+        uint64_t x = 0x9E3779B97F4A7C15ULL + w;
+        bboard::search::TTData d;
+        for(int k = 0; k < times; k++)
+        {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            if(!t.Probe(x & 0xFFFFFFFFFFFULL, d))
+            {
+                t.Store(x & 0xFFFFFFFFFFFULL, d);
+            }
+        }
+    };
+    auto t1 = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> workers;
+    for(uint w = 0; w < THREAD_COUNT; w++)
+    {
+        workers.emplace_back(work, w);
+    }
+    for(std::thread& w : workers)
+    {
+        w.join();
+    }
+    std::chrono::duration<double, std::milli> total = std::chrono::high_resolution_clock::now() - t1;
+
+    // successive searches of a game share the table
+    auto s = std::make_unique<bboard::State>();
+    bboard::InitState(s.get(), 0, 1, 2, 3);
+    bboard::search::TranspositionTable shared(64);
+    bboard::search::DecoupledUCT d(1 << 14, 0);
+    d.transpositions = &shared;
+    std::chrono::duration<double, std::milli> search(0);
+    for(int k = 0; k < 20; k++)
+    {
+        shared.NewGeneration();
+        auto t2 = std::chrono::high_resolution_clock::now();
+        d.Search(*s.get(), 2000);
+        search += std::chrono::high_resolution_clock::now() - t2;
+        bboard::Move moves[bboard::AGENT_COUNT];
+        for(int i = 0; i < bboard::AGENT_COUNT; i++)
+        {
+            moves[i] = d.BestMove(i);
+        }
+        bboard::Step(s.get(), moves);
+    }
+    bboard::search::TTCounters c = shared.GetCounters();
+
+    std::cout << std::endl
+              << FGRN(std::string("Test Results:\n"))
+              << "Threads:                         " << THREAD_COUNT << std::endl
+              << "Huge pages:                      " << (t.IsHugePageBacked() ? "yes" : "no") << std::endl
+              << "Probes (100ms):                  ";
+    RecursiveCommas(std::cout, uint(std::floor(THREAD_COUNT * double(times) / (total.count() / 100.0))));
+    std::cout << std::endl
+              << "DUCT simulations (100ms):        ";
+    RecursiveCommas(std::cout, uint(std::floor(20 * 2000 / (search.count() / 100.0))));
+    std::cout << std::endl
+              << "DUCT hit rate:                   " << c.HitRate() << std::endl
+              << "DUCT collisions:                 " << c.collisions << std::endl;
+
+    REQUIRE(1);
+}
+
+TEST_CASE("Symmetry Transforms", "[performance]")
+{
+    const int times = 200000;
+    auto s = std::make_unique<bboard::State>();
+    auto t = std::make_unique<bboard::State>();
+    bboard::InitState(s.get(), 0, 1, 2, 3);
+    bboard::Move m[bboard::AGENT_COUNT] = {bboard::Move::BOMB, bboard::Move::RIGHT,
+                                           bboard::Move::DOWN, bboard::Move::IDLE};
+    bboard::Step(s.get(), m);
+
+    uint64_t sum = 0;
+    double transform = timeMethod(times, [&]()
+    {
+        bboard::TransformState(*s.get(), *t.get(), 5);
+    });
+    double hash = timeMethod(times, [&]()
+    {
+        sum += bboard::HashState(*s.get());
+    });
+    double canonical = timeMethod(times, [&]()
+    {
+        sum += bboard::CanonicalHash(*s.get());
+    });
+
+    std::cout << std::endl
+              << FGRN(std::string("Test Results:\n"))
+              << "Transforms (100ms):              ";
+    RecursiveCommas(std::cout, uint(std::floor(times / (transform / 100.0))));
+    std::cout << std::endl
+              << "Hashes (100ms):                  ";
+    RecursiveCommas(std::cout, uint(std::floor(times / (hash / 100.0))));
+    std::cout << std::endl
+              << "Canonical hashes (100ms):        ";
+    RecursiveCommas(std::cout, uint(std::floor(times / (canonical / 100.0))));
+    std::cout << std::endl;
+
+    REQUIRE(sum != 0);
+}
+
+TEST_CASE("Snapshot Deltas", "[performance]")
+{
+    const int count = 20000;
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> moveDist(0, 5);
+
+    // a tree of random joint actions, every node has up to 8 children
+    std::vector<bboard::State> states(1);
+    bboard::InitState(&states[0], 0, 1, 2, 3);
+    std::vector<int> parents(1, -1);
+    for(int k = 1; k < count; k++)
+    {
+        const int parent = (k - 1) / 8;
+        bboard::State s = states[parent];
+        bboard::Move m[bboard::AGENT_COUNT];
+        for(int i = 0; i < bboard::AGENT_COUNT; i++)
+        {
+            m[i] = bboard::Move(moveDist(rng));
+        }
+        bboard::Step(&s, m);
+        states.push_back(s);
+        parents.push_back(parent);
+    }
+
+    bboard::search::SnapshotTree tree(32);
+    tree.Reserve(count);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    tree.AddRoot(states[0]);
+    for(int k = 1; k < count; k++)
+    {
+        tree.Add(parents[k], states[parents[k]], states[k]);
+    }
+    std::chrono::duration<double, std::milli> add = std::chrono::high_resolution_clock::now() - t1;
+
+    bboard::State s;
+    double restore = timeMethod(count, [&]()
+    {
+        tree.Restore(int(rng() % count), s);
+    });
+    int at = 0;
+    tree.Restore(at, s);
+    double move = timeMethod(count, [&]()
+    {
+        // to a sibling, the usual step of a search
+        const int to = 1 + int(rng() % (count - 1));
+        tree.Move(at, to, s);
+        at = to;
+    });
+
+    std::cout << std::endl
+              << FGRN(std::string("Test Results:\n"))
+              << "Snapshots (100ms):               ";
+    RecursiveCommas(std::cout, uint(std::floor(count / (add.count() / 100.0))));
+    std::cout << std::endl
+              << "Restores (100ms):                ";
+    RecursiveCommas(std::cout, uint(std::floor(count / (restore / 100.0))));
+    std::cout << std::endl
+              << "Moves to a random node (100ms):  ";
+    RecursiveCommas(std::cout, uint(std::floor(count / (move / 100.0))));
+    std::cout << std::endl
+              << "Bytes per node:                  " << tree.GetMemoryUsage() / count
+              << " (a state: " << sizeof(bboard::State) << ")" << std::endl;
+
     REQUIRE(1);
 }
+
+TEST_CASE("State Pool Clones", "[performance]")
+{
+    const int count = 200000;
+    auto root = std::make_unique<bboard::State>();
+    bboard::InitState(root.get(), 0, 1, 2, 3);
+
+    double heap = timeMethod(count, [&]()
+    {
+        auto s = std::make_unique<bboard::State>(*root.get());
+        // keep the copy from being optimized away
+        root->timeStep += s->timeStep & 1;
+    });
+
+    bboard::search::StatePool pool;
+    double pooled = timeMethod(count, [&]()
+    {
+        bboard::State* s = pool.Clone(*root.get());
+        root->timeStep += s->timeStep & 1;
+        pool.Release(s);
+    });
+    const bboard::search::PoolCounters c = pool.GetCounters();
+
+    std::cout << std::endl
+              << FGRN(std::string("Test Results:\n"))
+              << "Heap copies (100ms):             ";
+    RecursiveCommas(std::cout, uint(std::floor(count / (heap / 100.0))));
+    std::cout << std::endl
+              << "Pool clones (100ms):             ";
+    RecursiveCommas(std::cout, uint(std::floor(count / (pooled / 100.0))));
+    std::cout << std::endl
+              << "Pool allocations / transfers:    " << c.allocations << " / " << c.transfers
+              << std::endl;
+
+    REQUIRE(c.allocations == 1);
+}
@@ -0,0 +1,98 @@
+#include "catch.hpp"
+#include "bboard.hpp"
+#include "projection.hpp"
+
+using namespace bboard;
+
+namespace
+{
+
+/**
+ * @brief REQUIRE_IDLE_EQUIVALENT Steps a copy of the given state with
+ * idle moves and compares the flames of every tick with the timeline
+ */
+void REQUIRE_IDLE_EQUIVALENT(const State& state)
+{
+    strategy::Timeline t;
+    strategy::ProjectState(state, t);
+
+    auto s = std::make_unique<State>(state);
+    Move id = Move::IDLE;
+    Move m[AGENT_COUNT] = {id, id, id, id};
+    strategy::FlameMask mask;
+
+    for(int i = 1; i <= strategy::PROJECTION_HORIZON; i++)
+    {
+        Step(s.get(), m);
+        strategy::FillFlameMask(*s.get(), mask);
+        REQUIRE(t.flames[i] == mask);
+    }
+}
+
+}
+
+TEST_CASE("Flame Projection", "[projection]")
+{
+    auto s = std::make_unique<State>();
+    s->PutAgentsInCorners(0, 1, 2, 3);
+
+    SECTION("Empty Board")
+    {
+        strategy::Timeline t;
+        strategy::ProjectState(*s.get(), t);
+
+        for(int i = 0; i <= strategy::PROJECTION_HORIZON; i++)
+        {
+            REQUIRE(t.flames[i].none());
+        }
+    }
+    SECTION("Single Bomb")
+    {
+        s->PlantBomb(5, 5, 0, true);
+        strategy::Timeline t;
+        strategy::ProjectState(*s.get(), t);
+
+        REQUIRE(t.NextFlame(5, 5) == BOMB_LIFETIME);
+        REQUIRE(t.NextFlame(6, 5) == BOMB_LIFETIME);
+        REQUIRE(t.NextFlame(7, 5) == -1);
+        REQUIRE(t.IsFlame(BOMB_LIFETIME + FLAME_LIFETIME - 1, 5, 5));
+        REQUIRE(!t.IsFlame(BOMB_LIFETIME + FLAME_LIFETIME, 5, 5));
+    }
+    SECTION("Chained Explosion")
+    {
+        // the bomb queue is sorted by lifetime
+        s->PlantBombModifiedLife(6, 5, 1, 2, true);
+        s->PlantBomb(5, 5, 0, true);
+        strategy::Timeline t;
+        strategy::ProjectState(*s.get(), t);
+
+        REQUIRE(t.NextFlame(4, 5) == 2);
+        REQUIRE(t.NextFlame(7, 5) == 2);
+        REQUIRE(t.NextFlame(5, 5, 3) == 3);
+    }
+    SECTION("Kicked Bomb")
+    {
+        s->PlantBombModifiedLife(2, 5, 0, 4, true);
+        SetBombDirection(s->bombs[0], Direction::RIGHT);
+        strategy::Timeline t;
+        strategy::ProjectState(*s.get(), t);
+
+        REQUIRE(t.NextFlame(6, 5) == 4);
+        REQUIRE(t.NextFlame(2, 5) == -1);
+    }
+    SECTION("Same As Idle Steps")
+    {
+        InitBoardItems(*s.get(), 0x1234);
+        s->PutAgentsInCorners(0, 1, 2, 3);
+        s->agents[0].bombStrength = 3;
+        s->agents[2].maxBombCount = 2;
+        s->PlantBombModifiedLife(6, 6, 2, 3, true);
+        s->PlantBombModifiedLife(4, 7, 1, 6, true);
+        s->PlantBombModifiedLife(6, 2, 2, 8, true);
+        s->PlantBomb(3, 4, 0, true);
+        SetBombDirection(s->bombs[2], Direction::DOWN);
+        s->SpawnFlame(8, 8, 2);
+
+        REQUIRE_IDLE_EQUIVALENT(*s.get());
+    }
+}
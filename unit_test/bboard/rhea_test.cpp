@@ -0,0 +1,70 @@
+#include <chrono>
+
+#include "catch.hpp"
+#include "bboard.hpp"
+#include "agents.hpp"
+#include "testing_utilities.hpp"
+
+using namespace bboard;
+using namespace agents;
+
+TEST_CASE("RHEA Agent", "[rhea]")
+{
+    auto s = std::make_unique<State>();
+    Move m[AGENT_COUNT] = {Move::IDLE, Move::IDLE, Move::IDLE, Move::IDLE};
+
+    SECTION("Escapes Its Own Bomb")
+    {
+        PrepareDeadEnd(*s.get());
+
+        RHEAAgent a(6, 10, 1, 1);
+        a.id = 0;
+        a.maxGenerations = 20;
+        a.budget = 1e9;
+        for(int t = 0; t < 6; t++)
+        {
+            m[0] = a.act(s.get());
+            Step(s.get(), m);
+        }
+        REQUIRE(!s->agents[0].dead);
+        REQUIRE(a.generations == 20);
+    }
+    SECTION("Threads Don't Change The Result")
+    {
+        InitState(s.get(), 0, 1, 2, 3);
+        RHEAAgent single(8, 12, 1, 7);
+        RHEAAgent threaded(8, 12, 3, 7);
+        for(RHEAAgent* a : {&single, &threaded})
+        {
+            a->id = 2;
+            a->maxGenerations = 5;
+            a->budget = 1e9;
+        }
+
+        std::mt19937 rng(3);
+        std::uniform_int_distribution<int> moveDist(0, 5);
+        for(int t = 0; t < 30 && !s->agents[2].dead; t++)
+        {
+            Move a = single.act(s.get());
+            REQUIRE(threaded.act(s.get()) == a);
+            for(int i = 0; i < AGENT_COUNT; i++) m[i] = Move(moveDist(rng));
+            m[2] = a;
+            Step(s.get(), m);
+        }
+        REQUIRE(single.evaluations == threaded.evaluations);
+        REQUIRE(single.evaluations > 0);
+    }
+    SECTION("Time Budget")
+    {
+        InitState(s.get(), 0, 1, 2, 3);
+        RHEAAgent a(10, 10, 1, 2);
+        a.id = 1;
+        a.budget = 5;
+        auto t1 = std::chrono::steady_clock::now();
+        a.act(s.get());
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - t1;
+        REQUIRE(a.generations >= 1);
+        // a single generation overshoots the budget by little
+        REQUIRE(elapsed.count() < 200);
+    }
+}
@@ -0,0 +1,89 @@
+#include <random>
+#include <vector>
+#include <cstring>
+
+#include "catch.hpp"
+#include "bboard.hpp"
+#include "snapshot.hpp"
+
+using namespace bboard;
+
+namespace
+{
+
+/**
+ * @brief GrowTree Adds children with random moves to random nodes and
+ * keeps a full copy of every state to compare with
+ */
+void GrowTree(search::SnapshotTree& tree, std::vector<State>& full, int count, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> moveDist(0, 5);
+
+    full.resize(1);
+    InitBoardItems(full[0], int(seed));
+    full[0].PutAgentsInCorners(0, 1, 2, 3);
+    tree.AddRoot(full[0]);
+
+    for(int k = 1; k < count; k++)
+    {
+        // prefer deep nodes, so the tree gets long paths
+        const int parent = std::max(0, int(full.size()) - 1 - int(rng() % 8));
+        State s = full[parent];
+        Move m[AGENT_COUNT];
+        for(int i = 0; i < AGENT_COUNT; i++)
+        {
+            m[i] = Move(moveDist(rng));
+        }
+        Step(&s, m);
+        REQUIRE(tree.Add(parent, full[parent], s) == k);
+        full.push_back(s);
+    }
+}
+
+}
+
+TEST_CASE("Snapshot Tree", "[snapshot]")
+{
+    std::vector<State> full;
+    auto s = std::make_unique<State>();
+
+    SECTION("Restore")
+    {
+        for(int interval : {1, 4, 32})
+        {
+            search::SnapshotTree tree(interval);
+            GrowTree(tree, full, 300, 7);
+            REQUIRE(tree.GetCount() == 300);
+            for(int n = 0; n < tree.GetCount(); n++)
+            {
+                tree.Restore(n, *s.get());
+                // the rebuild is exact, down to the raw queue slots
+                REQUIRE(std::memcmp(s.get(), &full[n], sizeof(State)) == 0);
+            }
+        }
+    }
+    SECTION("Move Along The Tree")
+    {
+        search::SnapshotTree tree(8);
+        GrowTree(tree, full, 300, 11);
+        std::mt19937 rng(3);
+        int at = 0;
+        *s.get() = full[0];
+        for(int k = 0; k < 500; k++)
+        {
+            const int to = int(rng() % tree.GetCount());
+            tree.Move(at, to, *s.get());
+            REQUIRE(std::memcmp(s.get(), &full[to], sizeof(State)) == 0);
+            at = to;
+        }
+    }
+    SECTION("Deltas Are Small")
+    {
+        search::SnapshotTree tree(32);
+        GrowTree(tree, full, 2000, 5);
+        REQUIRE(tree.GetDepth(tree.GetCount() - 1) > 32);
+        // most of a state doesn't change in a step
+        REQUIRE(tree.GetMemoryUsage() * 8 < full.size() * sizeof(State));
+    }
+}
@@ -0,0 +1,113 @@
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#include "catch.hpp"
+#include "bboard.hpp"
+#include "state_pool.hpp"
+
+using namespace bboard;
+using search::StatePool;
+
+TEST_CASE("State Pool", "[search]")
+{
+    auto root = std::make_unique<State>();
+    InitState(root.get(), 0, 1, 2, 3);
+
+    SECTION("Clone")
+    {
+        StatePool pool(64);
+        State* s = pool.Clone(*root.get());
+        REQUIRE(std::memcmp(s, root.get(), sizeof(State)) == 0);
+        REQUIRE(reinterpret_cast<uintptr_t>(s) % 64 == 0);
+        pool.Release(s);
+
+        const search::PoolCounters c = pool.GetCounters();
+        REQUIRE(c.acquires == 1);
+        REQUIRE(c.clones == 1);
+        REQUIRE(c.releases == 1);
+        REQUIRE(c.allocations == 1);
+    }
+    SECTION("Released States Are Reused")
+    {
+        StatePool pool(64);
+        for(int k = 0; k < 10000; k++)
+        {
+            State* a = pool.Acquire();
+            State* b = pool.Clone(*a);
+            pool.Release(a);
+            pool.Release(b);
+        }
+        REQUIRE(pool.GetCounters().allocations == 1);
+        REQUIRE(pool.GetCapacity() == 64);
+    }
+    SECTION("Grows And Resets")
+    {
+        StatePool pool(20);
+        std::vector<State*> held;
+        for(int k = 0; k < 50; k++)
+        {
+            held.push_back(pool.Acquire());
+        }
+        REQUIRE(pool.GetCapacity() >= 50);
+        const uint64_t allocations = pool.GetCounters().allocations;
+        REQUIRE(allocations > 1);
+
+        // all states are distinct
+        std::sort(held.begin(), held.end());
+        REQUIRE(std::unique(held.begin(), held.end()) == held.end());
+
+        // nothing is released, but a reset frees all of them
+        pool.Reset();
+        for(int k = 0; k < 50; k++)
+        {
+            pool.Acquire();
+        }
+        REQUIRE(pool.GetCounters().allocations == allocations);
+    }
+    SECTION("Concurrent Threads")
+    {
+        StatePool pool(32);
+        const int threads = 4, rounds = 20000;
+        std::vector<int> wrong(threads, 0);
+        std::vector<std::thread> workers;
+        for(int w = 0; w < threads; w++)
+        {
+            workers.emplace_back([&, w]
+            {
+                State* s[3];
+                for(int k = 0; k < rounds; k++)
+                {
+                    for(State*& p : s)
+                    {
+                        p = pool.Clone(*root.get());
+                        p->timeStep = w;
+                    }
+                    for(State* p : s)
+                    {
+                        // nobody else wrote to the state
+                        wrong[w] += p->timeStep != w;
+                        pool.Release(p);
+                    }
+                }
+            });
+        }
+        for(std::thread& t : workers)
+        {
+            t.join();
+        }
+        for(int w = 0; w < threads; w++)
+        {
+            REQUIRE(wrong[w] == 0);
+        }
+
+        const search::PoolCounters c = pool.GetCounters();
+        REQUIRE(c.acquires == uint64_t(threads * rounds * 3));
+        REQUIRE(c.releases == c.acquires);
+        REQUIRE(c.clones == c.acquires);
+        // the pool only grows by what the free lists of the threads hold
+        REQUIRE(pool.GetCapacity() <= threads * (2 * StatePool::BATCH + 3) + StatePool::BATCH + 32);
+    }
+}
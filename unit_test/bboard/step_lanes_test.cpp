@@ -0,0 +1,142 @@
+#include <random>
+#include <vector>
+
+#include "catch.hpp"
+#include "bboard.hpp"
+#include "step_lanes.hpp"
+
+using namespace bboard;
+
+namespace
+{
+
+/**
+ * @brief IdenticalStates Compares every field of both states,
+ * including the unused slots of the bomb and flame queues
+ */
+bool IdenticalStates(const State& a, const State& b)
+{
+    for(int y = 0; y < BOARD_SIZE; y++)
+    {
+        for(int x = 0; x < BOARD_SIZE; x++)
+        {
+            if(a.board[y][x] != b.board[y][x]) return false;
+        }
+    }
+    for(int i = 0; i < AGENT_COUNT; i++)
+    {
+        const AgentInfo& p = a.agents[i];
+        const AgentInfo& q = b.agents[i];
+        if(p.x != q.x || p.y != q.y || p.dead != q.dead || p.canKick != q.canKick
+                || p.bombCount != q.bombCount || p.maxBombCount != q.maxBombCount
+                || p.bombStrength != q.bombStrength)
+        {
+            return false;
+        }
+    }
+    for(int k = 0; k < MAX_BOMBS; k++)
+    {
+        const Flame& f = a.flames.queue[k];
+        const Flame& g = b.flames.queue[k];
+        if(a.bombs.queue[k] != b.bombs.queue[k] || !(f.position == g.position)
+                || f.timeLeft != g.timeLeft || f.strength != g.strength || f.owner != g.owner)
+        {
+            return false;
+        }
+    }
+    return a.bombs.index == b.bombs.index && a.bombs.count == b.bombs.count
+            && a.flames.index == b.flames.index && a.flames.count == b.flames.count
+            && a.timeStep == b.timeStep && a.aliveAgents == b.aliveAgents;
+}
+
+/**
+ * @brief TestLaneEquivalence Plays random games in all lanes and
+ * compares every lane with bboard::Step after every step
+ * @param stepLanes StepLanes or StepLanesKernel
+ * @return The fraction of lanes that were stepped by bboard::Step
+ */
+template<int W>
+double TestLaneEquivalence(int steps, int (*stepLanes)(StateLanes<W>&, const Move[W][AGENT_COUNT]))
+{
+    std::mt19937 rng(W);
+    std::uniform_int_distribution<int> moveDist(0, 5);
+
+    auto lanes = std::make_unique<StateLanes<W>>();
+    std::vector<State> reference(W);
+    auto state = std::make_unique<State>();
+
+    auto newGame = [&](int l)
+    {
+        reference[l] = State();
+        InitBoardItems(reference[l], int(rng()));
+        reference[l].PutAgentsInCorners(0, 1, 2, 3);
+        lanes->Load(l, reference[l]);
+    };
+    for(int l = 0; l < W; l++)
+    {
+        newGame(l);
+    }
+
+    int fallbacks = 0;
+    Move moves[W][AGENT_COUNT];
+    for(int t = 0; t < steps; t++)
+    {
+        for(int l = 0; l < W; l++)
+        {
+            for(int i = 0; i < AGENT_COUNT; i++)
+            {
+                moves[l][i] = Move(moveDist(rng));
+            }
+        }
+
+        fallbacks += stepLanes(*lanes.get(), moves);
+
+        for(int l = 0; l < W; l++)
+        {
+            Step(&reference[l], moves[l]);
+            lanes->Store(l, *state.get());
+            REQUIRE(IdenticalStates(*state.get(), reference[l]));
+
+            if(reference[l].aliveAgents <= 1 || t % 200 == 199)
+            {
+                newGame(l);
+            }
+        }
+    }
+    return double(fallbacks) / (steps * W);
+}
+
+}
+
+TEST_CASE("Lane Step Equivalence", "[step function]")
+{
+    // the kernel steps about a third of the lanes of these games (up to
+    // 200 random steps) with bboard::Step, StepLanes steps all of them
+    // without vector instructions
+    SECTION("8 Lanes")
+    {
+        REQUIRE(TestLaneEquivalence<8>(1000, StepLanesKernel<8>) < 0.4);
+        const double fallbacks = TestLaneEquivalence<8>(1000, StepLanes<8>);
+        REQUIRE((LanesVectorized(8) ? fallbacks < 0.4 : fallbacks == 1.0));
+    }
+    SECTION("16 Lanes")
+    {
+        REQUIRE(TestLaneEquivalence<16>(1000, StepLanesKernel<16>) < 0.4);
+        const double fallbacks = TestLaneEquivalence<16>(1000, StepLanes<16>);
+        REQUIRE((LanesVectorized(16) ? fallbacks < 0.4 : fallbacks == 1.0));
+    }
+    SECTION("Load And Store")
+    {
+        auto lanes = std::make_unique<StateLanes<8>>();
+        auto s = std::make_unique<State>();
+        auto t = std::make_unique<State>();
+        InitState(s.get(), 0, 1, 2, 3);
+        s->PlantBomb(1, 0, 0, true);
+        s->SpawnFlame(5, 5, 2, 1);
+        s->Kill(3);
+
+        lanes->Load(5, *s.get());
+        lanes->Store(5, *t.get());
+        REQUIRE(IdenticalStates(*s.get(), *t.get()));
+    }
+}
@@ -1,3 +1,5 @@
+#include <random>
+#include <memory>
 #include <iostream>
 
 #include "catch.hpp"
@@ -171,3 +173,133 @@ TEST_CASE("Dependency Resolving", "[step utilities]")
         REQUIRE_ROOTS(chain, 0, 1);
     }
 }
+
+/**
+ * @brief CompareResolvers Puts the agents (some of them dead) on random
+ * cells of a small area, so that they block and swap with each other a
+ * lot, and requires that the cell table produces the same results as
+ * the pairwise comparisons
+ */
+template<int S, int N>
+void CompareResolvers(int area, int iterations)
+{
+    std::mt19937 rng(N);
+    std::uniform_int_distribution<int> cellDist(0, area * area - 1);
+    std::uniform_int_distribution<int> moveDist(0, 5);
+    auto s = std::make_unique<bboard::BasicState<S, N>>();
+
+    for(int it = 0; it < iterations; it++)
+    {
+        *s.get() = bboard::BasicState<S, N>();
+        bboard::Move m[N];
+        for(int i = 0; i < N; i++)
+        {
+            int c = cellDist(rng);
+            // alive agents get distinct cells
+            while(s->board[c / area][c % area] >= bboard::Item::AGENT0)
+            {
+                c = cellDist(rng);
+            }
+            s->PutAgent(c % area, c / area, i);
+            m[i] = bboard::Move(moveDist(rng));
+            if(rng() % 5 == 0)
+            {
+                s->Kill(i);
+                s->board[c / area][c % area] = bboard::Item::PASSAGE;
+            }
+        }
+
+        bboard::Position des[2][N];
+        int dependency[2][N], chain[2][N], roots[2];
+        bool collision[2][N];
+        for(int k = 0; k < 2; k++)
+        {
+            std::fill_n(dependency[k], N, -1);
+            std::fill_n(chain[k], N, -1);
+            bboard::util::FillDestPos(s.get(), m, des[k]);
+            roots[k] = bboard::util::ResolveMovement(s.get(), des[k], dependency[k],
+                                                     chain[k], collision[k], k == 1);
+        }
+
+        REQUIRE(roots[0] == roots[1]);
+        for(int i = 0; i < N; i++)
+        {
+            REQUIRE(des[0][i] == des[1][i]);
+            REQUIRE(dependency[0][i] == dependency[1][i]);
+            REQUIRE(chain[0][i] == chain[1][i]);
+            REQUIRE(collision[0][i] == collision[1][i]);
+        }
+    }
+}
+
+TEST_CASE("Movement Resolver", "[step utilities]")
+{
+    SECTION("Four Agents")
+    {
+        CompareResolvers<bboard::BOARD_SIZE, bboard::AGENT_COUNT>(3, 5000);
+    }
+    SECTION("Sixteen Agents")
+    {
+        CompareResolvers<21, 16>(5, 5000);
+    }
+    SECTION("Long Chain")
+    {
+        auto s = std::make_unique<bboard::BasicState<21, 16>>();
+        bboard::Move m[16];
+        for(int i = 0; i < 16; i++)
+        {
+            s->PutAgent(i, 3, i);
+            m[i] = bboard::Move::RIGHT;
+        }
+
+        bboard::Step(s.get(), m);
+        for(int i = 0; i < 16; i++)
+        {
+            REQUIRE(s->agents[i].x == i + 1);
+            REQUIRE(s->board[3][i + 1] == bboard::Item::AGENT0 + i);
+        }
+        REQUIRE(s->board[3][0] == bboard::Item::PASSAGE);
+    }
+}
+
+TEST_CASE("Bomb Chain Reversion", "[step utilities]")
+{
+    auto s = std::make_unique<bboard::State>();
+    bboard::Move id = bboard::Move::IDLE;
+    bboard::Move m[4] = {id, id, id, id};
+    bboard::Position destBombs[bboard::MAX_BOMBS];
+    bboard::util::CellIndex<bboard::BOARD_SIZE, bboard::AGENT_COUNT> cells;
+
+    SECTION("Agent That Didn't Move")
+    {
+        // the agent on the origin of a stationary agent is the agent
+        // itself, the chain has to end there
+        s->PutAgentsInCorners(0, 1, 2, 3);
+        m[0] = bboard::Move::BOMB;
+
+        bboard::Position p = bboard::util::AgentBombChainReversion(*s.get(), m, destBombs, cells, 0);
+        REQUIRE_POS(p, 0, 0);
+        REQUIRE(s->board[0][0] == bboard::Item::AGENT0);
+    }
+    SECTION("Index Follows The Chain")
+    {
+        // agent 1 followed agent 0 to the right
+        s->PutAgent(1, 5, 0);
+        s->PutAgent(2, 5, 1);
+        s->PutAgent(9, 9, 2);
+        s->PutAgent(9, 1, 3);
+        m[0] = m[1] = bboard::Move::RIGHT;
+
+        bboard::Position p = bboard::util::AgentBombChainReversion(*s.get(), m, destBombs, cells, 1);
+        REQUIRE_POS(p, 0, 5);
+        REQUIRE_POS(s->agents[0].GetPos(), 0, 5);
+        REQUIRE_POS(s->agents[1].GetPos(), 1, 5);
+        for(int y = 0; y < bboard::BOARD_SIZE; y++)
+        {
+            for(int x = 0; x < bboard::BOARD_SIZE; x++)
+            {
+                REQUIRE(cells.Agent(*s.get(), {x, y}) == s->GetAgent(x, y));
+            }
+        }
+    }
+}
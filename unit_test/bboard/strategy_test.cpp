@@ -107,3 +107,99 @@ TEST_CASE("Move Towards Methods", "[strategy]")
         REQUIRE(m2 == Move::DOWN);
     }
 }
+
+/**
+ * @brief REQUIRE_SAME_BOARD Compares the board and agents of two states
+ */
+void REQUIRE_SAME_BOARD(const State& a, const State& b)
+{
+    for(int y = 0; y < BOARD_SIZE; y++)
+    {
+        for(int x = 0; x < BOARD_SIZE; x++)
+        {
+            REQUIRE(a.board[y][x] == b.board[y][x]);
+        }
+    }
+    for(int i = 0; i < AGENT_COUNT; i++)
+    {
+        REQUIRE(a.agents[i].x == b.agents[i].x);
+        REQUIRE(a.agents[i].y == b.agents[i].y);
+        REQUIRE(a.agents[i].dead == b.agents[i].dead);
+        REQUIRE(a.agents[i].bombCount == b.agents[i].bombCount);
+    }
+    REQUIRE(a.bombs.count == b.bombs.count);
+}
+
+TEST_CASE("Move Masks", "[strategy]")
+{
+    auto s = std::make_unique<State>();
+
+    SECTION("Legal Moves")
+    {
+        s->PutAgentsInCorners(0, 1, 2, 3);
+        s->PutItem(1, 0, Item::RIGID);
+        s->PutItem(9, 0, Item::WOOD);
+        s->SpawnFlame(10, 2, 1);
+        s->agents[2].bombCount = s->agents[2].maxBombCount;
+        s->Kill(3);
+
+        strategy::MoveMask legal[AGENT_COUNT];
+        strategy::LegalMoves(*s.get(), legal);
+
+        using strategy::MoveBit;
+        REQUIRE(legal[0] == (MoveBit(Move::IDLE) | MoveBit(Move::DOWN) | MoveBit(Move::BOMB)));
+        REQUIRE(legal[1] == (MoveBit(Move::IDLE) | MoveBit(Move::DOWN) | MoveBit(Move::BOMB)));
+        REQUIRE(legal[2] == (MoveBit(Move::IDLE) | MoveBit(Move::UP) | MoveBit(Move::LEFT)));
+        REQUIRE(legal[3] == MoveBit(Move::IDLE));
+
+        strategy::MoveMask nonFatal[AGENT_COUNT];
+        strategy::Timeline t;
+        strategy::ProjectState(*s.get(), t);
+        strategy::NonFatalMoves(*s.get(), t, legal, nonFatal);
+
+        REQUIRE(nonFatal[0] == legal[0]);
+        REQUIRE(nonFatal[1] == (MoveBit(Move::IDLE) | MoveBit(Move::BOMB)));
+    }
+    SECTION("Illegal Moves Are Idle")
+    {
+        std::mt19937 rng(0x1337);
+        InitState(s.get(), 0, 1, 2, 3);
+
+        for(int t = 0; t < 100 && s->aliveAgents > 1; t++)
+        {
+            strategy::MoveMask legal[AGENT_COUNT];
+            strategy::LegalMoves(*s.get(), legal);
+
+            Move m[AGENT_COUNT];
+            for(int i = 0; i < AGENT_COUNT; i++)
+            {
+                do
+                {
+                    m[i] = Move(rng() % 6);
+                }
+                while(!strategy::HasMove(legal[i], m[i]));
+            }
+
+            for(int i = 0; i < AGENT_COUNT; i++)
+            {
+                for(int k = 1; k < 6; k++)
+                {
+                    if(strategy::HasMove(legal[i], Move(k))) continue;
+
+                    auto a = std::make_unique<State>(*s.get());
+                    auto b = std::make_unique<State>(*s.get());
+                    Move ma[AGENT_COUNT], mb[AGENT_COUNT];
+                    std::copy(m, m + AGENT_COUNT, ma);
+                    std::copy(m, m + AGENT_COUNT, mb);
+                    ma[i] = Move(k);
+                    mb[i] = Move::IDLE;
+
+                    Step(a.get(), ma);
+                    Step(b.get(), mb);
+                    REQUIRE_SAME_BOARD(*a.get(), *b.get());
+                }
+            }
+            Step(s.get(), m);
+        }
+    }
+}
@@ -0,0 +1,167 @@
+#include <random>
+#include <cstdlib>
+
+#include "catch.hpp"
+#include "bboard.hpp"
+#include "symmetry.hpp"
+#include "step_utility.hpp"
+
+using namespace bboard;
+
+namespace
+{
+
+/**
+ * @brief FlameMayReachBomb True if a bomb exploded in the flame range
+ * of another one (walls and wood are ignored), i.e. the step may have
+ * been a chain reaction
+ */
+bool FlameMayReachBomb(const StepEvents& events)
+{
+    for(int a = 0; a < events.count; a++)
+    {
+        const Event& e = events.events[a];
+        if(e.type != EventType::BOMB_EXPLODED)
+        {
+            continue;
+        }
+        for(int b = 0; b < events.count; b++)
+        {
+            const Position p = events.events[b].position;
+            if(a == b || events.events[b].type != EventType::BOMB_EXPLODED)
+            {
+                continue;
+            }
+            if((p.x == e.position.x && std::abs(p.y - e.position.y) <= e.value)
+                    || (p.y == e.position.y && std::abs(p.x - e.position.x) <= e.value))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+}
+
+TEST_CASE("Dihedral Transforms", "[symmetry]")
+{
+    SECTION("Moves Follow Positions")
+    {
+        for(int t = 0; t < SYMMETRY_COUNT; t++)
+        {
+            const Position p = {3, 5};
+            const Position q = TransformPosition<BOARD_SIZE>(t, p);
+            REQUIRE(TransformPosition<BOARD_SIZE>(InverseTransform(t), q) == p);
+            for(Move m : {Move::IDLE, Move::UP, Move::DOWN, Move::LEFT, Move::RIGHT, Move::BOMB})
+            {
+                const Position moved = util::DesiredPosition(p.x, p.y, m);
+                const Position r = util::DesiredPosition(q.x, q.y, TransformMove(t, m));
+                REQUIRE(r == TransformPosition<BOARD_SIZE>(t, moved));
+                REQUIRE(TransformMove(InverseTransform(t), TransformMove(t, m)) == m);
+            }
+        }
+    }
+    SECTION("Step Commutes With The Transforms")
+    {
+        std::mt19937 rng(17);
+        std::uniform_int_distribution<int> moveDist(0, 5);
+        auto s = std::make_unique<State>();
+        auto u = std::make_unique<State>();
+        auto v = std::make_unique<State>();
+        auto w = std::make_unique<State>();
+        int checked = 0, chains = 0;
+        for(int game = 0; game < 40; game++)
+        {
+            *s.get() = State();
+            InitBoardItems(*s.get(), game);
+            s->PutAgentsInCorners(0, 1, 2, 3);
+            // the second half of the games with kickers and stronger bombs
+            for(int i = 0; i < AGENT_COUNT && game % 2 == 1; i++)
+            {
+                s->agents[i].canKick = true;
+                s->agents[i].maxBombCount = 3;
+                s->agents[i].bombStrength = 2 + (game + i) % 3;
+            }
+            for(int k = 0; k < 120 && s->aliveAgents > 1; k++)
+            {
+                Move m[AGENT_COUNT], tm[AGENT_COUNT];
+                for(int i = 0; i < AGENT_COUNT; i++)
+                {
+                    m[i] = Move(moveDist(rng));
+                }
+                *v.get() = *s.get();
+                Move copy[AGENT_COUNT];
+                std::copy_n(m, AGENT_COUNT, copy);
+                StepEvents events;
+                Step(v.get(), copy, &events);
+
+                // chain reactions depend on the orientation (see TransformState)
+                if(FlameMayReachBomb(events))
+                {
+                    chains++;
+                }
+                else
+                {
+                    for(int t = 1; t < SYMMETRY_COUNT; t++)
+                    {
+                        // T(Step(s, m)) == Step(T(s), T(m))
+                        TransformState(*s.get(), *u.get(), t);
+                        for(int i = 0; i < AGENT_COUNT; i++)
+                        {
+                            tm[i] = TransformMove(t, m[i]);
+                        }
+                        Step(u.get(), tm);
+                        TransformState(*v.get(), *w.get(), t);
+                        REQUIRE(EqualStates(*u.get(), *w.get()));
+                    }
+                    checked++;
+                }
+                Step(s.get(), m);
+
+                // the inverse restores the state
+                const int t = k % SYMMETRY_COUNT;
+                TransformState(*s.get(), *u.get(), t);
+                TransformState(*u.get(), *v.get(), InverseTransform(t));
+                REQUIRE(EqualStates(*s.get(), *v.get()));
+            }
+        }
+        REQUIRE(chains > 0);
+        REQUIRE(checked > 20 * chains);
+    }
+    SECTION("Canonical Hash")
+    {
+        auto s = std::make_unique<State>();
+        auto u = std::make_unique<State>();
+        Move m[AGENT_COUNT] = {Move::BOMB, Move::RIGHT, Move::DOWN, Move::IDLE};
+        InitState(s.get(), 0, 1, 2, 3);
+        Step(s.get(), m);
+
+        const uint64_t h = CanonicalHash(*s.get());
+        for(int t = 0; t < SYMMETRY_COUNT; t++)
+        {
+            TransformState(*s.get(), *u.get(), t);
+            int c;
+            REQUIRE(CanonicalHash(*u.get(), &c) == h);
+
+            // the canonical transform leads to the same state
+            auto a = std::make_unique<State>(), b = std::make_unique<State>();
+            TransformState(*u.get(), *a.get(), c);
+            TransformState(*s.get(), *b.get(), CanonicalTransform(*s.get()));
+            REQUIRE(EqualStates(*a.get(), *b.get()));
+        }
+
+        // a symmetric board: only the agents tell the transforms apart
+        auto e = std::make_unique<State>();
+        e->PutAgent(1, 1, 0);
+        e->PutAgent(9, 9, 1);
+        e->Kill(2, 3);
+        const uint64_t g = CanonicalHash(*e.get());
+        for(int t = 0; t < SYMMETRY_COUNT; t++)
+        {
+            TransformState(*e.get(), *u.get(), t);
+            REQUIRE(CanonicalHash(*u.get()) == g);
+        }
+        REQUIRE(g != h);
+    }
+}
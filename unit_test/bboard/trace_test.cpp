@@ -0,0 +1,151 @@
+#include <thread>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+
+#include "catch.hpp"
+#include "bboard.hpp"
+#include "agents.hpp"
+#include "trace.hpp"
+
+using namespace bboard;
+
+namespace
+{
+
+std::string ReadFile(const std::string& path)
+{
+    std::ifstream in(path);
+    std::stringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+int Occurrences(const std::string& text, const std::string& word)
+{
+    int n = 0;
+    for(size_t i = text.find(word); i != std::string::npos; i = text.find(word, i + 1))
+    {
+        n++;
+    }
+    return n;
+}
+
+}
+
+TEST_CASE("Trace Export", "[trace]")
+{
+    const std::string path = "trace_test.json";
+
+    SECTION("Environment Timeline")
+    {
+        agents::SimpleAgent a[AGENT_COUNT];
+        Environment env;
+        env.MakeGame({&a[0], &a[1], &a[2], &a[3]});
+
+        REQUIRE(trace::Start(path, trace::AGENTS | trace::ENVIRONMENT));
+        REQUIRE(!trace::Start(path));
+        int acts = 0;
+        for(int t = 0; t < 10; t++)
+        {
+            acts += env.GetState().aliveAgents;
+            env.Step();
+        }
+        // the engine isn't traced
+        Move m[AGENT_COUNT] = {};
+        State s = env.GetState();
+        Step(&s, m);
+
+        const trace::TraceCounters c = trace::GetTraceCounters();
+        REQUIRE(trace::Stop());
+        REQUIRE(!trace::Stop());
+        REQUIRE(c.events == uint64_t(acts + 10));
+        REQUIRE(c.dropped == 0);
+        REQUIRE(c.threads == 1);
+
+        const std::string json = ReadFile(path);
+        REQUIRE(json.find("{\"traceEvents\": [") == 0);
+        REQUIRE(Occurrences(json, "\"name\": \"Agent::act\"") == acts);
+        REQUIRE(Occurrences(json, "\"name\": \"Environment::Step\"") == 10);
+        REQUIRE(Occurrences(json, "\"args\": {\"agent\": 3}") >= 1);
+        REQUIRE(Occurrences(json, "\"name\": \"Step\"") == 0);
+        REQUIRE(json.find("\"dropped\": 0") != std::string::npos);
+    }
+    SECTION("Step Phases")
+    {
+        auto s = std::make_unique<State>();
+        InitState(s.get(), 0, 1, 2, 3);
+        Move m[AGENT_COUNT] = {};
+
+        REQUIRE(trace::Start(path, trace::ENGINE));
+        Step(s.get(), m);
+        REQUIRE(trace::Stop());
+
+        const std::string json = ReadFile(path);
+        if(!trace::ENGINE_SPANS)
+        {
+            REQUIRE(Occurrences(json, "\"cat\": \"engine\"") == 0);
+            return;
+        }
+        // without bombs the explosion is skipped
+        for(const char* phase : {"Step", "Flames", "Bomb Timers", "Player Movement", "Bomb Movement"})
+        {
+            INFO(phase);
+            REQUIRE(Occurrences(json, "\"name\": \"" + std::string(phase) + "\"") == 1);
+        }
+        REQUIRE(Occurrences(json, "\"name\": \"Explosion\"") == 0);
+        REQUIRE(Occurrences(json, "\"cat\": \"engine\"") == 5);
+    }
+    SECTION("Threads")
+    {
+        const int threadCount = 8, spans = 1000;
+        REQUIRE(trace::Start(path, trace::ALL));
+        std::vector<std::thread> threads;
+        for(int t = 0; t < threadCount; t++)
+        {
+            threads.emplace_back([t]()
+            {
+                for(int k = 0; k < spans; k++)
+                {
+                    trace::Span span(trace::AGENTS, "Span", t);
+                }
+            });
+        }
+        for(std::thread& t : threads)
+        {
+            t.join();
+        }
+
+        const trace::TraceCounters c = trace::GetTraceCounters();
+        REQUIRE(trace::Stop());
+        REQUIRE(c.events == uint64_t(threadCount * spans));
+        REQUIRE(c.threads == uint64_t(threadCount));
+        const std::string json = ReadFile(path);
+        for(int t = 0; t < threadCount; t++)
+        {
+            REQUIRE(Occurrences(json, "\"args\": {\"agent\": " + std::to_string(t) + "}") == spans);
+        }
+    }
+    SECTION("Full Trace")
+    {
+        REQUIRE(trace::Start(path, trace::ENGINE, 256));
+        for(int k = 0; k < 1000; k++)
+        {
+            trace::Span span(trace::ENGINE, "Span");
+        }
+        REQUIRE(trace::Stop());
+
+        const trace::TraceCounters c = trace::GetTraceCounters();
+        REQUIRE(c.events == 256);
+        REQUIRE(c.dropped == 1000 - 256);
+        REQUIRE(ReadFile(path).find("\"dropped\": 744") != std::string::npos);
+    }
+    SECTION("Invalid Path")
+    {
+        REQUIRE(!trace::Start("does/not/exist/trace.json"));
+        REQUIRE(!trace::IsTracing(trace::ENGINE));
+    }
+    std::remove(path.c_str());
+}
@@ -0,0 +1,195 @@
+#include <thread>
+#include <vector>
+#include <atomic>
+
+#include "catch.hpp"
+#include "bboard.hpp"
+#include "transposition.hpp"
+#include "duct.hpp"
+#include "symmetry.hpp"
+
+using namespace bboard;
+using search::TTData;
+using search::TranspositionTable;
+
+namespace
+{
+
+/**
+ * @brief SameBucket The k-th key that shares the bucket of key 0
+ */
+uint64_t SameBucket(const TranspositionTable& t, int k)
+{
+    return (uint64_t(k) * t.GetEntryCount() / TranspositionTable::BUCKET_SIZE) << 16 | uint64_t(k);
+}
+
+}
+
+TEST_CASE("Transposition Table", "[search]")
+{
+    SECTION("Store And Probe")
+    {
+        TranspositionTable t(1);
+        REQUIRE(t.GetSize() == (size_t(1) << 20));
+
+        TTData d;
+        d.value = -0.25f;
+        d.count = 7;
+        d.move = Move::BOMB;
+        t.Store(12345, d);
+
+        TTData r;
+        REQUIRE(t.Probe(12345, r));
+        REQUIRE(r.value == Approx(-0.25f).margin(1e-4));
+        REQUIRE(r.count == 7);
+        REQUIRE(r.move == Move::BOMB);
+        REQUIRE(!t.Probe(12346, r));
+
+        t.AddSample(99, 1.0f);
+        r = t.AddSample(99, 0.0f);
+        REQUIRE(r.count == 2);
+        REQUIRE(r.value == Approx(0.5f).margin(1e-4));
+
+        search::TTCounters c = t.GetCounters();
+        REQUIRE(c.probes == 4);
+        REQUIRE(c.hits == 2);
+        REQUIRE(c.stores == 3);
+        REQUIRE(c.collisions == 0);
+
+        t.Clear();
+        REQUIRE(!t.Probe(12345, r));
+        REQUIRE(t.GetCounters().probes == 1);
+    }
+    SECTION("Replacement")
+    {
+        for(search::Replacement p : {search::Replacement::COUNT, search::Replacement::AGING})
+        {
+            TranspositionTable t(1, p);
+            TTData d;
+            for(int k = 0; k < TranspositionTable::BUCKET_SIZE; k++)
+            {
+                d.count = 10 + k;
+                t.Store(SameBucket(t, k), d);
+            }
+            if(p == search::Replacement::AGING)
+            {
+                // an old entry goes first, even if it holds more samples
+                t.NewGeneration();
+                d.count = 100;
+                for(int k = 0; k < TranspositionTable::BUCKET_SIZE - 1; k++)
+                {
+                    t.Store(SameBucket(t, k), d);
+                }
+            }
+            d.count = 1;
+            t.Store(SameBucket(t, 9), d);
+
+            TTData r;
+            const int evicted = p == search::Replacement::COUNT ? 0 : TranspositionTable::BUCKET_SIZE - 1;
+            REQUIRE(t.Probe(SameBucket(t, 9), r));
+            REQUIRE(!t.Probe(SameBucket(t, evicted), r));
+            REQUIRE(t.GetCounters().collisions == 1);
+        }
+    }
+    SECTION("Concurrent Access")
+    {
+        // every key stores a count that is derived from it, a torn
+        // entry must never be accepted
+        TranspositionTable t(1, search::Replacement::ALWAYS);
+        const int threads = 4;
+        std::atomic<int> wrong(0);
+        std::vector<std::thread> workers;
+        for(int w = 0; w < threads; w++)
+        {
+            workers.emplace_back([&t, &wrong, w]
+            {
+                uint64_t x = 0x1234567 + w;
+                TTData d, r;
+                for(int k = 0; k < 200000; k++)
+                {
+                    x ^= x << 13;
+                    x ^= x >> 7;
+                    x ^= x << 17;
+                    // few keys, so the threads overwrite each other
+                    const uint64_t key = (x & 0xFFF) * 0x9E3779B97F4A7C15ULL;
+                    d.count = int(key >> 48);
+                    d.value = float(key & 0xFF) / 255.0f;
+                    if(k & 1)
+                    {
+                        t.Store(key, d);
+                    }
+                    else if(t.Probe(key, r) && (r.count != int(key >> 48)
+                                                || r.value != Approx(float(key & 0xFF) / 255.0f).margin(1e-4)))
+                    {
+                        wrong++;
+                    }
+                }
+            });
+        }
+        for(std::thread& w : workers)
+        {
+            w.join();
+        }
+        REQUIRE(wrong == 0);
+        REQUIRE(t.GetCounters().probes == threads * 100000);
+        REQUIRE(t.GetCounters().hits > 0);
+    }
+    SECTION("Shared By Searches")
+    {
+        auto s = std::make_unique<State>();
+        InitState(s.get(), 0, 1, 2, 3);
+        TranspositionTable t(4);
+        search::DecoupledUCT a(1 << 12, 1), b(1 << 12, 2);
+        a.transpositions = &t;
+        b.transpositions = &t;
+
+        a.Search(*s.get(), 1000);
+        const uint64_t hits = t.GetCounters().hits;
+        b.Search(*s.get(), 1000);
+        REQUIRE(t.GetCounters().hits > hits);
+        REQUIRE(b.GetRoot().visits == 1000);
+    }
+    SECTION("Symmetric Positions Share Entries")
+    {
+        auto s = std::make_unique<State>();
+        auto u = std::make_unique<State>();
+        InitState(s.get(), 0, 1, 2, 3);
+        TransformState(*s.get(), *u.get(), 5);
+
+        uint64_t hits[2];
+        for(bool merge : {false, true})
+        {
+            TranspositionTable t(4);
+            search::DecoupledUCT a(1 << 12, 1), b(1 << 12, 1);
+            for(search::DecoupledUCT* d : {&a, &b})
+            {
+                d->transpositions = &t;
+                d->mergeSymmetries = merge;
+            }
+            a.Search(*s.get(), 500);
+            const uint64_t before = t.GetCounters().hits;
+            b.Search(*u.get(), 500);
+            hits[merge] = t.GetCounters().hits - before;
+        }
+        REQUIRE(hits[1] > hits[0]);
+
+        // the approximate entries don't answer exact lookups
+        uint64_t exactHits[2];
+        for(bool merged : {false, true})
+        {
+            TranspositionTable t(4);
+            search::DecoupledUCT a(1 << 12, 1), b(1 << 12, 1);
+            a.transpositions = &t;
+            a.mergeSymmetries = true;
+            b.transpositions = &t;
+            if(merged)
+            {
+                a.Search(*s.get(), 500);
+            }
+            const uint64_t before = t.GetCounters().hits;
+            b.Search(*s.get(), 500);
+            exactHits[merged] = t.GetCounters().hits - before;
+        }
+        REQUIRE(exactHits[1] == exactHits[0]);
+    }
+}
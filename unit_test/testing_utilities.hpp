@@ -49,4 +49,25 @@ type_name()
 #endif
 }
 
+/**
+ * @brief PrepareDeadEnd Traps agent 0 in a dead end next to its own
+ * bomb (5 steps left), the only way out is two cells to the right
+ */
+inline void PrepareDeadEnd(bboard::State& s)
+{
+    using namespace bboard;
+    Move m[AGENT_COUNT] = {Move::BOMB, Move::IDLE, Move::IDLE, Move::IDLE};
+    s.Kill(2, 3);
+    s.PutAgent(0, 0, 0);
+    s.PutAgent(10, 10, 1);
+    s.board[1][0] = Item::RIGID;
+    s.board[1][1] = Item::RIGID;
+    Step(&s, m);
+    m[0] = Move::IDLE;
+    for(int i = 0; i < 5; i++)
+    {
+        Step(&s, m);
+    }
+}
+
 #endif // TESTING_UTILITIES_HPP